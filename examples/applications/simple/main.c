@@ -55,10 +55,10 @@ int main( int argc, char *argv[] ) {
 	ts_service_set_client_cert( service, client_cert, sizeof( client_cert ) );
 	ts_service_set_client_key( service, client_key, sizeof( client_key ) );
 
-	// connect to thingspace server
+	// connect to thingspace server, the connection completes in the run-loop
 	ts_status_debug( "simple: initializing connection,...\n");
 	TsStatus_t status = ts_service_dial( service, hostname_and_port );
-	if( status != TsStatusOk ) {
+	if( status != TsStatusOk && status != TsStatusOkTrying ) {
 		ts_status_debug("simple: failed to dial, %s\n", ts_status_string(status));
 		ts_platform_assert(0);
 	}
@@ -93,7 +93,7 @@ int main( int argc, char *argv[] ) {
 		// note - this will run continuously until the interval is complete
 		//        other options include limiting the interval, and sleeping after
 		status = ts_service_tick( service, interval );
-		if( status != TsStatusOk ) {
+		if( status != TsStatusOk && status != TsStatusOkTrying ) {
 			ts_status_debug( "simple: failed to perform tick, %s, shutting down,...\n", ts_status_string(status) );
 			running = false;
 		}
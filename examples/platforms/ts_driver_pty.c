@@ -0,0 +1,263 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include "ts_driver.h"
+
+// a driver to a modem stand-in on a unix pseudo-terminal (e.g., scripts/monarch_standin.py), i.e., the
+// bytes written and read are the modem AT commands and responses, which are handed to the controller by
+// a reader thread in place of the uart receive interrupt of the embedded platforms
+#if defined(TS_DRIVER_PTY)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ts_platform.h"
+
+// the terminal device, set at run-time by the TS_DRIVER_PTY_DEVICE environment variable
+#ifndef TS_DRIVER_PTY_DEVICE
+#define TS_DRIVER_PTY_DEVICE "/tmp/monarch"
+#endif
+
+// the largest read handed to the reader, and the interval the reader thread checks for shutdown
+#define TS_DRIVER_PTY_READ_SIZE 256
+#define TS_DRIVER_PTY_POLL_MSEC 10
+
+// the time the terminal is held closed on reset, i.e., the stand-in power cycles the modem when it sees the hangup
+#define TS_DRIVER_PTY_RESET_USEC (100 * TS_TIME_MSEC_TO_USEC)
+
+static TsStatus_t ts_create( TsDriverRef_t * );
+static TsStatus_t ts_destroy( TsDriverRef_t );
+static TsStatus_t ts_tick( TsDriverRef_t, uint32_t );
+
+static TsStatus_t ts_connect( TsDriverRef_t, TsAddress_t );
+static TsStatus_t ts_disconnect( TsDriverRef_t );
+static TsStatus_t ts_read( TsDriverRef_t, const uint8_t *, size_t *, uint32_t );
+static TsStatus_t ts_reader( TsDriverRef_t, void *, TsDriverReader_t );
+static TsStatus_t ts_write( TsDriverRef_t, const uint8_t *, size_t *, uint32_t );
+static void ts_reset( TsDriverRef_t );
+
+TsDriverVtable_t ts_driver_pty = {
+	.create = ts_create,
+	.destroy = ts_destroy,
+	.tick = ts_tick,
+
+	.connect = ts_connect,
+	.disconnect = ts_disconnect,
+	.read = ts_read,
+	.reader = ts_reader,
+	.write = ts_write,
+	.reset = ts_reset,
+};
+
+const TsDriverVtable_t * ts_driver = &ts_driver_pty;
+
+typedef struct TsDriverPty * TsDriverPtyRef_t;
+typedef struct TsDriverPty {
+
+	TsDriver_t _driver;
+
+	int _fd;
+	pthread_t _thread;
+	volatile bool _running;
+
+} TsDriverPty_t;
+
+static void * ts_receive( void * data ) {
+
+	TsDriverPtyRef_t pty = (TsDriverPtyRef_t) data;
+	uint8_t buffer[ TS_DRIVER_PTY_READ_SIZE ];
+	while( pty->_running ) {
+
+		struct pollfd fds = { .fd = pty->_fd, .events = POLLIN };
+		if( poll( &fds, 1, TS_DRIVER_PTY_POLL_MSEC ) <= 0 || !( fds.revents & POLLIN ) ) {
+			continue;
+		}
+		ssize_t size = read( pty->_fd, buffer, sizeof( buffer ) );
+		if( size > 0 && pty->_driver._reader != NULL ) {
+			pty->_driver._reader( (TsDriverRef_t) pty, pty->_driver._reader_state, buffer, (size_t) size );
+		}
+	}
+	return NULL;
+}
+
+static TsStatus_t ts_open( TsDriverPtyRef_t pty ) {
+
+	const char * device = getenv( "TS_DRIVER_PTY_DEVICE" );
+	if( device == NULL ) {
+		device = TS_DRIVER_PTY_DEVICE;
+	}
+	pty->_fd = open( device, O_RDWR | O_NOCTTY | O_NONBLOCK );
+	if( pty->_fd < 0 ) {
+		ts_status_alarm( "ts_driver_pty: failed to open %s, %s\n", device, strerror( errno ) );
+		return TsStatusErrorNotFound;
+	}
+
+	// raw bytes, i.e., no echo or line discipline between the controller and the modem
+	struct termios settings;
+	if( tcgetattr( pty->_fd, &settings ) == 0 ) {
+		cfmakeraw( &settings );
+		tcsetattr( pty->_fd, TCSANOW, &settings );
+	}
+
+	pty->_running = true;
+	if( pthread_create( &( pty->_thread ), NULL, ts_receive, pty ) != 0 ) {
+		pty->_running = false;
+		close( pty->_fd );
+		pty->_fd = -1;
+		return TsStatusErrorNoResourceAvailable;
+	}
+	return TsStatusOk;
+}
+
+static void ts_close( TsDriverPtyRef_t pty ) {
+
+	if( pty->_fd < 0 ) {
+		return;
+	}
+	pty->_running = false;
+	pthread_join( pty->_thread, NULL );
+	close( pty->_fd );
+	pty->_fd = -1;
+}
+
+static TsStatus_t ts_create( TsDriverRef_t * driver ) {
+
+	ts_status_trace( "ts_driver_create: pty\n" );
+	ts_platform_assert( ts_platform != NULL );
+	ts_platform_assert( driver != NULL );
+
+	TsDriverPtyRef_t pty = (TsDriverPtyRef_t) ts_platform_malloc( sizeof( TsDriverPty_t ) );
+	if( pty == NULL ) {
+		*driver = NULL;
+		return TsStatusErrorOutOfMemory;
+	}
+	memset( pty, 0x00, sizeof( TsDriverPty_t ) );
+	pty->_fd = -1;
+	pty->_driver._spec_budget = 60 * TS_TIME_SEC_TO_USEC;
+	pty->_driver._spec_mtu = 1500;
+
+	TsStatus_t status = ts_open( pty );
+	if( status != TsStatusOk ) {
+		ts_platform_free( pty, sizeof( TsDriverPty_t ) );
+		*driver = NULL;
+		return status;
+	}
+
+	*driver = (TsDriverRef_t) pty;
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_destroy( TsDriverRef_t driver ) {
+
+	ts_status_trace( "ts_driver_destroy\n" );
+	ts_platform_assert( ts_platform != NULL );
+	ts_platform_assert( driver != NULL );
+
+	TsDriverPtyRef_t pty = (TsDriverPtyRef_t) driver;
+	ts_close( pty );
+	ts_platform_free( pty, sizeof( TsDriverPty_t ) );
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_tick( TsDriverRef_t driver, uint32_t budget ) {
+
+	ts_status_trace( "ts_driver_tick\n" );
+	ts_platform_assert( driver != NULL );
+
+	return TsStatusOk;
+}
+
+// the socket is managed by the modem (i.e., the AT commands of the controller), the terminal only carries the bytes
+static TsStatus_t ts_connect( TsDriverRef_t driver, TsAddress_t address ) {
+
+	ts_status_trace( "ts_driver_connect\n" );
+	ts_platform_assert( driver != NULL );
+
+	return TsStatusErrorNotImplemented;
+}
+
+static TsStatus_t ts_disconnect( TsDriverRef_t driver ) {
+
+	ts_status_trace( "ts_driver_disconnect\n" );
+	ts_platform_assert( driver != NULL );
+
+	return TsStatusErrorNotImplemented;
+}
+
+static TsStatus_t ts_read( TsDriverRef_t driver, const uint8_t * buffer, size_t * buffer_size, uint32_t budget ) {
+
+	ts_status_trace( "ts_driver_read\n" );
+	ts_platform_assert( driver != NULL );
+
+	return TsStatusErrorNotImplemented;
+}
+
+static TsStatus_t ts_reader( TsDriverRef_t driver, void * state, TsDriverReader_t reader ) {
+
+	ts_status_trace( "ts_driver_reader\n" );
+	ts_platform_assert( driver != NULL );
+
+	driver->_reader_state = state;
+	driver->_reader = reader;
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_write( TsDriverRef_t driver, const uint8_t * buffer, size_t * buffer_size, uint32_t budget ) {
+
+	ts_status_trace( "ts_driver_write\n" );
+	ts_platform_assert( driver != NULL );
+	ts_platform_assert( buffer != NULL );
+	ts_platform_assert( buffer_size != NULL );
+
+	TsDriverPtyRef_t pty = (TsDriverPtyRef_t) driver;
+	if( pty->_fd < 0 ) {
+		*buffer_size = 0;
+		return TsStatusErrorNotOpen;
+	}
+
+	// write all of the bytes, waiting on the terminal (within the budget) when its buffer is full
+	size_t written = 0;
+	uint64_t timestamp = ts_platform_time();
+	while( written < *buffer_size ) {
+
+		ssize_t size = write( pty->_fd, buffer + written, *buffer_size - written );
+		if( size > 0 ) {
+			written = written + (size_t) size;
+			continue;
+		}
+		if( size < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+			*buffer_size = written;
+			return TsStatusErrorConnectionReset;
+		}
+		uint64_t elapsed = ts_platform_time() - timestamp;
+		if( elapsed >= budget ) {
+			*buffer_size = written;
+			return written > 0 ? TsStatusErrorExceedTimeBudget : TsStatusOkWritePending;
+		}
+		struct pollfd fds = { .fd = pty->_fd, .events = POLLOUT };
+		poll( &fds, 1, (int) ( ( budget - elapsed ) / TS_TIME_MSEC_TO_USEC ) + 1 );
+	}
+
+	return TsStatusOk;
+}
+
+static void ts_reset( TsDriverRef_t driver ) {
+
+	ts_status_trace( "ts_driver_reset\n" );
+	ts_platform_assert( driver != NULL );
+
+	// power cycle the modem stand-in, i.e., hang up the terminal and reopen it
+	TsDriverPtyRef_t pty = (TsDriverPtyRef_t) driver;
+	ts_close( pty );
+	ts_platform_sleep( TS_DRIVER_PTY_RESET_USEC );
+	ts_open( pty );
+}
+
+#endif // TS_DRIVER_PTY
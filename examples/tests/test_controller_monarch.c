@@ -0,0 +1,121 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_controller.h"
+
+// must compile with,...
+//
+// TS_CONTROLLER_MONARCH
+// TS_DRIVER_PTY
+// opt TS_PLATFORM_UNIX
+//
+// and run against the monarch stand-in, carrying the modem socket to a local echo server, e.g.,
+//
+// socat TCP4-LISTEN:7777,reuseaddr,fork EXEC:cat
+// scripts/monarch_standin.py --latency 20 --chunk 64
+#if defined(TS_CONTROLLER_MONARCH) && defined(TS_DRIVER_PTY)
+
+#define ECHO_ADDRESS "localhost:7777"
+#define ECHO_COUNT 50
+#define ECHO_SIZE 512
+#define ECHO_BUDGET (100 * TS_TIME_MSEC_TO_USEC)
+#define ECHO_TIMEOUT (10 * TS_TIME_SEC_TO_USEC)
+
+int main() {
+
+	ts_status_set_level(TsStatusLevelInfo);
+
+	// create the controller, i.e., reset the modem and wait for network registration
+	uint64_t timestamp = ts_platform_time();
+	TsControllerRef_t controller;
+	TsStatus_t status = ts_controller_create( &controller );
+	if( status != TsStatusOk ) {
+		ts_status_info("failed to create controller, %s\n", ts_status_string(status));
+		return 1;
+	}
+	ts_status_info("modem started in %u usec\n", (uint32_t)( ts_platform_time() - timestamp ));
+
+	status = ts_controller_connect( controller, ECHO_ADDRESS );
+	if( status != TsStatusOk ) {
+		ts_status_info("failed to connect, %s\n", ts_status_string(status));
+		ts_controller_destroy( controller );
+		return 1;
+	}
+
+	// write each payload and read it back, timing the round trip through the AT command path
+	uint8_t payload[ ECHO_SIZE ];
+	uint8_t echo[ ECHO_SIZE ];
+	uint64_t total = 0, longest = 0;
+	int failures = 0;
+	for( int count = 1; count <= ECHO_COUNT; count++ ) {
+
+		for( size_t index = 0; index < ECHO_SIZE; index++ ) {
+			payload[ index ] = (uint8_t)( count + index );
+		}
+
+		timestamp = ts_platform_time();
+		size_t written = 0;
+		while( written < ECHO_SIZE && status == TsStatusOk ) {
+			size_t size = ECHO_SIZE - written;
+			status = ts_controller_write( controller, payload + written, &size, ECHO_BUDGET );
+			if( status == TsStatusOk ) {
+				written = written + size;
+			}
+		}
+
+		// a pending read has returned nothing, wait for the modem (i.e., its receive urc) before trying again
+		size_t read = 0;
+		while( read < ECHO_SIZE && ts_platform_time() - timestamp < ECHO_TIMEOUT ) {
+			size_t size = ECHO_SIZE - read;
+			status = ts_controller_read( controller, echo + read, &size, ECHO_BUDGET );
+			if( status == TsStatusOkReadPending ) {
+				if( ts_controller->wait != NULL ) {
+					ts_controller_wait( controller, ECHO_BUDGET );
+				} else {
+					ts_controller_tick( controller, ECHO_BUDGET );
+				}
+				continue;
+			}
+			if( status != TsStatusOk ) {
+				break;
+			}
+			read = read + size;
+		}
+
+		uint64_t elapsed = ts_platform_time() - timestamp;
+		// the stream is out of step after a failed echo, i.e., the following echoes cannot be compared
+		if( read != ECHO_SIZE || memcmp( payload, echo, ECHO_SIZE ) != 0 ) {
+			ts_status_info("echo %d failed, %u of %u bytes, %s\n", count, (uint32_t)read, ECHO_SIZE, ts_status_string(status));
+			failures = ECHO_COUNT - count + 1;
+			break;
+		}
+		total = total + elapsed;
+		if( elapsed > longest ) {
+			longest = elapsed;
+		}
+	}
+
+	int echoes = ECHO_COUNT - failures;
+	if( echoes > 0 ) {
+		ts_status_info("%d echoes of %u bytes, average %u usec, longest %u usec, %u bytes/sec\n",
+			echoes, ECHO_SIZE, (uint32_t)( total / echoes ), (uint32_t)longest,
+			(uint32_t)( (uint64_t)echoes * ECHO_SIZE * 2 * TS_TIME_SEC_TO_USEC / total ));
+	}
+	ts_status_info("%d failures, %s\n", failures, failures == 0 ? "PASSED" : "FAILED");
+
+	ts_controller_disconnect( controller );
+	ts_controller_destroy( controller );
+
+	return failures == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+
+	ts_status_alarm("missing one or many components, please check compile directives and build again\n");
+
+}
+
+#endif
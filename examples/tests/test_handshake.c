@@ -0,0 +1,128 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_connection.h"
+
+#include "cacert.h"
+#include "client-crt.h"
+#include "client-key.h"
+
+// must compile with,...
+//
+// TS_SECURITY_MBED (certificates) or TS_SECURITY_MBED_PSK (pre-shared key), i.e., build both and compare
+// opt TS_CONTROLLER_SOCKET
+// opt TS_PLATFORM_UNIX
+//
+// the pre-shared key build runs against a local stand-in holding the same key and identity, e.g.,
+//
+// openssl s_server -accept 8443 -nocert -psk 000102030405060708090a0b0c0d0e0f -psk_identity B827EBA15910
+#if defined(TS_SECURITY_MBED) || defined(TS_SECURITY_MBED_PSK)
+
+#define HANDSHAKE_COUNT 5
+#define HANDSHAKE_HOST "simpm.thingspace.verizon.com"
+#define HANDSHAKE_ADDRESS "simpm.thingspace.verizon.com:8883"
+#define HANDSHAKE_PSK_ADDRESS "localhost:8443"
+
+// the test key and identity given to the stand-in above
+static const uint8_t psk[] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+static const char * psk_identity = "B827EBA15910";
+
+int main() {
+
+	ts_status_set_level(TsStatusLevelInfo);
+
+	// create a connection state struct
+	TsConnectionRef_t connection;
+	TsStatus_t status = ts_connection_create( &connection );
+	if( status != TsStatusOk ) {
+		ts_status_info("failed to create connection, %s\n", ts_status_string(status));
+		return 1;
+	}
+
+	// set credentials, and measure full handshakes only
+#if defined(TS_SECURITY_MBED_PSK)
+	const char * mode = "psk";
+	const char * address = HANDSHAKE_PSK_ADDRESS;
+	ts_connection_set_psk( connection, psk, sizeof( psk ) );
+	ts_connection_set_psk_identity( connection, (const uint8_t *)psk_identity, strlen( psk_identity ) );
+#else
+	const char * mode = "certificate";
+	const char * address = HANDSHAKE_ADDRESS;
+	ts_connection_set_server_cert_hostname( connection, HANDSHAKE_HOST );
+	ts_connection_set_server_cert( connection, cacert_buf, sizeof( cacert_buf ) );
+	ts_connection_set_client_cert( connection, client_cert, sizeof( client_cert ) );
+	ts_connection_set_client_key( connection, client_key, sizeof( client_key ) );
+#endif
+	ts_connection_set_resumption( connection, false );
+
+	// connect and disconnect repeatedly, the handshake cost is averaged by the session stats
+	int failures = 0;
+	for( int count = 1; count <= HANDSHAKE_COUNT; count++ ) {
+
+		status = ts_connection_connect( connection, (TsAddress_t)address );
+		if( status != TsStatusOk ) {
+			ts_status_info("handshake %d failed, %s\n", count, ts_status_string(status));
+			failures = failures + 1;
+			continue;
+		}
+
+		TsSecuritySessionStats_t stats;
+		ts_connection_get_session_stats( connection, &stats );
+		ts_status_info("handshake %d, %u bytes, %u usec\n", count, stats.bytes, stats.time);
+		ts_connection_disconnect( connection );
+	}
+
+	TsSecuritySessionStats_t stats;
+	TsSecurityMemoryStats_t memory;
+	ts_connection_get_session_stats( connection, &stats );
+	ts_connection_get_memory_stats( connection, &memory );
+	if( stats.handshakes > 0 ) {
+		ts_status_info("%s handshake, average %u bytes, %u usec over %u handshakes\n", mode,
+			(uint32_t)( stats.handshake_bytes / stats.handshakes ),
+			(uint32_t)( stats.handshake_time / stats.handshakes ),
+			stats.handshakes );
+	}
+	ts_status_info("%s handshake, peak %u bytes, steady %u bytes of memory\n", mode, memory.handshake_peak, memory.steady);
+
+#if !defined(TS_SECURITY_MBED_PSK)
+	// a second connection (e.g., a gateway child) shares the credentials parsed by the first,
+	// i.e., each of its three credentials is a cache hit and none is parsed again
+	TsSecurityCredentialStats_t before, credentials;
+	ts_connection_get_credential_stats( connection, &before );
+	TsConnectionRef_t child;
+	status = ts_connection_create( &child );
+	if( status == TsStatusOk ) {
+		ts_connection_set_server_cert( child, cacert_buf, sizeof( cacert_buf ) );
+		ts_connection_set_client_cert( child, client_cert, sizeof( client_cert ) );
+		ts_connection_set_client_key( child, client_key, sizeof( client_key ) );
+		ts_connection_destroy( child );
+	}
+	ts_connection_get_credential_stats( connection, &credentials );
+	ts_status_info("credentials, %u parsed in %u usec, %u reused, %u bytes of heap\n",
+		credentials.parses, (uint32_t)credentials.parse_time, credentials.hits, credentials.heap);
+	if( status != TsStatusOk || credentials.hits != before.hits + 3 || credentials.parses != before.parses ) {
+		ts_status_info("credentials were not shared, %u hits and %u parses by the second connection\n",
+			credentials.hits - before.hits, credentials.parses - before.parses);
+		failures = failures + 1;
+	}
+#endif
+	ts_status_info("%d failures, %s\n", failures, failures == 0 ? "PASSED" : "FAILED");
+
+	ts_connection_destroy( connection );
+
+	return failures == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+
+	ts_status_alarm("missing one or many components, please check compile directives and build again\n");
+
+}
+
+#endif
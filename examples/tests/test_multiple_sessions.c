@@ -0,0 +1,184 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <stdio.h>
+#include <string.h>
+
+#include "ts_service.h"
+#include "ts_platform.h"
+
+// must compile with,...
+//
+// TS_SERVICE_TS_CBOR
+// TS_TRANSPORT_MQTT
+// TS_SECURITY_NONE
+// opt TS_CONTROLLER_SOCKET
+// opt TS_PLATFORM_UNIX
+//
+// and run against a local broker, e.g.,
+//
+// mosquitto -p 1883
+#if defined(TS_TRANSPORT_MQTT) && defined(TS_SECURITY_NONE)
+
+// several independent sessions in one process, e.g., a gateway speaking for its children
+#define NUM_SESSIONS 3
+#define MESSAGE_COUNT 10
+#define SESSION_ADDRESS "localhost:1883"
+#define SESSION_BUDGET (100 * TS_TIME_MSEC_TO_USEC)
+#define SESSION_TIMEOUT (10 * TS_TIME_SEC_TO_USEC)
+
+// what each session has seen, i.e., on its own topic, and sent by itself alone
+typedef struct {
+	int index;
+	TsTransportRef_t transport;
+	int received;
+	int leaked;
+} SessionState_t;
+
+static TsStatus_t handler( TsTransportRef_t, void *, TsPath_t, const uint8_t *, size_t );
+
+int main() {
+
+	ts_status_set_level(TsStatusLevelInfo);
+
+	TsServiceRef_t services[ NUM_SESSIONS ];
+	SessionState_t states[ NUM_SESSIONS ];
+	for( int index = 0; index < NUM_SESSIONS; index++ ) {
+
+		TsStatus_t status = ts_service_create( &(services[ index ]) );
+		if( status != TsStatusOk ) {
+			ts_status_info("failed to create service %d, %s\n", index, ts_status_string(status));
+			return 1;
+		}
+
+		status = ts_service_dial( services[ index ], SESSION_ADDRESS );
+		if( status != TsStatusOk && status != TsStatusOkTrying ) {
+			ts_status_info("failed to dial service %d, %s\n", index, ts_status_string(status));
+			return 1;
+		}
+	}
+
+	// the sessions connect side by side, each advanced by its own tick
+	bool dialing = true;
+	while( dialing ) {
+
+		dialing = false;
+		for( int index = 0; index < NUM_SESSIONS; index++ ) {
+
+			TsStatus_t status = ts_service_tick( services[ index ], SESSION_BUDGET );
+			if( status == TsStatusOkTrying ) {
+				dialing = true;
+			} else if( status != TsStatusOk ) {
+				ts_status_info("failed to connect service %d, %s\n", index, ts_status_string(status));
+				return 1;
+			}
+		}
+	}
+
+	// each session listens to its own topic, and limits its own traffic (at a different rate than the others)
+	for( int index = 0; index < NUM_SESSIONS; index++ ) {
+
+		states[ index ].index = index;
+		states[ index ].transport = services[ index ]->_transport;
+		states[ index ].received = 0;
+		states[ index ].leaked = 0;
+
+		char topic[ 64 ];
+		snprintf( topic, sizeof( topic ), "ThingspaceSDK/test/session/%d", index );
+		TsStatus_t status = ts_transport_listen( services[ index ]->_transport, NULL, (TsPath_t)topic, handler, &(states[ index ]) );
+		if( status == TsStatusOk ) {
+			status = ts_service_set_rate_limit( services[ index ], 100 * ( index + 1 ), 0, TsRateLimitPolicyDrop );
+		}
+		if( status != TsStatusOk ) {
+			ts_status_info("failed to set up session %d, %s\n", index, ts_status_string(status));
+			return 1;
+		}
+	}
+
+	// each session sends and ticks on its own connection, without affecting the others
+	int failures = 0;
+	for( int count = 1; count <= MESSAGE_COUNT && failures == 0; count++ ) {
+		for( int index = 0; index < NUM_SESSIONS && failures == 0; index++ ) {
+
+			TsMessageRef_t sensors;
+			ts_message_create( &sensors );
+			ts_message_set_int( sensors, "session", index );
+			ts_message_set_int( sensors, "count", count );
+			TsStatus_t status = ts_service_enqueue( services[ index ], sensors );
+			ts_message_destroy( sensors );
+
+			if( status == TsStatusOk ) {
+				char topic[ 64 ];
+				char payload[ 32 ];
+				snprintf( topic, sizeof( topic ), "ThingspaceSDK/test/session/%d", index );
+				snprintf( payload, sizeof( payload ), "%d %d", index, count );
+				status = ts_service_speak( services[ index ], (TsPath_t)topic, (const uint8_t *)payload, strlen( payload ), TsTransportQos1 );
+			}
+			if( status == TsStatusOk ) {
+				status = ts_service_tick( services[ index ], SESSION_BUDGET );
+			}
+			if( status != TsStatusOk ) {
+				ts_status_info("failed to send on session %d, %s\n", index, ts_status_string(status));
+				failures = failures + 1;
+			}
+		}
+	}
+
+	// tick until every session has heard its own messages back (or the time is up)
+	uint64_t timestamp = ts_platform_time();
+	bool waiting = ( failures == 0 );
+	while( waiting && ts_platform_time() - timestamp < SESSION_TIMEOUT ) {
+
+		waiting = false;
+		for( int index = 0; index < NUM_SESSIONS; index++ ) {
+			ts_service_tick( services[ index ], SESSION_BUDGET );
+			if( states[ index ].received < MESSAGE_COUNT ) {
+				waiting = true;
+			}
+		}
+	}
+
+	// nothing crossed between sessions, i.e., neither messages nor the rate limit accounting
+	for( int index = 0; index < NUM_SESSIONS; index++ ) {
+
+		TsRateLimitStats_t stats;
+		ts_service_get_rate_limit_stats( services[ index ], &stats );
+		ts_status_info("session %d, %d received, %d leaked, %u accepted\n",
+			index, states[ index ].received, states[ index ].leaked, stats.accepted);
+		if( states[ index ].received != MESSAGE_COUNT || states[ index ].leaked != 0 || stats.accepted != 2 * MESSAGE_COUNT ) {
+			failures = failures + 1;
+		}
+	}
+	ts_status_info("%d failures, %s\n", failures, failures == 0 ? "PASSED" : "FAILED");
+
+	for( int index = 0; index < NUM_SESSIONS; index++ ) {
+		ts_service_hangup( services[ index ] );
+		ts_service_destroy( services[ index ] );
+	}
+	return failures == 0 ? 0 : 1;
+}
+
+TsStatus_t handler( TsTransportRef_t transport, void * data, TsPath_t path, const uint8_t * buffer, size_t buffer_size ) {
+
+	// a message is counted only by the session (and transport) that sent it
+	SessionState_t * state = (SessionState_t *) data;
+	char payload[ 32 ];
+	size_t size = buffer_size < sizeof( payload ) - 1 ? buffer_size : sizeof( payload ) - 1;
+	memcpy( payload, buffer, size );
+	payload[ size ] = '\0';
+
+	int index = -1, count = 0;
+	if( transport != state->transport || sscanf( payload, "%d %d", &index, &count ) != 2 || index != state->index ) {
+		ts_status_info("session %d heard '%s' on %s\n", state->index, payload, path);
+		state->leaked = state->leaked + 1;
+	} else {
+		state->received = state->received + 1;
+	}
+	return TsStatusOk;
+}
+
+#else
+
+int main() {
+	ts_status_alarm("missing one or many components, please check compile directives and build again\n");
+}
+
+#endif
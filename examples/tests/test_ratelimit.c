@@ -0,0 +1,134 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_ratelimit.h"
+
+// the rate limiter is exercised against a stand-in transport, i.e., no server or connection is
+// required, and the messages handed to the "transport" are only counted
+#define RATELIMIT_PATH "ThingspaceSDK/test/ratelimit"
+
+static int spoken = 0;
+static size_t spoken_bytes = 0;
+static bool broken = false;
+
+static TsStatus_t ts_speak_vector( TsTransportRef_t transport, TsPath_t path, const TsTransportSegment_t * segments, size_t count, TsTransportQos_t qos ) {
+	if( broken ) {
+		return TsStatusErrorConnectionReset;
+	}
+	for( size_t index = 0; index < count; index++ ) {
+		spoken_bytes = spoken_bytes + segments[ index ].buffer_size;
+	}
+	spoken = spoken + 1;
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_speak_qos( TsTransportRef_t transport, TsPath_t path, const uint8_t * buffer, size_t buffer_size, TsTransportQos_t qos ) {
+	TsTransportSegment_t segment;
+	segment.buffer = buffer;
+	segment.buffer_size = buffer_size;
+	return ts_speak_vector( transport, path, &segment, 1, qos );
+}
+
+static TsTransportVtable_t ts_transport_counter = {
+	.speak_vector = ts_speak_vector,
+};
+
+// a transport without the (optional) vector speak
+static TsTransportVtable_t ts_transport_scalar = {
+	.speak_qos = ts_speak_qos,
+};
+
+static int failures = 0;
+
+static void check( bool condition, const char * description ) {
+	if( !condition ) {
+		ts_status_info( "test_ratelimit: failed, %s\n", description );
+		failures = failures + 1;
+	}
+}
+
+int main() {
+
+	ts_status_set_level( TsStatusLevelInfo );
+	ts_transport = &ts_transport_counter;
+
+	TsTransport_t transport;
+	memset( &transport, 0x00, sizeof( TsTransport_t ) );
+	uint8_t payload[ 60 ];
+	memset( payload, 0x55, sizeof( payload ) );
+
+	TsRateLimitRef_t ratelimit;
+	if( ts_ratelimit_create( &ratelimit ) != TsStatusOk ) {
+		ts_status_info( "test_ratelimit: failed to create rate limit\n" );
+		return 1;
+	}
+	TsRateLimitStats_t stats;
+
+	// the message bucket holds one second of traffic, the excess is denied (and dropped)
+	ts_ratelimit_set( ratelimit, 2, 0, TsRateLimitPolicyDrop );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos0 ) == TsStatusOk, "first message denied" );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos0 ) == TsStatusOk, "second message denied" );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos0 ) == TsStatusErrorNoResourceAvailable, "burst exceeded" );
+	ts_ratelimit_get_stats( ratelimit, &stats );
+	check( spoken == 2 && stats.accepted == 2 && stats.dropped == 1 && stats.bytes == 20, "drop accounting" );
+
+	// the bucket refills at the message rate, i.e., a token every half second
+	ts_platform_sleep( 600 * TS_TIME_MSEC_TO_USEC );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos0 ) == TsStatusOk, "refilled message denied" );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos0 ) == TsStatusErrorNoResourceAvailable, "partial refill exceeded" );
+	ts_ratelimit_get_stats( ratelimit, &stats );
+	check( spoken == 3 && stats.accepted == 3 && stats.dropped == 2, "refill accounting" );
+
+	// the byte bucket denies independently of the message bucket
+	ts_ratelimit_set( ratelimit, 0, 100, TsRateLimitPolicyDrop );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 60, TsTransportQos0 ) == TsStatusOk, "bytes within rate denied" );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 60, TsTransportQos0 ) == TsStatusErrorNoResourceAvailable, "byte rate exceeded" );
+	check( spoken == 4 && spoken_bytes == 90, "byte accounting" );
+
+	// an oversized message leaves a debt, which is paid back at the rate before anything else is sent
+	ts_ratelimit_set( ratelimit, 0, 100, TsRateLimitPolicyDrop );
+	uint8_t oversized[ 300 ];
+	memset( oversized, 0x55, sizeof( oversized ) );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, oversized, sizeof( oversized ), TsTransportQos0 ) == TsStatusOk, "oversized message on a full bucket denied" );
+	ts_platform_sleep( 1100 * TS_TIME_MSEC_TO_USEC );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 60, TsTransportQos0 ) == TsStatusErrorNoResourceAvailable, "debt forgiven" );
+	check( spoken == 5 && spoken_bytes == 390, "debt accounting" );
+
+	// queued traffic is held until the bucket refills, and released by tick in order
+	ts_ratelimit_set( ratelimit, 1, 0, TsRateLimitPolicyQueue );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos1 ) == TsStatusOk, "queued policy denied first message" );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos1 ) == TsStatusOkWritePending, "excess not queued" );
+	ts_ratelimit_tick( ratelimit, &transport );
+	ts_ratelimit_get_stats( ratelimit, &stats );
+	check( spoken == 6 && stats.pending == 1 && stats.deferred == 0, "queue released before refill" );
+
+	ts_platform_sleep( 1100 * TS_TIME_MSEC_TO_USEC );
+	ts_ratelimit_tick( ratelimit, &transport );
+	ts_ratelimit_get_stats( ratelimit, &stats );
+	check( spoken == 7 && stats.pending == 0 && stats.deferred == 1, "queue not released after refill" );
+
+	// a queued message the transport keeps failing is dropped, rather than holding back the queue
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos1 ) == TsStatusOkWritePending, "excess not queued" );
+	broken = true;
+	ts_platform_sleep( 1100 * TS_TIME_MSEC_TO_USEC );
+	for( int count = 0; count < TS_RATELIMIT_MAX_RETRIES; count++ ) {
+		ts_ratelimit_tick( ratelimit, &transport );
+	}
+	broken = false;
+	ts_ratelimit_get_stats( ratelimit, &stats );
+	check( spoken == 7 && stats.pending == 0 && stats.dropped == 5, "failing message not dropped" );
+
+	// a transport without speak_vector is still rate limited, via speak_qos
+	ts_transport = &ts_transport_scalar;
+	ts_ratelimit_set( ratelimit, 1, 0, TsRateLimitPolicyDrop );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos1 ) == TsStatusOk, "scalar transport denied" );
+	check( ts_ratelimit_speak( ratelimit, &transport, RATELIMIT_PATH, payload, 10, TsTransportQos1 ) == TsStatusErrorNoResourceAvailable, "scalar transport not limited" );
+	check( spoken == 8, "scalar accounting" );
+	ts_transport = &ts_transport_counter;
+
+	ts_ratelimit_destroy( ratelimit );
+
+	ts_status_info( "test_ratelimit: %d failures, %s\n", failures, failures == 0 ? "PASSED" : "FAILED" );
+	return failures == 0 ? 0 : 1;
+}
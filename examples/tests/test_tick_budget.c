@@ -0,0 +1,112 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include "ts_platform.h"
+#include "ts_transport.h"
+
+#include "cacert.h"
+#include "client-crt.h"
+#include "client-key.h"
+
+// must compile with,...
+//
+// TS_TRANSPORT_MQTT
+// TS_SECURITY_MBED
+// opt TS_CONTROLLER_SOCKET
+// opt TS_PLATFORM_UNIX
+//
+// and run against a local broker stand-in, with the headers above generated from its ca, e.g.,
+//
+// scripts/broker_standin.sh 8883 ./ca.pem ./localhost.cert.pem ./localhost.private.key
+#if defined(TS_TRANSPORT_MQTT) && defined(TS_SECURITY_MBED)
+
+// the tick budget under test, and the overrun tolerated for the last driver call
+#define TICK_BUDGET (100 * TS_TIME_MSEC_TO_USEC)
+#define TICK_TOLERANCE (50 * TS_TIME_MSEC_TO_USEC)
+#define TICK_COUNT 600
+
+#define TICK_HOST "localhost"
+#define TICK_ADDRESS "localhost:8883"
+
+static TsStatus_t handler( TsTransportRef_t transport, void *, TsPath_t path, const uint8_t * buffer, size_t buffer_size );
+
+int main() {
+
+	ts_status_set_level(TsStatusLevelInfo);
+
+	// create mqtt transport
+	TsTransportRef_t transport;
+	TsStatus_t status = ts_transport_create( &transport );
+	if( status != TsStatusOk ) {
+		ts_status_info("failed to create transport, %s\n", ts_status_string(status));
+		return 1;
+	}
+
+	// set connection certs
+	TsConnectionRef_t connection;
+	ts_transport_get_connection( transport, &connection );
+	ts_connection_set_server_cert_hostname( connection, TICK_HOST );
+	ts_connection_set_server_cert( connection, cacert_buf, sizeof( cacert_buf ) );
+	ts_connection_set_client_cert( connection, client_cert, sizeof( client_cert ) );
+	ts_connection_set_client_key( connection, client_key, sizeof( client_key ) );
+
+	// dial without blocking, i.e., the handshake is advanced (and measured) by tick
+	status = ts_transport_dial_start( transport, TICK_ADDRESS );
+	if( status != TsStatusOk && status != TsStatusOkTrying ) {
+		ts_status_info("failed to dial, %s\n", ts_status_string(status));
+		ts_transport_destroy( transport );
+		return 1;
+	}
+
+	TsPath_t subscription = (TsPath_t)"ThingspaceSDK/B827EBA15910/subscription";
+	ts_transport_listen( transport, NULL, subscription, handler, NULL );
+
+	// tick at a fixed budget, speaking now and then, and record the longest tick
+	uint64_t longest = 0;
+	int overruns = 0;
+	for( int count = 1; count <= TICK_COUNT; count++ ) {
+
+		if( count % 10 == 0 ) {
+			char payload[ 256 ];
+			snprintf( payload, sizeof( payload ), "message number %d", count );
+			TsPath_t topic = (TsPath_t)"ThingspaceSDK/B827EBA15910/test";
+			ts_transport_speak_qos( transport, topic, (const uint8_t*)payload, strlen(payload), TsTransportQos1 );
+		}
+
+		uint64_t timestamp = ts_platform_time();
+		status = ts_transport_tick( transport, TICK_BUDGET );
+		uint64_t elapsed = ts_platform_time() - timestamp;
+		if( status != TsStatusOk && status != TsStatusOkTrying ) {
+			ts_status_info("failed to tick, %s\n", ts_status_string(status));
+			break;
+		}
+		if( elapsed > longest ) {
+			longest = elapsed;
+		}
+		if( elapsed > TICK_BUDGET + TICK_TOLERANCE ) {
+			overruns = overruns + 1;
+			ts_status_info("tick %d took %u usec, budget %u usec\n", count, (uint32_t)elapsed, TICK_BUDGET);
+		}
+	}
+
+	// a failed tick, or a dial still trying at the end, is a failure whatever the timing
+	bool passed = ( overruns == 0 && status == TsStatusOk );
+	ts_status_info("longest tick %u usec, budget %u usec, %d overruns, %s\n",
+		(uint32_t)longest, TICK_BUDGET, overruns, passed ? "PASSED" : "FAILED" );
+	ts_transport_hangup( transport );
+	ts_transport_destroy( transport );
+
+	return passed ? 0 : 1;
+}
+
+TsStatus_t handler( TsTransportRef_t transport, void * data, TsPath_t path, const uint8_t * buffer, size_t buffer_size ) {
+	return TsStatusOk;
+}
+
+#else
+
+int main() {
+
+	ts_status_alarm("missing one or many components, please check compile directives and build again\n");
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_transport.h"
+
+// must compile with,...
+//
+// TS_TRANSPORT_UDP
+// TS_SECURITY_NONE (plain udp) or TS_SECURITY_MBED_DTLS (dtls)
+// TS_CONTROLLER_MONARCH, i.e., the socket drivers only dial tcp
+// opt TS_DRIVER_PTY (on a workstation)
+// opt TS_PLATFORM_UNIX
+//
+// and run against the local stand-in server echoing each datagram, e.g., through the modem stand-in,
+//
+// scripts/monarch_standin.py
+// scripts/udp_standin.sh 5684 (TS_SECURITY_NONE)
+// scripts/udp_standin.sh 5684 server.cert.pem server.private.key (TS_SECURITY_MBED_DTLS)
+#if defined(TS_TRANSPORT_UDP) && defined(TS_CONTROLLER_MONARCH)
+
+#define ECHO_ADDRESS "udp://localhost:5684"
+#define ECHO_COUNT 20
+#define ECHO_BUDGET (100 * TS_TIME_MSEC_TO_USEC)
+
+static int echoes = 0;
+static TsStatus_t handler( TsTransportRef_t transport, void *, TsPath_t path, const uint8_t * buffer, size_t buffer_size );
+
+int main() {
+
+	ts_status_set_level(TsStatusLevelInfo);
+
+	// create udp transport
+	TsTransportRef_t transport;
+	TsStatus_t status = ts_transport_create( &transport );
+	if( status != TsStatusOk ) {
+		ts_status_info("failed to create transport, %s\n", ts_status_string(status));
+		return 0;
+	}
+
+	// dial the stand-in server, i.e., make the dtls handshake (if any)
+	status = ts_transport_dial( transport, ECHO_ADDRESS );
+	if( status != TsStatusOk ) {
+		ts_status_info("failed to dial, %s\n", ts_status_string(status));
+		ts_transport_destroy( transport );
+		return 1;
+	}
+
+	// the stand-in echoes each report back on the same path
+	TsPath_t path = (TsPath_t)"ThingspaceSDK/B827EBA15910/test";
+	ts_transport_listen( transport, NULL, path, handler, NULL );
+
+	// speak small reports, ticking in between to receive their echoes
+	for( int count = 1; count <= ECHO_COUNT; count++ ) {
+
+		char payload[ 64 ];
+		snprintf( payload, sizeof( payload ), "report number %d", count );
+		status = ts_transport_speak( transport, path, (const uint8_t*)payload, strlen(payload) );
+		if( status != TsStatusOk ) {
+			ts_status_info("failed to speak, %s\n", ts_status_string(status));
+		}
+		for( int tick = 0; tick < 10 && echoes < count; tick++ ) {
+			ts_transport_tick( transport, ECHO_BUDGET );
+		}
+	}
+
+	ts_status_info("%d of %d reports echoed, %s\n", echoes, ECHO_COUNT, echoes == ECHO_COUNT ? "PASSED" : "FAILED");
+	ts_transport_hangup( transport );
+	ts_transport_destroy( transport );
+
+	return echoes == ECHO_COUNT ? 0 : 1;
+}
+
+TsStatus_t handler( TsTransportRef_t transport, void * data, TsPath_t path, const uint8_t * buffer, size_t buffer_size ) {
+
+	ts_status_info("echo, '%.*s'\n", (int)buffer_size, buffer);
+	echoes = echoes + 1;
+	return TsStatusOk;
+}
+
+#else
+
+int main() {
+
+	ts_status_alarm("missing one or many components, please check compile directives and build again\n");
+
+}
+
+#endif
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Copyright(C) 2017, 2018 Verizon. All rights reserved.
+
+# Script runs a local stand-in for the mqtt broker, i.e., mosquitto over tls on the given port, requiring
+# a client certificate signed by the given ca, e.g., for examples/tests/test_tick_budget. The server
+# certificate must name "localhost" and be signed by the same ca, and the test headers must be generated
+# from that ca and a client certificate and key (see scripts/include_certs.sh).
+
+# Must have mosquitto installed
+
+if [ $# -ne 4 ]; then
+  echo "This script takes 4 params"
+  echo
+  echo "$0 <port> <path to ca cert> <path to server certificate> <path to server private key>"
+  echo "Example (assuming script is being executed from the top level of the project):"
+  echo "$0 8883 ./ca.pem ./localhost.cert.pem ./localhost.private.key"
+  echo
+  exit 1
+fi
+
+CONFIG=$(mktemp)
+trap 'rm -f ${CONFIG}' EXIT
+
+cat >${CONFIG} <<END
+listener $1
+cafile $2
+certfile $3
+keyfile $4
+require_certificate true
+allow_anonymous true
+END
+
+mosquitto -v -c ${CONFIG}
@@ -0,0 +1,373 @@
+#!/usr/bin/env python3
+# Copyright(C) 2017, 2018 Verizon. All rights reserved.
+
+# Script runs a local stand-in for the Sequans Monarch modem on a pseudo-terminal, i.e., it answers the AT
+# commands and raises the URCs used by sdk_components/controller/cmd_urc_monarch.h, and carries the modem
+# socket over a host tcp (or udp) connection. Build the examples with TS_CONTROLLER_MONARCH and TS_DRIVER_PTY
+# to run ts_controller_monarch end-to-end on a workstation, e.g.,
+#
+# scripts/monarch_standin.py --target localhost:8883 --latency 20 --chunk 64
+#
+# The modem powers up when the driver opens the terminal (and resets when it closes and reopens it), and
+# sends +SYSSTART after the boot delay. The latency delays every response and URC, the chunk size splits
+# the modem output into separate writes (gap milliseconds apart), i.e., to exercise partial reads.
+
+import argparse
+import collections
+import errno
+import os
+import pty
+import select
+import signal
+import socket
+import sys
+import time
+import tty
+
+SOCK_ID = b'1'
+PDP_CTX = b'3'
+MAX_SOCK_DATA = 1500
+
+IMEI = b'352656100000000'
+IMSI = b'311480000000000'
+ICCID = b'89148000000000000000'
+IPV4 = b'10.0.0.2'
+RSSI = b'20,99'
+MANUFACTURER = b'SEQUANS Communications'
+MODULE_NAME = b'SQN3330'
+FIRMWARE = b'UE5.0.0.0d'
+
+
+def now_ms():
+    return time.monotonic() * 1000.0
+
+
+class Monarch:
+
+    def __init__(self, args):
+        self.args = args
+        self.master, slave = pty.openpty()
+        tty.setraw(slave)
+        self.device = os.ttyname(slave)
+        os.close(slave)
+        os.set_blocking(self.master, False)
+        if args.link:
+            if os.path.islink(args.link):
+                os.unlink(args.link)
+            os.symlink(self.device, args.link)
+
+        self.powered = False
+        self.output = collections.deque()
+        self.last_due = 0.0
+        self.timers = []
+        self.stats = collections.Counter()
+        self.power_off()
+
+    # modem state
+
+    def power_off(self):
+        self.close_socket()
+        self.output.clear()
+        self.timers = []
+        self.line = bytearray()
+        self.send_size = 0
+        self.send_data = bytearray()
+        self.cereg_urc = False
+        self.registered = False
+
+    def power_on(self, delay):
+        self.power_off()
+        self.after(delay, lambda: self.urc(b'+SYSSTART'))
+
+    def attach(self):
+        self.registered = True
+        if self.cereg_urc:
+            self.urc(b'+CEREG: 1')
+
+    def close_socket(self):
+        if getattr(self, 'sock', None) is not None:
+            self.sock.close()
+        self.sock = None
+        self.datagram = False
+        self.unread = collections.deque()
+
+    # modem output, delayed by the latency and split into chunks
+
+    def after(self, delay, action):
+        self.timers.append((now_ms() + delay, action))
+
+    def emit(self, data):
+        due = max(now_ms() + self.args.latency, self.last_due)
+        self.last_due = due
+        self.output.append([due, bytes(data)])
+
+    def respond(self, *lines):
+        self.emit(b''.join(b'\r\n' + line + b'\r\n' for line in lines))
+
+    def urc(self, text):
+        self.stats['urcs'] += 1
+        self.emit(b'\r\n' + text + b'\r\n')
+
+    def flush(self):
+        while self.output and self.output[0][0] <= now_ms():
+            data = self.output[0][1]
+            size = self.args.chunk if self.args.chunk > 0 else len(data)
+            try:
+                written = os.write(self.master, data[:size])
+            except BlockingIOError:
+                return
+            except OSError as e:
+                if e.errno == errno.EIO:
+                    return
+                raise
+            self.stats['modem bytes'] += written
+            if written < len(data):
+                self.output[0] = [now_ms() + self.args.gap if self.args.chunk > 0 else now_ms(), data[written:]]
+            else:
+                self.output.popleft()
+
+    def next_due(self):
+        due = [self.output[0][0]] if self.output else []
+        due += [t for t, _ in self.timers]
+        return min(due) if due else None
+
+    # host input, i.e., commands terminated by a carriage return, or the data of a socket send
+
+    def receive(self, data):
+        for i in range(len(data)):
+            if self.send_size > 0:
+                self.send_data.append(data[i])
+                if len(self.send_data) == self.send_size:
+                    self.send()
+                continue
+            if data[i] == ord('\r'):
+                self.command(bytes(self.line))
+                self.line = bytearray()
+            elif data[i] != ord('\n'):
+                self.line.append(data[i])
+
+    def command(self, line):
+        if not line:
+            return
+        self.stats['commands'] += 1
+        if self.args.verbose:
+            print('>', line.decode(errors='replace'), file=sys.stderr)
+        if self.args.echo:
+            self.emit(line + b'\r')
+
+        cmd = line.lower()
+        if cmd == b'at':
+            self.respond(b'OK')
+        elif cmd == b'at^reset':
+            self.respond(b'OK', b'+SHUTDOWN')
+            self.power_off()
+            self.after(self.args.boot, lambda: self.urc(b'+SYSSTART'))
+        elif cmd == b'at+cereg=1' or cmd == b'at+cereg=0':
+            self.cereg_urc = cmd.endswith(b'1')
+            self.respond(b'OK')
+        elif cmd == b'at+cereg?':
+            self.respond(b'+CEREG: %d,%d' % (self.cereg_urc, self.registered), b'OK')
+        elif cmd == b'at+cfun=1':
+            self.respond(b'OK')
+            if not self.registered:
+                self.after(self.args.attach, self.attach)
+        elif cmd == b'at+cfun=0':
+            self.respond(b'OK')
+            self.close_socket()
+            self.registered = False
+            if self.cereg_urc:
+                self.urc(b'+CEREG: 0')
+        elif cmd == b'at+cpin?':
+            self.respond(b'+CPIN: READY', b'OK')
+        elif cmd == b'at+cgsn':
+            self.respond(IMEI, b'OK')
+        elif cmd == b'at+csq':
+            self.respond(b'+CSQ: ' + RSSI, b'OK')
+        elif cmd == b'at+cgpaddr=' + PDP_CTX:
+            self.respond(b'+CGPADDR: ' + PDP_CTX + b',"' + IPV4 + b'"', b'OK')
+        elif cmd == b'at+sqnccid':
+            self.respond(b'+SQNCCID: "' + ICCID + b'",""', b'OK')
+        elif cmd == b'at+cclk?':
+            self.respond(time.strftime('+CCLK: "%y/%m/%d,%H:%M:%S-00"', time.gmtime()).encode(), b'OK')
+        elif cmd == b'at+cimi':
+            self.respond(IMSI, b'OK')
+        elif cmd == b'at+cgmi':
+            self.respond(MANUFACTURER, b'OK')
+        elif cmd == b'at+cgmm':
+            self.respond(MODULE_NAME, b'OK')
+        elif cmd == b'at+cgmr':
+            self.respond(FIRMWARE, b'OK')
+        elif cmd.startswith(b'at+cgact=') or cmd.startswith(b'at+sqnscfg'):
+            self.respond(b'OK' if self.registered else b'ERROR')
+        elif cmd.startswith(b'at+sqnsd=' + SOCK_ID + b','):
+            self.dial(line[len(b'at+sqnsd=1,'):])
+        elif cmd == b'at+sqnsh=' + SOCK_ID:
+            self.close_socket()
+            self.respond(b'OK')
+        elif cmd.startswith(b'at+sqnssendext=' + SOCK_ID + b','):
+            size = self.number(cmd[len(b'at+sqnssendext=1,'):])
+            if self.sock is None or size <= 0 or size > MAX_SOCK_DATA:
+                self.respond(b'ERROR')
+            else:
+                self.send_size = size
+                self.emit(b'\r\n> ')
+        elif cmd.startswith(b'at+sqnsrecv=' + SOCK_ID + b','):
+            self.recv(self.number(cmd[len(b'at+sqnsrecv=1,'):]))
+        else:
+            self.stats['unknown commands'] += 1
+            self.respond(b'ERROR')
+
+    @staticmethod
+    def number(text):
+        return int(text) if text.isdigit() else -1
+
+    # the modem socket
+
+    def dial(self, params):
+        # <protocol>,<port>,"<host>",<closure>,<local port>,<connection mode>
+        fields = params.split(b',')
+        if not self.registered or len(fields) < 3 or self.sock is not None:
+            self.respond(b'ERROR')
+            return
+        datagram = fields[0] == b'1'
+        host, port = fields[2].strip(b'"').decode(), self.number(fields[1])
+        if self.args.target:
+            host, port = self.args.target.rsplit(':', 1)
+            port = int(port)
+        try:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM if datagram else socket.SOCK_STREAM)
+            sock.settimeout(5)
+            sock.connect((host, port))
+            sock.setblocking(False)
+        except OSError as e:
+            print('dial %s:%d failed, %s' % (host, port, e), file=sys.stderr)
+            self.respond(b'ERROR')
+            return
+        self.sock = sock
+        self.datagram = datagram
+        self.stats['dials'] += 1
+        self.respond(b'OK')
+
+    def send(self):
+        data, self.send_data, self.send_size = bytes(self.send_data), bytearray(), 0
+        try:
+            if self.sock is None:
+                raise OSError(errno.ENOTCONN, 'not connected')
+            self.sock.setblocking(True)
+            self.sock.sendall(data)
+            self.sock.setblocking(False)
+        except OSError:
+            self.respond(b'ERROR')
+            return
+        self.stats['sent bytes'] += len(data)
+        self.respond(b'OK')
+
+    def recv(self, size):
+        if size < 0:
+            self.respond(b'ERROR')
+            return
+        data = bytearray()
+        while self.unread and len(data) < size:
+            chunk = self.unread.popleft()
+            take = min(size - len(data), len(chunk))
+            data += chunk[:take]
+            if take < len(chunk):
+                if not self.datagram:
+                    self.unread.appendleft(chunk[take:])
+                break
+            if self.datagram:
+                break
+        self.stats['received bytes'] += len(data)
+        self.emit(b'\r\n+SQNSRECV: ' + SOCK_ID + b',%d\r\n' % len(data) + bytes(data) + b'\r\n\r\nOK\r\n')
+
+    def socket_readable(self):
+        try:
+            data = self.sock.recv(MAX_SOCK_DATA if not self.datagram else 65536)
+        except BlockingIOError:
+            return
+        except OSError:
+            data = b''
+        if not data:
+            self.close_socket()
+            self.urc(b'+SQNSH: ' + SOCK_ID)
+            return
+        self.unread.append(data)
+        self.urc(b'+SQNSRING: ' + SOCK_ID + b',%d' % len(data))
+
+    # the event loop
+
+    def run(self):
+        print('monarch stand-in on %s%s' % (self.device, ' (%s)' % self.args.link if self.args.link else ''),
+              file=sys.stderr)
+        while True:
+            timeout = 10
+            due = self.next_due()
+            if due is not None:
+                timeout = max(0, min(timeout, due - now_ms()))
+            polled = [self.master] if self.sock is None else [self.master, self.sock.fileno()]
+            events = dict(self.poll(polled, timeout))
+
+            hangup = events.get(self.master, 0) & select.POLLHUP
+            if hangup and self.powered:
+                if self.args.verbose:
+                    print('power off', file=sys.stderr)
+                self.powered = False
+                self.power_off()
+            elif not hangup and not self.powered:
+                if self.args.verbose:
+                    print('power on', file=sys.stderr)
+                self.powered = True
+                self.power_on(self.args.boot)
+            if not self.powered:
+                time.sleep(0.01)
+                continue
+
+            if events.get(self.master, 0) & select.POLLIN:
+                try:
+                    self.receive(os.read(self.master, 4096))
+                except OSError as e:
+                    if e.errno != errno.EIO:
+                        raise
+            if self.sock is not None and events.get(self.sock.fileno(), 0) & (select.POLLIN | select.POLLHUP | select.POLLERR):
+                self.socket_readable()
+
+            expired = [action for t, action in self.timers if t <= now_ms()]
+            self.timers = [(t, action) for t, action in self.timers if t > now_ms()]
+            for action in expired:
+                action()
+            self.flush()
+
+    @staticmethod
+    def poll(fds, timeout):
+        poller = select.poll()
+        for fd in fds:
+            poller.register(fd, select.POLLIN)
+        return poller.poll(timeout)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Sequans Monarch modem stand-in on a pseudo-terminal')
+    parser.add_argument('--link', default='/tmp/monarch', help='symbolic link to the terminal device (default: %(default)s)')
+    parser.add_argument('--target', help='host:port dialed instead of the address given by the controller')
+    parser.add_argument('--latency', type=float, default=0, help='delay of each response and urc in milliseconds')
+    parser.add_argument('--chunk', type=int, default=0, help='largest write to the terminal in bytes (0 is unlimited)')
+    parser.add_argument('--gap', type=float, default=1, help='delay between chunks in milliseconds (default: %(default)s)')
+    parser.add_argument('--boot', type=float, default=100, help='delay of +SYSSTART in milliseconds (default: %(default)s)')
+    parser.add_argument('--attach', type=float, default=200, help='delay of +CEREG: 1 in milliseconds (default: %(default)s)')
+    parser.add_argument('--echo', action='store_true', help='echo the commands, i.e., as ATE1')
+    parser.add_argument('-v', '--verbose', action='store_true', help='print each command')
+    modem = Monarch(parser.parse_args())
+    signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+    try:
+        modem.run()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for name, count in sorted(modem.stats.items()):
+            print('%s: %d' % (name, count), file=sys.stderr)
+        if modem.args.link and os.path.islink(modem.args.link):
+            os.unlink(modem.args.link)
+
+
+if __name__ == '__main__':
+    main()
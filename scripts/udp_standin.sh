@@ -0,0 +1,29 @@
+#!/bin/bash
+# Copyright(C) 2017, 2018 Verizon. All rights reserved.
+
+# Script runs a local stand-in for the datagram (udp) server, echoing each datagram back to its sender,
+# e.g., for examples/tests/test_transport_udp. Without a certificate the datagrams are plain udp (build
+# with TS_SECURITY_NONE), with a certificate and key they are dtls (build with TS_SECURITY_MBED_DTLS).
+# Datagrams are dialed by the monarch controller only, i.e., on a workstation run the test through
+# scripts/monarch_standin.py (TS_CONTROLLER_MONARCH and TS_DRIVER_PTY).
+
+# Must have socat installed (version 1.7.4 or later for dtls)
+
+if [ $# -ne 1 ] && [ $# -ne 3 ]; then
+  echo "This script takes 1 or 3 params"
+  echo
+  echo "$0 <port> [<path to server certificate> <path to server private key>]"
+  echo "Example (plain udp, then dtls):"
+  echo "$0 5684"
+  echo "$0 5684 ./server.cert.pem ./server.private.key"
+  echo
+  exit 1
+fi
+
+PORT=$1
+
+if [ $# -eq 1 ]; then
+  exec socat -v UDP4-RECVFROM:${PORT},fork EXEC:cat
+else
+  exec socat -v OPENSSL-DTLS-SERVER:${PORT},cert=$2,key=$3,verify=0,fork EXEC:cat
+fi
@@ -11,6 +11,8 @@
 #ifndef TS_ADDRESS_H
 #define TS_ADDRESS_H
 
+#include <stdbool.h>
+
 #include "ts_status.h"
 
 /**
@@ -23,6 +25,14 @@
  */
 #define TS_ADDRESS_MAX_PORT_SIZE 6
 
+/**
+ * The (optional) address scheme prefixes, an address without one is a stream (tcp) address
+ * e.g., "udp://coap.thingspace.verizon.com:5684"
+ */
+#define TS_ADDRESS_STREAM_SCHEME "tcp://"
+#define TS_ADDRESS_DATAGRAM_SCHEME "udp://"
+#define TS_ADDRESS_MAX_SCHEME_SIZE 6
+
 /**
  * A well-known network address
  * e.g., "mqtt.thingspace.verizon.com:1883"
@@ -48,9 +58,10 @@ extern "C" {
 
 /**
  * Parse a string in the format "host:port", and fill the host and port out parameters to the pointer to each.
+ * A scheme prefix (i.e., "tcp://" or "udp://") is skipped, see ts_address_is_datagram.
  *
  * @param destination
- * The network address in the form "host:port".
+ * The network address in the form "host:port", or "scheme://host:port".
  *
  * @param host
  * [out] pointer to the given host.
@@ -64,6 +75,18 @@ extern "C" {
  */
 TsStatus_t ts_address_parse(TsAddress_t destination, char * host, char * port);
 
+/**
+ * Return whether the given address is a datagram (udp) address, i.e., it begins with "udp://".
+ * Datagram addresses are dialed by the monarch controller only, the none controller rejects them.
+ *
+ * @param destination
+ * The network address.
+ *
+ * @return
+ * True for a datagram address, false for a stream (tcp) address
+ */
+bool ts_address_is_datagram(TsAddress_t destination);
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,7 +51,8 @@ typedef struct TsScepConfig {
 	char *_getCaCertUrl;
 	int _getPkcsRequestUrl; 	
 	int _getCertInitialUrl; 	
-	TsStatus_t (*_messageCallback)(TsMessageRef_t, char *);	// pointer to function for sending the cert message
+	TsStatus_t (*_messageCallback)(void *, TsMessageRef_t, char *);	// pointer to function for sending the cert message
+	void * _messageContext;		// passed back to the message callback, e.g., the owning service
 } TsScepConfig_t;
 
 TsStatus_t ts_handle_certack( TsMessageRef_t fields );
@@ -119,12 +120,14 @@ TsStatus_t ts_scepconfig_handle(TsScepConfigRef_t, TsMessageRef_t);
  * [on/out] Pointer to a TsScepConfigRef_t in which the new config will be stored.
  * @param messageCallback
  * [in] Pointer to a function that will send a TsMessage with a specified kind.
+ * @param messageContext
+ * [in] Opaque pointer passed as the first argument of the message callback.
  * @return
  * The return status (TsStatus_t) of the function, see ts_status.h for more information.
  * - TsStatusOk
  * - TsStatusError[Code]
  */
-TsStatus_t ts_scepconfig_create(TsScepConfigRef_t *, TsStatus_t (*messageCallback)(TsMessageRef_t, char *));
+TsStatus_t ts_scepconfig_create(TsScepConfigRef_t *, TsStatus_t (*messageCallback)(void *, TsMessageRef_t, char *), void *);
 
 /**
  * Destroy a scep configuration object.
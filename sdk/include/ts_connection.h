@@ -278,6 +278,151 @@ TsStatus_t ts_connection_set_client_key( TsConnectionRef_t connection, const uin
  */
 TsStatus_t ts_connection_connect( TsConnectionRef_t connection, TsAddress_t address );
 
+/**
+ * Begin a TCP/IP connection to the given address without waiting for the security handshake, which
+ * is then advanced by ts_connection_handshake. Security components that do not divide the handshake
+ * connect completely, i.e., return TsStatusOk.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param address
+ * [in] The destination address, see ts_connection_connect.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk, the connection is complete
+ * - TsStatusOkTrying, the handshake is in progress
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_connect_start( TsConnectionRef_t connection, TsAddress_t address );
+
+/**
+ * Advance the security handshake begun by ts_connection_connect_start according to the given
+ * budget "recommendation".
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param budget
+ * [in] The recommended time in microseconds budgeted for the function
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk, the connection is complete
+ * - TsStatusOkTrying, the handshake is still in progress
+ * - TsStatusError[Code], the connection was torn down
+ */
+TsStatus_t ts_connection_handshake( TsConnectionRef_t connection, uint32_t budget );
+
+/**
+ * Enable or disable security session resumption, see ts_security set_resumption.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param enable
+ * [in] True to resume sessions, false to always make a full handshake
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotImplemented, the security component doesn't resume sessions
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_set_resumption( TsConnectionRef_t connection, bool enable );
+
+/**
+ * Return the security handshake statistics, see ts_security get_session_stats.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param stats
+ * [out] The statistics, zeroed when not implemented
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotImplemented, the security component doesn't resume sessions
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_get_session_stats( TsConnectionRef_t connection, TsSecuritySessionStats_t * stats );
+
+/**
+ * Return the memory used by the security library, see ts_security get_memory_stats.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param stats
+ * [out] The statistics, zeroed when not implemented
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotImplemented, the security component doesn't report memory
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_get_memory_stats( TsConnectionRef_t connection, TsSecurityMemoryStats_t * stats );
+
+/**
+ * Set the pre-shared key used by PSK cipher suites, see ts_security set_psk.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param psk
+ * [in] The pre-shared key
+ *
+ * @param psk_size
+ * [in] The pre-shared key size
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotImplemented, the security component doesn't support pre-shared keys
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_set_psk( TsConnectionRef_t connection, const uint8_t * psk, size_t psk_size );
+
+/**
+ * Set the pre-shared key identity, see ts_security set_psk_identity.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param identity
+ * [in] The pre-shared key identity
+ *
+ * @param identity_size
+ * [in] The pre-shared key identity size
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotImplemented, the security component doesn't support pre-shared keys
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_set_psk_identity( TsConnectionRef_t connection, const uint8_t * identity, size_t identity_size );
+
+/**
+ * Return the credential cache statistics, see ts_security get_credential_stats.
+ *
+ * @param connection
+ * [in] The connection object
+ *
+ * @param stats
+ * [out] The statistics, zeroed when not implemented
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotImplemented, the security component doesn't cache credentials
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_connection_get_credential_stats( TsConnectionRef_t connection, TsSecurityCredentialStats_t * stats );
+
 /**
  * Destroy (i.e., tear down) the current TCP/IP connection. Note that this will used the underlying ts_security
  * component to tear down the connection.
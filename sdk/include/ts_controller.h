@@ -195,6 +195,28 @@ typedef struct TsControllerVtable {
 	 */
 	TsStatus_t (* write)( TsControllerRef_t controller, const uint8_t * buffer, size_t * buffer_size, uint32_t budget );
 
+	/**
+	 * (Optional) Wait for received bytes, i.e., sleep until the driver signals that data arrived
+	 * (see TsDriverReader_t) or the budget is spent, rather than polling read. This function is
+	 * typically called from ts_security when a read returns TsStatusOkReadPending. It can be set
+	 * to NULL, in which case the caller returns to its own loop as before.
+	 *
+	 * @param controller
+	 * [in] The controller object
+	 *
+	 * @param budget
+	 * [in] The maximum amount of time in microseconds to wait.
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * 		- Bytes are ready to be read, or the connection was closed (i.e., the next read won't be pending)
+	 * - TsStatusOkReadPending
+	 * 		- The budget was spent without receiving any bytes
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* wait)( TsControllerRef_t controller, uint32_t budget );
+
 	TsStatus_t (* get_id)( TsControllerRef_t, char * );
 	TsStatus_t (* get_rssi)( TsControllerRef_t, char * );
 	TsStatus_t (* get_ipv4_addr)( TsControllerRef_t, char * );
@@ -231,6 +253,7 @@ extern const TsControllerVtable_t * ts_controller;
 #define ts_controller_disconnect    ts_controller->disconnect
 #define ts_controller_read          ts_controller->read
 #define ts_controller_write         ts_controller->write
+#define ts_controller_wait          ts_controller->wait
 
 /**
  * The following #defines are deprecated, the _profile will be used in future for diagnostics.
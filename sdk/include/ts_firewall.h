@@ -55,7 +55,8 @@ typedef struct TsCallbackContext {
 	int alert_threshold_outbound;
 	int inbound_rejections;
 	int outbound_rejections;
-	TsStatus_t (*alert_callback) (TsMessageRef_t, char *);
+	TsStatus_t (*alert_callback) (void *, TsMessageRef_t, char *);
+	void * alert_context;		// passed back to the alert callback, e.g., the owning service
 	TsLogConfigRef_t log;
 } TsCallbackContext_t;
 
@@ -74,12 +75,15 @@ typedef struct TsFirewallVtable {
 	 * @param alertCallback
 	 * [in] Pointer to a function that will send an alert message with a designated kind.
 	 *
+	 * @param alertContext
+	 * [in] Opaque pointer passed as the first argument of the alert callback.
+	 *
 	 * @return
 	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
 	 * - TsStatusOk
 	 * - TsStatusError[Code]
 	 */
-	TsStatus_t (*create)(TsFirewallRef_t *, TsStatus_t (*alertCallback)(TsMessageRef_t, char *));
+	TsStatus_t (*create)(TsFirewallRef_t *, TsStatus_t (*alertCallback)(void *, TsMessageRef_t, char *), void *);
 
 	/**
 	 * Deallocate the given firewall object.
@@ -171,7 +175,8 @@ typedef struct TsFirewallVtable {
 
 
 /**
- * Set the firewall that we'll be suspending/resuming.
+ * Deprecated, the firewall is now passed to ts_suspend_handle by the owning service, and
+ * this function has no effect.
  * @param firewall
  * [in] The firewall that we'll be suspending/resuming.
  * @return
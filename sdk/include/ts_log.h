@@ -76,7 +76,8 @@ typedef struct TsLogConfig {
 	TsLogEntryRef_t _newest;	// newest entry (oldest one, if it exists, should be after this)
 	TsLogEntryRef_t _end;		// after the last entry in memory
 	uint64_t _last_report_time;	// the last time we reported logs back to the provider
-	TsStatus_t (*_messageCallback)(TsMessageRef_t, char *);	// pointer to function for sending the log message
+	TsStatus_t (*_messageCallback)(void *, TsMessageRef_t, char *);	// pointer to function for sending the log message
+	void * _messageContext;		// passed back to the message callback, e.g., the owning service
 } TsLogConfig_t;
 
 /**
@@ -85,12 +86,14 @@ typedef struct TsLogConfig {
  * [on/out] Pointer to a TsLogConfigRef_t in which the new config will be stored.
  * @param messageCallback
  * [in] Pointer to a function that will send a TsMessage with a specified kind.
+ * @param messageContext
+ * [in] Opaque pointer passed as the first argument of the message callback.
  * @return
  * The return status (TsStatus_t) of the function, see ts_status.h for more information.
  * - TsStatusOk
  * - TsStatusError[Code]
  */
-TsStatus_t ts_logconfig_create(TsLogConfigRef_t *, TsStatus_t (*messageCallback)(TsMessageRef_t, char *));
+TsStatus_t ts_logconfig_create(TsLogConfigRef_t *, TsStatus_t (*messageCallback)(void *, TsMessageRef_t, char *), void *);
 
 /**
  * Destroy a log configuration object.
@@ -171,7 +174,8 @@ bool ts_logconfig_suspended(TsLogConfigRef_t);
 
 
 /**
- * Set the logconfig used to log suspension events, and that we'll be suspending/resuming.
+ * Deprecated, the logconfig is now passed to ts_suspend_handle by the owning service, and
+ * this function has no effect.
  * @param logconfig
  * [in] The log configuration to use for logging suspension events.
  * @return
@@ -0,0 +1,249 @@
+/**
+ * @file
+ * ts_ratelimit.h
+ *
+ * @copyright
+ * Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+ *
+ * @brief
+ * Uplink rate limiting (i.e., airtime budgeting) for the service layer.
+ *
+ * @details
+ * The rate limiter is a pair of token buckets, one counting messages and one counting bytes,
+ * that is consulted by the service before unsolicited traffic (telemetry, log reports, firewall
+ * alerts, etc.) is handed to the transport. Traffic exceeding either bucket is either dropped, or
+ * queued (up to a bounded depth) and released from ts_service_tick as tokens become available.
+ * A rate of zero disables the corresponding bucket. Responses to server requests are never limited.
+ *
+ * @code
+ *
+ * 	// allow 2 messages and 1KB per second, holding back any excess
+ * 	ts_service_set_rate_limit( service, 2, 1024, TsRateLimitPolicyQueue );
+ *
+ * 	...
+ *
+ * 	TsRateLimitStats_t stats;
+ * 	ts_service_get_rate_limit_stats( service, &stats );
+ *
+ * @endcode
+ */
+#ifndef TS_RATELIMIT_H
+#define TS_RATELIMIT_H
+
+#include "ts_status.h"
+#include "ts_transport.h"
+
+#define TS_RATELIMIT_MAX_QUEUE 8
+#define TS_RATELIMIT_MAX_RETRIES 5	// failed sends of a queued message before it is dropped
+
+/**
+ * The policy applied to traffic exceeding the configured rates
+ */
+typedef enum {
+	TsRateLimitPolicyDrop = 0,		// discard excess traffic
+	TsRateLimitPolicyQueue,			// hold excess traffic, and send when tokens become available
+} TsRateLimitPolicy_t;
+
+/**
+ * A single token bucket, tokens are held in millionths so that microsecond refills are exact
+ */
+typedef struct TsRateLimitBucket {
+	uint32_t _rate;					// tokens per second, zero is unlimited
+	uint32_t _burst;				// bucket capacity in tokens
+	int64_t _tokens;				// available tokens (in millionths), may go negative after an oversized message
+} TsRateLimitBucket_t;
+
+/**
+ * A queued (deferred) message, already encoded and ready for the transport
+ */
+typedef struct TsRateLimitEntry {
+	char * _path;
+	uint8_t * _buffer;
+	size_t _size;
+	TsTransportQos_t _qos;
+	uint32_t _failures;				// failed attempts to hand the message to the transport
+} TsRateLimitEntry_t;
+
+/**
+ * The rate limit counters
+ */
+typedef struct TsRateLimitStats {
+	uint32_t accepted;				// messages passed to the transport without delay
+	uint32_t deferred;				// messages queued and later passed to the transport
+	uint32_t dropped;				// messages discarded by policy, due to a full queue, or after repeated send failures
+	uint32_t bytes;					// bytes passed to the transport
+	uint32_t pending;				// messages currently queued
+} TsRateLimitStats_t;
+
+/**
+ * The rate limit object
+ */
+typedef struct TsRateLimit {
+	TsRateLimitPolicy_t _policy;
+	TsRateLimitBucket_t _messages;
+	TsRateLimitBucket_t _bytes;
+	uint64_t _last_refill;			// the last time the buckets were refilled (microseconds)
+	TsRateLimitEntry_t _queue[ TS_RATELIMIT_MAX_QUEUE ];
+	size_t _queue_head;
+	size_t _queue_count;
+	TsRateLimitStats_t _stats;
+} TsRateLimit_t;
+
+/**
+ * The rate limit object reference
+ */
+typedef struct TsRateLimit * TsRateLimitRef_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocate and initialize a new (unlimited) rate limit object.
+ *
+ * @param ratelimit
+ * [on/out] The pointer to a pre-existing TsRateLimitRef_t, which will be initialized with the rate limit state.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_create( TsRateLimitRef_t * );
+
+/**
+ * Deallocate the given rate limit object, discarding any queued messages.
+ *
+ * @param ratelimit
+ * [in] The rate limit state.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_destroy( TsRateLimitRef_t );
+
+/**
+ * Set the message and byte rates, and the policy for excess traffic. The burst size of each bucket
+ * is one second of traffic.
+ *
+ * @param ratelimit
+ * [in] The rate limit state.
+ *
+ * @param messages
+ * [in] The maximum number of messages per second, or zero for unlimited.
+ *
+ * @param bytes
+ * [in] The maximum number of bytes per second, or zero for unlimited.
+ *
+ * @param policy
+ * [in] The policy applied to excess traffic, see TsRateLimitPolicy_t.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_set( TsRateLimitRef_t, uint32_t, uint32_t, TsRateLimitPolicy_t );
+
+/**
+ * Send the given (encoded) message via the transport if the rate allows, otherwise apply the policy.
+ *
+ * @param ratelimit
+ * [in] The rate limit state.
+ *
+ * @param transport
+ * [in] The transport used to send the message.
+ *
+ * @param path
+ * [in] The destination path (i.e., topic).
+ *
+ * @param buffer
+ * [in] The encoded message.
+ *
+ * @param buffer_size
+ * [in] The size of the encoded message.
+ *
+ * @param qos
+ * [in] The delivery guarantee requested from the transport.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusOkWritePending, the message was queued
+ * - TsStatusErrorNoResourceAvailable, the message was dropped
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_speak( TsRateLimitRef_t, TsTransportRef_t, TsPath_t, const uint8_t *, size_t, TsTransportQos_t );
+
+/**
+ * Send the given (encoded) message segments as ts_ratelimit_speak does, see ts_transport speak_vector.
+ * The segments are only copied (i.e., gathered) when the message is queued.
+ *
+ * @param ratelimit
+ * [in] The rate limit state.
+ *
+ * @param transport
+ * [in] The transport used to send the message.
+ *
+ * @param path
+ * [in] The destination path (i.e., topic).
+ *
+ * @param segments
+ * [in] The encoded message segments, in order.
+ *
+ * @param count
+ * [in] The number of segments.
+ *
+ * @param qos
+ * [in] The delivery guarantee requested from the transport.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusOkWritePending, the message was queued
+ * - TsStatusErrorNoResourceAvailable, the message was dropped
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_speak_vector( TsRateLimitRef_t, TsTransportRef_t, TsPath_t, const TsTransportSegment_t *, size_t, TsTransportQos_t );
+
+/**
+ * Release queued messages to the transport as tokens become available. A queued message the transport
+ * fails to send is retried on the next tick, and dropped after TS_RATELIMIT_MAX_RETRIES failures, i.e.,
+ * it can't hold back the rest of the queue.
+ *
+ * @param ratelimit
+ * [in] The rate limit state.
+ *
+ * @param transport
+ * [in] The transport used to send the messages.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_tick( TsRateLimitRef_t, TsTransportRef_t );
+
+/**
+ * Copy the current counters.
+ *
+ * @param ratelimit
+ * [in] The rate limit state.
+ *
+ * @param stats
+ * [out] The counters.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_ratelimit_get_stats( TsRateLimitRef_t, TsRateLimitStats_t * );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TS_RATELIMIT_H
@@ -0,0 +1,203 @@
+/**
+ * @file
+ * ts_scheduler.h
+ *
+ * @copyright
+ * Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+ *
+ * @brief
+ * A small cooperative scheduler used to divide the ts_service_tick budget between subsystems.
+ *
+ * @details
+ * Subsystems (e.g., the service protocol, log reporting, the firewall and the transport) register
+ * tasks with a period, a deadline and a budget share. On each tick, the tasks that are due run in
+ * earliest-deadline-first order (ties are broken by registration order). Each task is given its own
+ * share of the tick budget plus any budget left unused by the tasks before it, less the shares
+ * reserved for the tasks still to run, and never less than its own share (even once the tick budget
+ * is used up). A task without a share that would be given no budget is deferred to the next tick,
+ * i.e., a task is never run with a zero budget. Tasks are cooperative, i.e., they are expected to
+ * return within the budget given to them; a task that does not is counted as an overrun, and a task
+ * that starts after its deadline is counted as a miss.
+ *
+ * @code
+ *
+ * 	TsSchedulerRef_t scheduler;
+ * 	ts_scheduler_create( &scheduler );
+ *
+ * 	// run every second, within 100ms of being due, using at most 10% of each tick
+ * 	ts_scheduler_add( scheduler, "sensor", sensor_task, sensor, TS_TIME_SEC_TO_USEC, 100 * TS_TIME_MSEC_TO_USEC, 10 );
+ *
+ * 	while( running ) {
+ * 		ts_scheduler_tick( scheduler, 5 * TS_TIME_SEC_TO_USEC );
+ * 	}
+ *
+ * @endcode
+ */
+#ifndef TS_SCHEDULER_H
+#define TS_SCHEDULER_H
+
+#include "ts_status.h"
+
+#define TS_SCHEDULER_MAX_TASKS 8
+
+/**
+ * The task function, called with the task state and the budget (microseconds) given for this run
+ */
+typedef TsStatus_t (* TsSchedulerHandler_t)( void *, uint32_t );
+
+/**
+ * The per-task statistics
+ */
+typedef struct TsSchedulerStats {
+	uint32_t runs;					// number of times the task has run
+	uint32_t overruns;				// number of runs that exceeded the budget given
+	uint32_t misses;				// number of runs started after the deadline
+	uint32_t deferrals;				// number of times the task was due but left for the next tick
+	uint32_t runtime_max;			// longest single run (microseconds)
+	uint64_t runtime;				// total run time (microseconds)
+	TsStatus_t status;				// the status returned by the last run
+} TsSchedulerStats_t;
+
+/**
+ * A scheduled task
+ */
+typedef struct TsSchedulerTask {
+	const char * _name;
+	TsSchedulerHandler_t _handler;
+	void * _state;
+	uint32_t _period;				// time between releases (microseconds), zero runs on every tick
+	uint32_t _deadline;				// time after release by which the task should run (microseconds), zero is the period
+	uint32_t _share;				// percentage of the tick budget reserved for the task
+	uint64_t _release;				// the next (or current) release time
+	TsSchedulerStats_t _stats;
+} TsSchedulerTask_t;
+
+/**
+ * The scheduler object
+ */
+typedef struct TsScheduler {
+	TsSchedulerTask_t _tasks[ TS_SCHEDULER_MAX_TASKS ];
+	size_t _count;
+	uint32_t _shares;				// sum of the registered shares, never more than 100
+} TsScheduler_t;
+
+/**
+ * The scheduler object reference
+ */
+typedef struct TsScheduler * TsSchedulerRef_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocate and initialize a new scheduler object.
+ *
+ * @param scheduler
+ * [on/out] The pointer to a pre-existing TsSchedulerRef_t, which will be initialized with the scheduler state.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_scheduler_create( TsSchedulerRef_t * );
+
+/**
+ * Deallocate the given scheduler object.
+ *
+ * @param scheduler
+ * [in] The scheduler state.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_scheduler_destroy( TsSchedulerRef_t );
+
+/**
+ * Register a task.
+ *
+ * @param scheduler
+ * [in] The scheduler state.
+ *
+ * @param name
+ * [in] The task name, used for reporting and look-up. The string is not copied.
+ *
+ * @param handler
+ * [in] The task function.
+ *
+ * @param state
+ * [in] The state passed to the task function.
+ *
+ * @param period
+ * [in] The time between task releases in microseconds, or zero to run on every tick.
+ *
+ * @param deadline
+ * [in] The time after release by which the task should have started in microseconds, or zero for the period.
+ *
+ * @param share
+ * [in] The percentage of each tick budget reserved for the task.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorIndexOutOfRange, too many tasks, or shares totaling more than 100
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_scheduler_add( TsSchedulerRef_t, const char *, TsSchedulerHandler_t, void *, uint32_t, uint32_t, uint32_t );
+
+/**
+ * Run the tasks that are due within the given budget.
+ *
+ * @param scheduler
+ * [in] The scheduler state.
+ *
+ * @param budget
+ * [in] The time in microseconds budgeted for the function.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code], the first error returned by a task during this tick
+ */
+TsStatus_t ts_scheduler_tick( TsSchedulerRef_t, uint32_t );
+
+/**
+ * Copy the statistics of the named task.
+ *
+ * @param scheduler
+ * [in] The scheduler state.
+ *
+ * @param name
+ * [in] The task name.
+ *
+ * @param stats
+ * [out] The task statistics.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusErrorNotFound
+ */
+TsStatus_t ts_scheduler_get_stats( TsSchedulerRef_t, const char *, TsSchedulerStats_t * );
+
+/**
+ * Print the statistics of all tasks (at the info level).
+ *
+ * @param scheduler
+ * [in] The scheduler state.
+ *
+ * @return
+ * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+ * - TsStatusOk
+ * - TsStatusError[Code]
+ */
+TsStatus_t ts_scheduler_report( TsSchedulerRef_t );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TS_SCHEDULER_H
@@ -46,6 +46,45 @@
 #define SSL_WRITE_BUDGET (50 * TS_TIME_SEC_TO_USEC)
 #endif
 
+/**
+ * The session resumption statistics, see get_session_stats
+ */
+typedef struct TsSecuritySessionStats {
+	uint32_t handshakes;		// full handshakes completed
+	uint32_t resumptions;		// abbreviated handshakes completed, i.e., a saved session was resumed
+	bool resumed;				// whether the last handshake resumed a session
+	uint32_t bytes;				// the bytes sent and received by the last handshake
+	uint32_t time;				// the duration of the last handshake (microseconds)
+	uint64_t handshake_bytes;	// the total bytes of all full handshakes
+	uint64_t handshake_time;	// the total duration of all full handshakes (microseconds)
+	uint64_t resumption_bytes;	// the total bytes of all abbreviated handshakes
+	uint64_t resumption_time;	// the total duration of all abbreviated handshakes (microseconds)
+} TsSecuritySessionStats_t;
+
+/**
+ * The memory statistics of the security library, i.e., of all security objects, see get_memory_stats
+ */
+typedef struct TsSecurityMemoryStats {
+	uint32_t current;			// the bytes allocated now
+	uint32_t peak;				// the most bytes allocated at once
+	uint32_t handshake_peak;	// the most bytes allocated during the last handshake
+	uint32_t steady;			// the bytes allocated once the last handshake completed
+	uint32_t record_buffers;	// the size of the (compile-time) record buffers, per connection
+	uint32_t fragment;			// the maximum fragment length requested, from the connection mtu
+} TsSecurityMemoryStats_t;
+
+/**
+ * The credential cache statistics, i.e., of all security objects, see get_credential_stats
+ */
+typedef struct TsSecurityCredentialStats {
+	uint32_t credentials;		// the certificates and keys held, i.e., in use or kept for reuse
+	uint32_t parses;			// credentials parsed, i.e., cache misses
+	uint32_t hits;				// credentials set without parsing, i.e., found in the cache
+	uint32_t evictions;			// unused credentials freed to make room for another
+	uint64_t parse_time;		// the total time spent parsing (microseconds)
+	uint32_t heap;				// the bytes held by the cache, i.e., the der copies and the parsed forms
+} TsSecurityCredentialStats_t;
+
 /**
  * The security object reference
  */
@@ -187,6 +226,46 @@ typedef struct TsSecurityVtable {
 	 */
 	TsStatus_t (*connect)(TsSecurityRef_t, TsAddress_t);
 
+	/**
+	 * Begin a connection to the given server address without waiting for the TLS handshake, which is
+	 * then advanced by calling handshake. Note that the underlying ts_controller TCP/IP connect may
+	 * still block, only the negotiation is divided.
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param address
+	 * [in] The destination address, see connect.
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk, the connection is complete
+	 * - TsStatusOkTrying, the handshake is in progress
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*connect_start)(TsSecurityRef_t, TsAddress_t);
+
+	/**
+	 * Advance a handshake begun by connect_start according to the given budget "recommendation". The
+	 * connection is torn down when the handshake fails, or exceeds SSL_HANDSHAKE_TIMEOUT in total.
+	 * Components without an incremental dial (e.g., mocana) leave connect_start NULL, and are not
+	 * called to advance the handshake of their blocking connect.
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param budget
+	 * [in] The recommended time in microseconds budgeted for the function
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk, the connection is complete
+	 * - TsStatusOkTrying, the handshake is still in progress
+	 * - TsStatusErrorNotImplemented, the handshake cannot be divided
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*handshake)(TsSecurityRef_t, uint32_t);
+
 	/**
 	 * Destroy (i.e., tear down) the current TCP/IP connection. Note that this will used the underlying
 	 * ts_controller component to tear down the connection.
@@ -266,6 +345,111 @@ typedef struct TsSecurityVtable {
 	 */
 	TsStatus_t (*write)(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
 
+	/**
+	 * Enable or disable session resumption, i.e., the session negotiated by a full handshake is saved
+	 * (by session-id and ticket) and offered on the next connect, which then only needs an abbreviated
+	 * handshake when the server accepts it.
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param enable
+	 * [in] True to resume sessions (the default), false to always make a full handshake
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*set_resumption)(TsSecurityRef_t, bool);
+
+	/**
+	 * Return the handshake statistics, i.e., the cost of full and abbreviated (resumed) handshakes.
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param stats
+	 * [out] The statistics
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*get_session_stats)(TsSecurityRef_t, TsSecuritySessionStats_t *);
+
+	/**
+	 * Return the memory used by the security library, e.g., the handshake peak and the steady state.
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param stats
+	 * [out] The statistics
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*get_memory_stats)(TsSecurityRef_t, TsSecurityMemoryStats_t *);
+
+	/**
+	 * Set the pre-shared key used instead of certificates by PSK cipher suites (e.g., TS_SECURITY_MBED_PSK).
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param psk
+	 * [in] The pre-shared key
+	 *
+	 * @param psk_size
+	 * [in] The pre-shared key size
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*set_psk)(TsSecurityRef_t, const uint8_t *, size_t);
+
+	/**
+	 * Set the identity sent to the server to select the pre-shared key, see set_psk.
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param identity
+	 * [in] The pre-shared key identity
+	 *
+	 * @param identity_size
+	 * [in] The pre-shared key identity size
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*set_psk_identity)(TsSecurityRef_t, const uint8_t *, size_t);
+
+	/**
+	 * Return the credential cache statistics, i.e., the cost of parsing certificates and keys, and
+	 * how often that cost was avoided by a credential parsed before (e.g., by another security object).
+	 *
+	 * @param security
+	 * [in] The security object
+	 *
+	 * @param stats
+	 * [out] The statistics
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*get_credential_stats)(TsSecurityRef_t, TsSecurityCredentialStats_t *);
+
 } TsSecurityVtable_t;
 
 #ifdef __cplusplus
@@ -289,9 +473,17 @@ extern const TsSecurityVtable_t * ts_security;
 #define ts_security_get_spec_budget ts_security->get_spec_budget
 
 #define ts_security_connect			ts_security->connect
+#define ts_security_connect_start	ts_security->connect_start
+#define ts_security_handshake		ts_security->handshake
 #define ts_security_disconnect		ts_security->disconnect
 #define ts_security_read			ts_security->read
 #define ts_security_write			ts_security->write
+#define ts_security_set_resumption	ts_security->set_resumption
+#define ts_security_get_session_stats	ts_security->get_session_stats
+#define ts_security_get_memory_stats	ts_security->get_memory_stats
+#define ts_security_set_psk			ts_security->set_psk
+#define ts_security_set_psk_identity	ts_security->set_psk_identity
+#define ts_security_get_credential_stats	ts_security->get_credential_stats
 
 #ifdef __cplusplus
 }
@@ -34,7 +34,8 @@
  *		// register a message handler
  *		ts_service_dequeue( service, TsServiceActionMaskAll, handler );
  *
- *		// connect to the cloud
+ *		// connect to the cloud, dial returns TsStatusOkTrying and the connection is
+ *		// completed by ts_service_tick, which returns TsStatusOkTrying until connected
  *		ts_service_dial( service, address );
  *
  *		// start a single-threaded run-loop
@@ -77,9 +78,12 @@
 #include "ts_firewall.h"
 #include "ts_log.h"
 #include "ts_cert.h"
+#include "ts_ratelimit.h"
+#include "ts_scheduler.h"
 
 #define TS_SERVICE_MAX_HANDLERS 8
 #define TS_SERVICE_MAX_PATH_SIZE 256
+#define TS_SERVICE_TASK_TRANSPORT "transport"
 
 typedef enum {
 	TsServiceEnvelopeVersionOne = 0x01,
@@ -191,6 +195,9 @@ typedef struct TsService {
 	TsFirewallRef_t     _firewall;
 	TsLogConfigRef_t	_logconfig;
 	TsScepConfigRef_t	_scepconfig;
+	TsRateLimitRef_t	_ratelimit;
+	TsSchedulerRef_t	_scheduler;
+	bool				_dialing;
 } TsService_t;
 
 /**
@@ -267,6 +274,26 @@ typedef struct TsServiceVtable {
 	 */
 	TsStatus_t (*enqueue)( TsServiceRef_t, TsMessageRef_t );
 
+	/**
+	 * Send the given sensor readings to the server, as enqueue does, with the given delivery guarantee,
+	 * e.g., TsTransportQos0 for high-rate, loss-tolerant telemetry. Enqueue uses TsTransportQos1.
+	 *
+	 * @param service
+	 * [in] The service state.
+	 *
+	 * @param message
+	 * [in] The sensor readings.
+	 *
+	 * @param qos
+	 * [in] The delivery guarantee, see TsTransportQos_t.
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (*enqueueqos)( TsServiceRef_t, TsMessageRef_t, TsTransportQos_t );
+
 
 	TsStatus_t (*enqueuetyped)( TsServiceRef_t, char*, TsMessageRef_t );
 
@@ -312,6 +339,26 @@ TsStatus_t ts_service_hangup( TsServiceRef_t );
 TsStatus_t ts_service_enqueue( TsServiceRef_t, TsMessageRef_t );
 TsStatus_t ts_service_dequeue( TsServiceRef_t, TsServiceAction_t, TsServiceHandler_t );
 TsStatus_t ts_service_enqueue_typed( TsServiceRef_t, char*, TsMessageRef_t );
+TsStatus_t ts_service_enqueue_qos( TsServiceRef_t, TsMessageRef_t, TsTransportQos_t );
+
+TsStatus_t ts_service_set_rate_limit( TsServiceRef_t, uint32_t, uint32_t, TsRateLimitPolicy_t );
+TsStatus_t ts_service_get_rate_limit_stats( TsServiceRef_t, TsRateLimitStats_t * );
+TsStatus_t ts_service_speak( TsServiceRef_t, TsPath_t, const uint8_t *, size_t, TsTransportQos_t );
+TsStatus_t ts_service_speak_vector( TsServiceRef_t, TsPath_t, const TsTransportSegment_t *, size_t, TsTransportQos_t );
+
+TsStatus_t ts_service_set_reconnect( TsServiceRef_t, uint32_t, uint32_t );
+TsStatus_t ts_service_get_reconnect_stats( TsServiceRef_t, TsTransportReconnectStats_t * );
+TsStatus_t ts_service_set_keepalive( TsServiceRef_t, uint32_t, uint32_t );
+TsStatus_t ts_service_get_keepalive_stats( TsServiceRef_t, TsTransportKeepAliveStats_t * );
+TsStatus_t ts_service_set_resumption( TsServiceRef_t, bool );
+TsStatus_t ts_service_get_session_stats( TsServiceRef_t, TsSecuritySessionStats_t * );
+TsStatus_t ts_service_get_memory_stats( TsServiceRef_t, TsSecurityMemoryStats_t * );
+TsStatus_t ts_service_set_psk( TsServiceRef_t, const uint8_t *, size_t );
+TsStatus_t ts_service_set_psk_identity( TsServiceRef_t, const uint8_t *, size_t );
+TsStatus_t ts_service_get_credential_stats( TsServiceRef_t, TsSecurityCredentialStats_t * );
+
+TsStatus_t ts_service_add_task( TsServiceRef_t, const char *, TsSchedulerHandler_t, void *, uint32_t, uint32_t, uint32_t );
+TsStatus_t ts_service_get_task_stats( TsServiceRef_t, const char *, TsSchedulerStats_t * );
 #ifdef __cplusplus
 }
 #endif
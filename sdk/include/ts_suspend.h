@@ -18,11 +18,17 @@
 
 #include "ts_status.h"
 #include "ts_message.h"
+#include "ts_log.h"
+#include "ts_firewall.h"
 
 //#define TEST_SUSPEND
 
 /**
- * Handle a version query message.
+ * Handle a suspension message.
+ * @param firewall
+ * [in] The firewall to be suspended/resumed, or NULL if there is none.
+ * @param logconfig
+ * [in] The log configuration to be suspended/resumed, or NULL if there is none.
  * @param message
  * [in] The configuration message to be handled.
  * @return
@@ -30,16 +36,18 @@
  * - TsStatusOk
  * - TsStatusError[Code]
  */
-TsStatus_t ts_suspend_handle(TsMessageRef_t);
+TsStatus_t ts_suspend_handle(TsFirewallRef_t, TsLogConfigRef_t, TsMessageRef_t);
 
 #ifdef TEST_SUSPEND
 /**
  * Generate and handle a test message.
+ * @param fw the firewall to suspend/resume, or NULL
+ * @param lc the logconfig to suspend/resume, or NULL
  * @param firewall true = suspend firewall, false = resume firewall
  * @param logconfig true = suspend logconfig, false = resume logconfig
  * @return
  */
-TsStatus_t ts_suspend_test(bool firewall, bool logconfig);
+TsStatus_t ts_suspend_test(TsFirewallRef_t fw, TsLogConfigRef_t lc, bool firewall, bool logconfig);
 #endif
 
 #endif /* TS_SUSPEND_H_ */
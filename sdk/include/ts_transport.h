@@ -64,6 +64,56 @@ typedef struct TsTransport * TsTransportRef_t;
  */
 typedef TsStatus_t (*TsTransportHandler_t)( TsTransportRef_t, void *, TsPath_t, const uint8_t *, size_t );
 
+/**
+ * The delivery guarantee requested for a message
+ */
+typedef enum {
+	TsTransportQos0 = 0,		// at most once, no acknowledgement (e.g., high-rate, loss-tolerant telemetry)
+	TsTransportQos1 = 1,		// at least once, acknowledged and retransmitted (e.g., commands and alerts)
+} TsTransportQos_t;
+
+/**
+ * A message segment, i.e., one of the (non-contiguous) parts of a message sent by speak_vector
+ */
+typedef struct TsTransportSegment {
+	const uint8_t * buffer;
+	size_t buffer_size;
+} TsTransportSegment_t;
+
+/**
+ * The publish acknowledgement callback, called with the handler data, the path of the message and
+ * TsStatusOk once the far-end acknowledged it, or an error if the message was abandoned
+ */
+typedef void (*TsTransportAckHandler_t)( TsTransportRef_t, void *, TsPath_t, TsStatus_t );
+
+/**
+ * The automatic reconnect statistics, see get_reconnect_stats
+ */
+typedef struct TsTransportReconnectStats {
+	uint32_t outages;			// connection losses (or failed dials) that started reconnecting
+	uint32_t attempts;			// dials attempted while reconnecting
+	uint32_t reconnects;		// outages ended by a successful dial
+	uint32_t backoff;			// the last backoff delay chosen (microseconds)
+	uint64_t outage;			// the duration of the current, or else the last outage (microseconds)
+	uint64_t outage_total;		// the total duration of all outages (microseconds)
+	uint64_t outage_max;		// the longest outage (microseconds)
+} TsTransportReconnectStats_t;
+
+/**
+ * The keep-alive statistics, see get_keepalive_stats
+ */
+typedef struct TsTransportKeepAliveStats {
+	uint32_t interval;			// the keep-alive interval in use (seconds)
+	uint32_t learned;			// the longest interval known to survive (seconds), zero when not yet known
+	bool converged;				// whether the adaptive mode stopped probing for a longer interval
+	uint32_t pings;				// pings answered
+	uint32_t timeouts;			// pings unanswered, i.e., the connection was lost
+	uint32_t rtt;				// the last ping round trip (microseconds)
+	uint32_t rtt_min;			// the shortest ping round trip (microseconds)
+	uint32_t rtt_max;			// the longest ping round trip (microseconds)
+	uint32_t rtt_avg;			// the average ping round trip (microseconds)
+} TsTransportKeepAliveStats_t;
+
 typedef struct TsTransport {
 	TsConnectionRef_t       _connection;
 	TsTransportHandler_t    _handler;
@@ -115,6 +165,7 @@ typedef struct TsTransportVtable {
 	 * @return
 	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
 	 * - TsStatusOk
+	 * - TsStatusOkTrying, a dial (see dial_start) is still in progress
 	 * - TsStatusError[Code]
 	 */
 	TsStatus_t (* tick)( TsTransportRef_t, uint32_t );
@@ -154,6 +205,24 @@ typedef struct TsTransportVtable {
 	 */
 	TsStatus_t (* dial)( TsTransportRef_t, TsAddress_t );
 
+	/**
+	 * Begin a dial to the given server address without waiting for the connection, i.e., the security
+	 * handshake and transport negotiation are advanced by tick within its budget. Listen may be called
+	 * while dialing, the subscription is made once connected.
+	 *
+	 * @param transport
+	 * [in] The transport object
+	 *
+	 * @param address
+	 * [in] The destination address, see dial.
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOkTrying, tick returns TsStatusOk once connected
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* dial_start)( TsTransportRef_t, TsAddress_t );
+
 	/**
 	 * Destroy (i.e., tear down) the current connection. Note that this will used the underlying
 	 * ts_connection component to tear down the connection.
@@ -171,7 +240,7 @@ typedef struct TsTransportVtable {
 	/**
 	 * Set a callback used when a message has been received by the transport. Note that
 	 * the address parameter is currently not used, and this function may only be called on
-	 * a pre-existing connection (i.e., ts_transport_dial must be called first).
+	 * a pre-existing connection (i.e., ts_transport_dial or ts_transport_dial_start must be called first).
 	 *
 	 * @param transport
 	 * [in] The transport state
@@ -217,6 +286,196 @@ typedef struct TsTransportVtable {
 	 */
 	TsStatus_t (* speak)( TsTransportRef_t, TsPath_t, const uint8_t *, size_t );
 
+	/**
+	 * Write to the driver as speak does, with the given delivery guarantee rather than the transport default.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param path
+	 *
+	 * @param buffer
+	 * [in] The pre-allocated buffer memory containing the data to be written.
+	 *
+	 * @param buffer_size
+	 * [in] The pre-allocated buffer data size
+	 *
+	 * @param qos
+	 * [in] The delivery guarantee, see TsTransportQos_t
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* speak_qos)( TsTransportRef_t, TsPath_t, const uint8_t *, size_t, TsTransportQos_t );
+
+	/**
+	 * Write to the driver as speak_qos does, with the message gathered from the given segments (e.g., an
+	 * envelope header and an encoded body) rather than one buffer, i.e., the caller doesn't have to copy
+	 * the parts together. The segments are only read during the call.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param path
+	 *
+	 * @param segments
+	 * [in] The message segments, in order
+	 *
+	 * @param count
+	 * [in] The number of segments
+	 *
+	 * @param qos
+	 * [in] The delivery guarantee, see TsTransportQos_t
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusErrorIndexOutOfRange, too many segments
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* speak_vector)( TsTransportRef_t, TsPath_t, const TsTransportSegment_t *, size_t, TsTransportQos_t );
+
+	/**
+	 * Set the number of messages that may be sent without (i.e., before) an acknowledgement from the far-end,
+	 * and the time after which an unacknowledged message is sent again. Speak returns once the message is
+	 * written, and never waits for acknowledgements, i.e., a message spoken while the window is full is
+	 * refused with TsStatusErrorNoResourceAvailable until tick has processed the acknowledgements.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param window
+	 * [in] The maximum number of unacknowledged messages, one is equivalent to stop-and-wait
+	 *
+	 * @param timeout
+	 * [in] The retransmission timeout in microseconds, or zero for the transport default
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusErrorIndexOutOfRange, the window size isn't supported
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* set_window)( TsTransportRef_t, size_t, uint32_t );
+
+	/**
+	 * Set a callback used when a message sent by speak has been acknowledged, or abandoned.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param handler
+	 * [in] The function to call, or NULL to remove the callback
+	 *
+	 * @param handler_data
+	 * [in] A optional pointer sent to the handler
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* set_ack_handler)( TsTransportRef_t, TsTransportAckHandler_t, void * );
+
+	/**
+	 * Set the automatic reconnect policy. When the connection is lost (or a dial fails), tick
+	 * re-dials the last dialed address after a randomized, exponentially increasing backoff,
+	 * restores the subscriptions and resends the unacknowledged messages, returning TsStatusOkTrying
+	 * meanwhile. The randomization keeps a fleet from reconnecting in lock-step after an outage.
+	 * Hangup stops reconnecting until the next dial.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param min_backoff
+	 * [in] The backoff (microseconds) before the first attempt, or zero to disable reconnecting
+	 *
+	 * @param max_backoff
+	 * [in] The largest backoff (microseconds), the backoff doubles with each failed attempt up to this
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* set_reconnect)( TsTransportRef_t, uint32_t, uint32_t );
+
+	/**
+	 * Return the automatic reconnect statistics.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param stats
+	 * [in/out] The pointer to the statistics to be filled
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* get_reconnect_stats)( TsTransportRef_t, TsTransportReconnectStats_t * );
+
+	/**
+	 * Set the keep-alive interval, applied on the next dial. When the maximum is greater than the
+	 * interval, the keep-alive is adaptive, i.e., it probes for the longest interval (up to the maximum)
+	 * that the network (e.g., a carrier NAT) keeps an idle connection for, and only pings when nothing
+	 * else was sent within the interval. An unanswered ping ends the probing at the last answered
+	 * interval, which is persisted where the transport supports it (see get_keepalive_stats).
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param interval
+	 * [in] The (initial) keep-alive interval in seconds
+	 *
+	 * @param max_interval
+	 * [in] The largest interval probed in seconds, or zero (or the interval) for a fixed keep-alive
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* set_keepalive)( TsTransportRef_t, uint32_t, uint32_t );
+
+	/**
+	 * Return the keep-alive statistics, including the ping round trip times (i.e., a link-health metric).
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param stats
+	 * [in/out] The pointer to the statistics to be filled
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* get_keepalive_stats)( TsTransportRef_t, TsTransportKeepAliveStats_t * );
+
+	/**
+	 * Enable or disable write coalescing, i.e., small packets (e.g., acknowledgements, pings and
+	 * back-to-back messages) are merged into one connection write up to the connection MTU, and written
+	 * on tick, before reading, or when the buffer is full. This trades a little latency for fewer
+	 * TLS records and driver writes.
+	 *
+	 * @param transport
+	 * [in] The transport state
+	 *
+	 * @param enable
+	 * [in] True to merge writes, false to write each packet immediately (the default)
+	 *
+	 * @return
+	 * The return status (TsStatus_t) of the function, see ts_status.h for more information.
+	 * - TsStatusOk
+	 * - TsStatusError[Code]
+	 */
+	TsStatus_t (* set_coalescing)( TsTransportRef_t, bool );
+
 } TsTransportVtable_t;
 
 #ifdef __cplusplus
@@ -232,9 +491,20 @@ extern const TsTransportVtable_t * ts_transport;
 #define ts_transport_get_connection ts_transport->get_connection
 
 #define ts_transport_dial   ts_transport->dial
+#define ts_transport_dial_start ts_transport->dial_start
 #define ts_transport_hangup ts_transport->hangup
 #define ts_transport_listen ts_transport->listen
 #define ts_transport_speak  ts_transport->speak
+#define ts_transport_speak_qos  ts_transport->speak_qos
+#define ts_transport_speak_vector  ts_transport->speak_vector
+
+#define ts_transport_set_window         ts_transport->set_window
+#define ts_transport_set_ack_handler    ts_transport->set_ack_handler
+#define ts_transport_set_reconnect      ts_transport->set_reconnect
+#define ts_transport_get_reconnect_stats ts_transport->get_reconnect_stats
+#define ts_transport_set_keepalive      ts_transport->set_keepalive
+#define ts_transport_get_keepalive_stats ts_transport->get_keepalive_stats
+#define ts_transport_set_coalescing     ts_transport->set_coalescing
 
 #ifdef __cplusplus
 extern "C" {
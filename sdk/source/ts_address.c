@@ -9,7 +9,7 @@
  * port array.
  * @param address
  * The string (i.e., zero terminated character array) containing the host and port
- * as, [HOST] ':' [PORT], e.g., 'verizon.com:8080'
+ * as, [SCHEME '://'] [HOST] ':' [PORT], e.g., 'verizon.com:8080'
  * @param host
  * A copy host section of the address.
  * @param port
@@ -19,6 +19,11 @@
  * TsStatusOk otherwise.
  */
 TsStatus_t ts_address_parse(TsAddress_t address, char * host, char * port) {
+	if( strncmp(address, TS_ADDRESS_STREAM_SCHEME, strlen(TS_ADDRESS_STREAM_SCHEME)) == 0 ) {
+		address = address + strlen(TS_ADDRESS_STREAM_SCHEME);
+	} else if( ts_address_is_datagram(address) ) {
+		address = address + strlen(TS_ADDRESS_DATAGRAM_SCHEME);
+	}
 	int host_length = 0;
 	size_t address_length = strlen(address), port_length = 0;
 	char * port_start = NULL;
@@ -40,3 +45,14 @@ TsStatus_t ts_address_parse(TsAddress_t address, char * host, char * port) {
 	}
 	return TsStatusErrorBadRequest;
 }
+
+/**
+ * Return whether the given address begins with the datagram scheme, i.e., 'udp://'.
+ * @param address
+ * The string (i.e., zero terminated character array) containing the address.
+ * @return
+ * True for a datagram address, false otherwise.
+ */
+bool ts_address_is_datagram(TsAddress_t address) {
+	return strncmp(address, TS_ADDRESS_DATAGRAM_SCHEME, strlen(TS_ADDRESS_DATAGRAM_SCHEME)) == 0;
+}
@@ -50,7 +50,11 @@ TsStatus_t ts_connection_tick( TsConnectionRef_t connection, uint32_t budget ) {
 	ts_status_trace( "ts_connection_tick\n" );
 	ts_platform_assert( ts_security != NULL );
 	ts_platform_assert( connection != NULL );
-	ts_platform_assert( budget > 0 );
+
+	// nothing can be done without a budget
+	if( budget == 0 ) {
+		return TsStatusOk;
+	}
 
 	uint64_t timestamp = ts_platform_time();
 	TsStatus_t status = ts_security_tick( connection->_security, budget );
@@ -170,6 +174,119 @@ TsStatus_t ts_connection_connect( TsConnectionRef_t connection, TsAddress_t addr
 	return ts_security_connect( connection->_security, address );
 }
 
+TsStatus_t ts_connection_connect_start( TsConnectionRef_t connection, TsAddress_t address ) {
+
+	ts_status_trace( "ts_connection_connect_start\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+	ts_platform_assert( address != NULL );
+
+	// custom security components may only provide the blocking connect
+	if( ts_security->connect_start == NULL ) {
+		return ts_security_connect( connection->_security, address );
+	}
+	return ts_security_connect_start( connection->_security, address );
+}
+
+TsStatus_t ts_connection_handshake( TsConnectionRef_t connection, uint32_t budget ) {
+
+	ts_status_trace( "ts_connection_handshake\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+
+	// without connect_start (or handshake) the blocking connect already completed the handshake
+	if( ts_security->connect_start == NULL || ts_security->handshake == NULL ) {
+		return TsStatusOk;
+	}
+	// the handshake is left for the next call without a budget
+	if( budget == 0 ) {
+		return TsStatusOkTrying;
+	}
+	return ts_security_handshake( connection->_security, budget );
+}
+
+TsStatus_t ts_connection_set_resumption( TsConnectionRef_t connection, bool enable ) {
+
+	ts_status_trace( "ts_connection_set_resumption\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+
+	if( ts_security->set_resumption == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_security_set_resumption( connection->_security, enable );
+}
+
+TsStatus_t ts_connection_get_session_stats( TsConnectionRef_t connection, TsSecuritySessionStats_t * stats ) {
+
+	ts_status_trace( "ts_connection_get_session_stats\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+	ts_platform_assert( stats != NULL );
+
+	if( ts_security->get_session_stats == NULL ) {
+		memset( stats, 0x00, sizeof( TsSecuritySessionStats_t ));
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_security_get_session_stats( connection->_security, stats );
+}
+
+TsStatus_t ts_connection_get_memory_stats( TsConnectionRef_t connection, TsSecurityMemoryStats_t * stats ) {
+
+	ts_status_trace( "ts_connection_get_memory_stats\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+	ts_platform_assert( stats != NULL );
+
+	if( ts_security->get_memory_stats == NULL ) {
+		memset( stats, 0x00, sizeof( TsSecurityMemoryStats_t ));
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_security_get_memory_stats( connection->_security, stats );
+}
+
+TsStatus_t ts_connection_set_psk( TsConnectionRef_t connection, const uint8_t * psk, size_t psk_size ) {
+
+	ts_status_trace( "ts_connection_set_psk\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+	ts_platform_assert( psk != NULL );
+	ts_platform_assert( psk_size > 0 );
+
+	if( ts_security->set_psk == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_security_set_psk( connection->_security, psk, psk_size );
+}
+
+TsStatus_t ts_connection_set_psk_identity( TsConnectionRef_t connection, const uint8_t * identity, size_t identity_size ) {
+
+	ts_status_trace( "ts_connection_set_psk_identity\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+	ts_platform_assert( identity != NULL );
+	ts_platform_assert( identity_size > 0 );
+
+	if( ts_security->set_psk_identity == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_security_set_psk_identity( connection->_security, identity, identity_size );
+}
+
+TsStatus_t ts_connection_get_credential_stats( TsConnectionRef_t connection, TsSecurityCredentialStats_t * stats ) {
+
+	ts_status_trace( "ts_connection_get_credential_stats\n" );
+	ts_platform_assert( ts_security != NULL );
+	ts_platform_assert( connection != NULL );
+	ts_platform_assert( stats != NULL );
+
+	if( ts_security->get_credential_stats == NULL ) {
+		memset( stats, 0x00, sizeof( TsSecurityCredentialStats_t ));
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_security_get_credential_stats( connection->_security, stats );
+}
+
 TsStatus_t ts_connection_disconnect( TsConnectionRef_t connection ) {
 
 	ts_status_trace( "ts_connection_disconnect\n" );
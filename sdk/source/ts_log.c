@@ -22,7 +22,7 @@ TsStatus_t _ts_log_report(TsLogConfigRef_t);
  * - TsStatusOk
  * - TsStatusError[Code]
  */
-TsStatus_t ts_logconfig_create(TsLogConfigRef_t *logconfig, TsStatus_t (*messageCallback)(TsMessageRef_t, char *)) {
+TsStatus_t ts_logconfig_create(TsLogConfigRef_t *logconfig, TsStatus_t (*messageCallback)(void *, TsMessageRef_t, char *), void *messageContext) {
 	ts_status_trace("ts_logconfig_create");
 	ts_platform_assert(logconfig != NULL);
 	*logconfig = (TsLogConfigRef_t)ts_platform_malloc(sizeof(TsLogConfig_t));
@@ -34,12 +34,11 @@ TsStatus_t ts_logconfig_create(TsLogConfigRef_t *logconfig, TsStatus_t (*message
 	(*logconfig)->_reporting_interval = 15;
 	(*logconfig)->_last_report_time = 0;
 	(*logconfig)->_messageCallback = messageCallback;
+	(*logconfig)->_messageContext = messageContext;
 
 	// Allocate some space for messages
 	_ts_log_create(*logconfig, 15);
 
-	ts_suspend_set_logconfig(*logconfig);
-
 #ifdef TEST_CONFIG
 	(*logconfig)->_enabled = true;
 #endif
@@ -523,7 +522,7 @@ TsStatus_t _ts_log_report(TsLogConfigRef_t log) {
 
 		// Send it off
 		ts_message_dump(report);
-		log->_messageCallback(report, "ts.event.log");
+		log->_messageCallback(log->_messageContext, report, "ts.event.log");
 
 		ts_message_destroy(report);
 	}
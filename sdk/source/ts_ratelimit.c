@@ -0,0 +1,264 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_ratelimit.h"
+
+#define TOKEN_SCALE 1000000
+
+static void _ts_bucket_set( TsRateLimitBucket_t * bucket, uint32_t rate ) {
+	bucket->_rate = rate;
+	bucket->_burst = rate;
+	bucket->_tokens = (int64_t)rate * TOKEN_SCALE;
+}
+
+static void _ts_bucket_refill( TsRateLimitBucket_t * bucket, uint64_t elapsed ) {
+	if( bucket->_rate == 0 ) {
+		return;
+	}
+	// tokens are held in millionths, so tokens-per-second times microseconds needs no division,
+	// and any debt (i.e., a negative balance) is paid back at the rate before the bucket is full
+	int64_t capacity = (int64_t)bucket->_burst * TOKEN_SCALE;
+	if( bucket->_tokens >= capacity ) {
+		return;
+	}
+	uint64_t missing = (uint64_t)( capacity - bucket->_tokens );
+	if( elapsed > missing / bucket->_rate ) {
+		bucket->_tokens = capacity;
+	} else {
+		bucket->_tokens = bucket->_tokens + (int64_t)( elapsed * bucket->_rate );
+	}
+}
+
+static bool _ts_bucket_permits( TsRateLimitBucket_t * bucket, size_t tokens ) {
+	if( bucket->_rate == 0 ) {
+		return true;
+	}
+	// an oversized request is permitted on a full bucket, and the debt is paid back by waiting
+	size_t required = tokens < bucket->_burst ? tokens : bucket->_burst;
+	return bucket->_tokens >= (int64_t)required * TOKEN_SCALE;
+}
+
+static void _ts_bucket_consume( TsRateLimitBucket_t * bucket, size_t tokens ) {
+	if( bucket->_rate != 0 ) {
+		bucket->_tokens = bucket->_tokens - (int64_t)tokens * TOKEN_SCALE;
+	}
+}
+
+static void _ts_ratelimit_refill( TsRateLimitRef_t ratelimit ) {
+	uint64_t now = ts_platform_time();
+	uint64_t elapsed = now - ratelimit->_last_refill;
+	ratelimit->_last_refill = now;
+	_ts_bucket_refill( &(ratelimit->_messages), elapsed );
+	_ts_bucket_refill( &(ratelimit->_bytes), elapsed );
+}
+
+static bool _ts_ratelimit_permits( TsRateLimitRef_t ratelimit, size_t size ) {
+	return _ts_bucket_permits( &(ratelimit->_messages), 1 ) && _ts_bucket_permits( &(ratelimit->_bytes), size );
+}
+
+// a transport without speak_vector is handed the (single) buffer as ts_service_speak would
+static TsStatus_t _ts_ratelimit_transmit( TsTransportRef_t transport, TsPath_t path, const TsTransportSegment_t * segments, size_t count, TsTransportQos_t qos ) {
+	if( ts_transport->speak_vector != NULL ) {
+		return ts_transport_speak_vector( transport, path, segments, count, qos );
+	}
+	if( count != 1 ) {
+		return TsStatusErrorNotImplemented;
+	}
+	if( ts_transport->speak_qos != NULL ) {
+		return ts_transport_speak_qos( transport, path, segments[ 0 ].buffer, segments[ 0 ].buffer_size, qos );
+	}
+	if( qos == TsTransportQos0 ) {
+		return ts_transport_speak( transport, path, segments[ 0 ].buffer, segments[ 0 ].buffer_size );
+	}
+	return TsStatusErrorNotImplemented;
+}
+
+static TsStatus_t _ts_ratelimit_send( TsRateLimitRef_t ratelimit, TsTransportRef_t transport, TsPath_t path, const TsTransportSegment_t * segments, size_t count, size_t buffer_size, TsTransportQos_t qos ) {
+	TsStatus_t status = _ts_ratelimit_transmit( transport, path, segments, count, qos );
+	if( status == TsStatusOk ) {
+		_ts_bucket_consume( &(ratelimit->_messages), 1 );
+		_ts_bucket_consume( &(ratelimit->_bytes), buffer_size );
+		ratelimit->_stats.bytes = ratelimit->_stats.bytes + (uint32_t)buffer_size;
+	}
+	return status;
+}
+
+static void _ts_ratelimit_release( TsRateLimitEntry_t * entry ) {
+	ts_platform_free( entry->_path, strlen( entry->_path ) + 1 );
+	ts_platform_free( entry->_buffer, entry->_size );
+	memset( entry, 0x00, sizeof( TsRateLimitEntry_t ) );
+}
+
+TsStatus_t ts_ratelimit_create( TsRateLimitRef_t * ratelimit ) {
+
+	ts_status_trace( "ts_ratelimit_create\n" );
+	ts_platform_assert( ratelimit != NULL );
+
+	*ratelimit = (TsRateLimitRef_t)ts_platform_malloc( sizeof( TsRateLimit_t ) );
+	if( *ratelimit == NULL ) {
+		return TsStatusErrorOutOfMemory;
+	}
+	memset( *ratelimit, 0x00, sizeof( TsRateLimit_t ) );
+	(*ratelimit)->_policy = TsRateLimitPolicyDrop;
+	(*ratelimit)->_last_refill = ts_platform_time();
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_ratelimit_destroy( TsRateLimitRef_t ratelimit ) {
+
+	ts_status_trace( "ts_ratelimit_destroy\n" );
+	ts_platform_assert( ratelimit != NULL );
+
+	while( ratelimit->_queue_count > 0 ) {
+		_ts_ratelimit_release( &(ratelimit->_queue[ ratelimit->_queue_head ]) );
+		ratelimit->_queue_head = ( ratelimit->_queue_head + 1 ) % TS_RATELIMIT_MAX_QUEUE;
+		ratelimit->_queue_count = ratelimit->_queue_count - 1;
+	}
+	ts_platform_free( ratelimit, sizeof( TsRateLimit_t ) );
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_ratelimit_set( TsRateLimitRef_t ratelimit, uint32_t messages, uint32_t bytes, TsRateLimitPolicy_t policy ) {
+
+	ts_status_trace( "ts_ratelimit_set\n" );
+	ts_platform_assert( ratelimit != NULL );
+
+	_ts_bucket_set( &(ratelimit->_messages), messages );
+	_ts_bucket_set( &(ratelimit->_bytes), bytes );
+	ratelimit->_policy = policy;
+	ratelimit->_last_refill = ts_platform_time();
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_ratelimit_speak( TsRateLimitRef_t ratelimit, TsTransportRef_t transport, TsPath_t path, const uint8_t * buffer, size_t buffer_size, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_ratelimit_speak\n" );
+	ts_platform_assert( buffer != NULL );
+
+	TsTransportSegment_t segment;
+	segment.buffer = buffer;
+	segment.buffer_size = buffer_size;
+	return ts_ratelimit_speak_vector( ratelimit, transport, path, &segment, 1, qos );
+}
+
+TsStatus_t ts_ratelimit_speak_vector( TsRateLimitRef_t ratelimit, TsTransportRef_t transport, TsPath_t path, const TsTransportSegment_t * segments, size_t count, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_ratelimit_speak_vector\n" );
+	ts_platform_assert( ratelimit != NULL );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( path != NULL );
+	ts_platform_assert( segments != NULL );
+
+	size_t buffer_size = 0;
+	for( size_t index = 0; index < count; index++ ) {
+		buffer_size = buffer_size + segments[ index ].buffer_size;
+	}
+
+	// release any backlog first, so that messages are never reordered
+	ts_ratelimit_tick( ratelimit, transport );
+
+	_ts_ratelimit_refill( ratelimit );
+	if( ratelimit->_queue_count == 0 && _ts_ratelimit_permits( ratelimit, buffer_size ) ) {
+		TsStatus_t status = _ts_ratelimit_send( ratelimit, transport, path, segments, count, buffer_size, qos );
+		if( status == TsStatusOk ) {
+			ratelimit->_stats.accepted = ratelimit->_stats.accepted + 1;
+		}
+		return status;
+	}
+
+	// apply policy to excess traffic
+	if( ratelimit->_policy == TsRateLimitPolicyDrop || ratelimit->_queue_count >= TS_RATELIMIT_MAX_QUEUE ) {
+		ts_status_debug( "ts_ratelimit_speak: rate exceeded, dropping %d bytes\n", buffer_size );
+		ratelimit->_stats.dropped = ratelimit->_stats.dropped + 1;
+		return TsStatusErrorNoResourceAvailable;
+	}
+
+	size_t path_size = strlen( path ) + 1;
+	size_t index = ( ratelimit->_queue_head + ratelimit->_queue_count ) % TS_RATELIMIT_MAX_QUEUE;
+	TsRateLimitEntry_t * entry = &(ratelimit->_queue[ index ]);
+	entry->_path = (char *)ts_platform_malloc( path_size );
+	entry->_buffer = (uint8_t *)ts_platform_malloc( buffer_size );
+	if( entry->_path == NULL || entry->_buffer == NULL ) {
+		if( entry->_path != NULL ) {
+			ts_platform_free( entry->_path, path_size );
+		}
+		if( entry->_buffer != NULL ) {
+			ts_platform_free( entry->_buffer, buffer_size );
+		}
+		memset( entry, 0x00, sizeof( TsRateLimitEntry_t ) );
+		ratelimit->_stats.dropped = ratelimit->_stats.dropped + 1;
+		return TsStatusErrorOutOfMemory;
+	}
+	memcpy( entry->_path, path, path_size );
+	size_t offset = 0;
+	for( size_t index = 0; index < count; index++ ) {
+		memcpy( entry->_buffer + offset, segments[ index ].buffer, segments[ index ].buffer_size );
+		offset = offset + segments[ index ].buffer_size;
+	}
+	entry->_size = buffer_size;
+	entry->_qos = qos;
+	entry->_failures = 0;
+	ratelimit->_queue_count = ratelimit->_queue_count + 1;
+	ratelimit->_stats.pending = (uint32_t)ratelimit->_queue_count;
+
+	ts_status_debug( "ts_ratelimit_speak: rate exceeded, queued %d bytes\n", buffer_size );
+	return TsStatusOkWritePending;
+}
+
+TsStatus_t ts_ratelimit_tick( TsRateLimitRef_t ratelimit, TsTransportRef_t transport ) {
+
+	ts_status_trace( "ts_ratelimit_tick\n" );
+	ts_platform_assert( ratelimit != NULL );
+	ts_platform_assert( transport != NULL );
+
+	_ts_ratelimit_refill( ratelimit );
+	while( ratelimit->_queue_count > 0 ) {
+
+		TsRateLimitEntry_t * entry = &(ratelimit->_queue[ ratelimit->_queue_head ]);
+		if( !_ts_ratelimit_permits( ratelimit, entry->_size ) ) {
+			break;
+		}
+
+		// keep the entry on a transport failure, it'll be retried on the next tick (up to a limit)
+		TsTransportSegment_t segment;
+		segment.buffer = entry->_buffer;
+		segment.buffer_size = entry->_size;
+		TsStatus_t status = _ts_ratelimit_send( ratelimit, transport, entry->_path, &segment, 1, entry->_size, entry->_qos );
+		if( status != TsStatusOk ) {
+			entry->_failures = entry->_failures + 1;
+			if( entry->_failures < TS_RATELIMIT_MAX_RETRIES ) {
+				ts_status_debug( "ts_ratelimit_tick: failed to send queued message, %s\n", ts_status_string( status ) );
+				return status;
+			}
+			ts_status_alarm( "ts_ratelimit_tick: dropping queued message after %u failures, %s\n", entry->_failures, ts_status_string( status ) );
+			ratelimit->_stats.dropped = ratelimit->_stats.dropped + 1;
+		} else {
+			ratelimit->_stats.deferred = ratelimit->_stats.deferred + 1;
+		}
+
+		_ts_ratelimit_release( entry );
+		ratelimit->_queue_head = ( ratelimit->_queue_head + 1 ) % TS_RATELIMIT_MAX_QUEUE;
+		ratelimit->_queue_count = ratelimit->_queue_count - 1;
+		ratelimit->_stats.pending = (uint32_t)ratelimit->_queue_count;
+		if( status != TsStatusOk ) {
+			return status;
+		}
+	}
+	ratelimit->_stats.pending = (uint32_t)ratelimit->_queue_count;
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_ratelimit_get_stats( TsRateLimitRef_t ratelimit, TsRateLimitStats_t * stats ) {
+
+	ts_status_trace( "ts_ratelimit_get_stats\n" );
+	ts_platform_assert( ratelimit != NULL );
+	ts_platform_assert( stats != NULL );
+
+	*stats = ratelimit->_stats;
+	return TsStatusOk;
+}
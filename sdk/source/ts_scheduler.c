@@ -0,0 +1,193 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <stdbool.h>
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_scheduler.h"
+
+static uint64_t _ts_task_deadline( TsSchedulerTask_t * task ) {
+	return task->_release + ( task->_deadline != 0 ? task->_deadline : task->_period );
+}
+
+static uint32_t _ts_task_reserve( TsSchedulerTask_t * task, uint32_t budget ) {
+	return (uint32_t)( ( (uint64_t)budget * task->_share ) / 100 );
+}
+
+TsStatus_t ts_scheduler_create( TsSchedulerRef_t * scheduler ) {
+
+	ts_status_trace( "ts_scheduler_create\n" );
+	ts_platform_assert( scheduler != NULL );
+
+	*scheduler = (TsSchedulerRef_t)ts_platform_malloc( sizeof( TsScheduler_t ) );
+	if( *scheduler == NULL ) {
+		return TsStatusErrorOutOfMemory;
+	}
+	memset( *scheduler, 0x00, sizeof( TsScheduler_t ) );
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_scheduler_destroy( TsSchedulerRef_t scheduler ) {
+
+	ts_status_trace( "ts_scheduler_destroy\n" );
+	ts_platform_assert( scheduler != NULL );
+
+	ts_platform_free( scheduler, sizeof( TsScheduler_t ) );
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_scheduler_add( TsSchedulerRef_t scheduler, const char * name, TsSchedulerHandler_t handler, void * state, uint32_t period, uint32_t deadline, uint32_t share ) {
+
+	ts_status_trace( "ts_scheduler_add\n" );
+	ts_platform_assert( scheduler != NULL );
+	ts_platform_assert( name != NULL );
+	ts_platform_assert( handler != NULL );
+
+	if( scheduler->_count >= TS_SCHEDULER_MAX_TASKS || scheduler->_shares + share > 100 ) {
+		ts_status_alarm( "ts_scheduler_add: cannot add task '%s', %d tasks, %d%% shared\n", name, scheduler->_count, scheduler->_shares );
+		return TsStatusErrorIndexOutOfRange;
+	}
+
+	TsSchedulerTask_t * task = &(scheduler->_tasks[ scheduler->_count ]);
+	memset( task, 0x00, sizeof( TsSchedulerTask_t ) );
+	task->_name = name;
+	task->_handler = handler;
+	task->_state = state;
+	task->_period = period;
+	task->_deadline = deadline;
+	task->_share = share;
+	task->_release = ts_platform_time();
+	task->_stats.status = TsStatusOk;
+
+	scheduler->_count = scheduler->_count + 1;
+	scheduler->_shares = scheduler->_shares + share;
+
+	return TsStatusOk;
+}
+
+TsStatus_t ts_scheduler_tick( TsSchedulerRef_t scheduler, uint32_t budget ) {
+
+	ts_status_trace( "ts_scheduler_tick\n" );
+	ts_platform_assert( scheduler != NULL );
+
+	// determine which tasks are due, tasks without a period are released on every tick
+	bool due[ TS_SCHEDULER_MAX_TASKS ];
+	uint64_t timestamp = ts_platform_time();
+	for( size_t index = 0; index < scheduler->_count; index++ ) {
+		TsSchedulerTask_t * task = &(scheduler->_tasks[ index ]);
+		if( task->_period == 0 ) {
+			task->_release = timestamp;
+		}
+		due[ index ] = ( timestamp >= task->_release );
+	}
+
+	TsStatus_t result = TsStatusOk;
+	while( true ) {
+
+		// pick the due task with the earliest deadline, and total the shares reserved by the others
+		TsSchedulerTask_t * task = NULL;
+		size_t selected = 0;
+		uint64_t reserved = 0;
+		for( size_t index = 0; index < scheduler->_count; index++ ) {
+			if( !due[ index ] ) {
+				continue;
+			}
+			TsSchedulerTask_t * candidate = &(scheduler->_tasks[ index ]);
+			reserved = reserved + _ts_task_reserve( candidate, budget );
+			if( task == NULL || _ts_task_deadline( candidate ) < _ts_task_deadline( task ) ) {
+				task = candidate;
+				selected = index;
+			}
+		}
+		if( task == NULL ) {
+			break;
+		}
+		due[ selected ] = false;
+		reserved = reserved - _ts_task_reserve( task, budget );
+
+		// the task gets whatever is left, less what is reserved for the tasks still to run, but never less than its own share
+		uint64_t start = ts_platform_time();
+		uint64_t elapsed = start - timestamp;
+		uint64_t remaining = ( elapsed >= budget ) ? 0 : budget - elapsed;
+		uint32_t slice = (uint32_t)( ( remaining > reserved ) ? remaining - reserved : 0 );
+		if( slice < _ts_task_reserve( task, budget ) ) {
+			slice = _ts_task_reserve( task, budget );
+		}
+
+		// a task without a share is deferred when nothing is left, i.e., it stays due for the next tick
+		if( slice == 0 ) {
+			task->_stats.deferrals = task->_stats.deferrals + 1;
+			continue;
+		}
+
+		// tasks without a period or a deadline are never late
+		bool bounded = ( task->_period != 0 || task->_deadline != 0 );
+		if( bounded && start > _ts_task_deadline( task ) ) {
+			task->_stats.misses = task->_stats.misses + 1;
+		}
+
+		TsStatus_t status = task->_handler( task->_state, slice );
+
+		uint64_t finish = ts_platform_time();
+		uint32_t runtime = (uint32_t)( finish - start );
+		task->_stats.runs = task->_stats.runs + 1;
+		task->_stats.runtime = task->_stats.runtime + runtime;
+		task->_stats.status = status;
+		if( runtime > task->_stats.runtime_max ) {
+			task->_stats.runtime_max = runtime;
+		}
+		if( runtime > slice ) {
+			ts_status_debug( "ts_scheduler_tick: task '%s' overran, %u of %u usec\n", task->_name, runtime, slice );
+			task->_stats.overruns = task->_stats.overruns + 1;
+		}
+		if( status != TsStatusOk && result == TsStatusOk ) {
+			result = status;
+		}
+
+		// schedule the next release, skipping any periods already missed
+		if( task->_period != 0 ) {
+			task->_release = task->_release + task->_period;
+			if( task->_release <= finish ) {
+				task->_release = finish + task->_period;
+			}
+		}
+	}
+
+	return result;
+}
+
+TsStatus_t ts_scheduler_get_stats( TsSchedulerRef_t scheduler, const char * name, TsSchedulerStats_t * stats ) {
+
+	ts_status_trace( "ts_scheduler_get_stats\n" );
+	ts_platform_assert( scheduler != NULL );
+	ts_platform_assert( name != NULL );
+	ts_platform_assert( stats != NULL );
+
+	for( size_t index = 0; index < scheduler->_count; index++ ) {
+		if( strcmp( scheduler->_tasks[ index ]._name, name ) == 0 ) {
+			*stats = scheduler->_tasks[ index ]._stats;
+			return TsStatusOk;
+		}
+	}
+	return TsStatusErrorNotFound;
+}
+
+TsStatus_t ts_scheduler_report( TsSchedulerRef_t scheduler ) {
+
+	ts_status_trace( "ts_scheduler_report\n" );
+	ts_platform_assert( scheduler != NULL );
+
+	// the report is compiled out along with the info messages (i.e., NDEBUG)
+#ifndef NDEBUG
+	for( size_t index = 0; index < scheduler->_count; index++ ) {
+		TsSchedulerTask_t * task = &(scheduler->_tasks[ index ]);
+		ts_status_info( "ts_scheduler_report: %s, runs %u, avg %u usec, max %u usec, overruns %u, misses %u, deferrals %u, last %s\n",
+			task->_name, task->_stats.runs,
+			task->_stats.runs == 0 ? 0 : (uint32_t)( task->_stats.runtime / task->_stats.runs ),
+			task->_stats.runtime_max, task->_stats.overruns, task->_stats.misses, task->_stats.deferrals,
+			ts_status_string( task->_stats.status ) );
+	}
+#endif
+	return TsStatusOk;
+}
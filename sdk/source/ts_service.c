@@ -4,6 +4,9 @@
 #include "ts_suspend.h"
 #include "ts_version.h"
 
+static TsStatus_t _ts_service_schedule( TsServiceRef_t );
+static void _ts_service_connected( TsServiceRef_t );
+
 TsStatus_t ts_service_create( TsServiceRef_t * service ) {
 
 	ts_status_trace( "ts_service_create\n" );
@@ -36,6 +39,16 @@ TsStatus_t ts_service_create( TsServiceRef_t * service ) {
 		return status;
 	}
 
+	// and register the subsystems that share the tick budget
+	status = _ts_service_schedule( *service );
+	if( status != TsStatusOk ) {
+		ts_service->destroy( *service );
+		ts_transport_destroy( transport );
+		ts_platform_free( *service, sizeof( TsService_t ) );
+		*service = NULL;
+		return status;
+	}
+
 	return TsStatusOk;
 }
 
@@ -49,6 +62,12 @@ TsStatus_t ts_service_destroy( TsServiceRef_t service ) {
 	ts_platform_assert( service->_transport != NULL );
 
 	ts_service->destroy( service );
+	if( service->_ratelimit != NULL ) {
+		ts_ratelimit_destroy( service->_ratelimit );
+	}
+	if( service->_scheduler != NULL ) {
+		ts_scheduler_destroy( service->_scheduler );
+	}
 	ts_transport_destroy( service->_transport );
 	ts_platform_free( service, sizeof( TsService_t ) );
 
@@ -60,6 +79,87 @@ TsStatus_t ts_service_destroy( TsServiceRef_t service ) {
 	bool suspend = false;
 #endif
 
+static TsStatus_t _ts_service_task_ratelimit( void * state, uint32_t budget ) {
+
+	TsServiceRef_t service = (TsServiceRef_t)state;
+	if( service->_ratelimit == NULL ) {
+		return TsStatusOk;
+	}
+	return ts_ratelimit_tick( service->_ratelimit, service->_transport );
+}
+
+static TsStatus_t _ts_service_task_service( void * state, uint32_t budget ) {
+
+	TsStatus_t status = ts_service->tick( (TsServiceRef_t)state, budget );
+	if( status != TsStatusOk ) {
+		ts_status_alarm( "ts_service_tick: failed protocol phase, %s, ignoring,...\n", ts_status_string(status) );
+	}
+	return status;
+}
+
+static TsStatus_t _ts_service_task_logconfig( void * state, uint32_t budget ) {
+
+	return ts_logconfig_tick( ((TsServiceRef_t)state)->_logconfig, budget );
+}
+
+#ifdef TS_ODS_ENABLED
+static TsStatus_t _ts_service_task_firewall( void * state, uint32_t budget ) {
+
+	return ts_firewall_tick( ((TsServiceRef_t)state)->_firewall, budget );
+}
+#endif
+
+static TsStatus_t _ts_service_task_transport( void * state, uint32_t budget ) {
+
+	// TODO - return may require user action, e.g., TsStatusErrorConnectionReset - or add processing here.
+	TsServiceRef_t service = (TsServiceRef_t)state;
+	TsStatus_t status = ts_transport_tick( service->_transport, budget );
+	if( service->_dialing && status != TsStatusOkTrying ) {
+		service->_dialing = false;
+		if( status == TsStatusOk ) {
+			_ts_service_connected( service );
+		}
+	}
+	return status;
+}
+
+/**
+ * Register the SDK subsystems with the service scheduler. The shares leave room for
+ * application tasks (see ts_service_add_task), and the transport, registered last, also
+ * receives whatever budget the others leave unused.
+ */
+static TsStatus_t _ts_service_schedule( TsServiceRef_t service ) {
+
+	TsStatus_t status = ts_scheduler_create( &(service->_scheduler) );
+	if( status != TsStatusOk ) {
+		service->_scheduler = NULL;
+		return status;
+	}
+
+	status = ts_scheduler_add( service->_scheduler, "ratelimit", _ts_service_task_ratelimit, service, 0, 0, 0 );
+	if( status == TsStatusOk ) {
+		status = ts_scheduler_add( service->_scheduler, "service", _ts_service_task_service, service, 0, 0, 5 );
+	}
+	if( status == TsStatusOk && service->_logconfig != NULL ) {
+		status = ts_scheduler_add( service->_scheduler, "logconfig", _ts_service_task_logconfig, service, TS_TIME_SEC_TO_USEC, 0, 5 );
+	}
+#ifdef TS_ODS_ENABLED
+	if( status == TsStatusOk && service->_firewall != NULL ) {
+		status = ts_scheduler_add( service->_scheduler, "firewall", _ts_service_task_firewall, service, 0, 0, 5 );
+	}
+#endif
+	if( status == TsStatusOk ) {
+		status = ts_scheduler_add( service->_scheduler, TS_SERVICE_TASK_TRANSPORT, _ts_service_task_transport, service, 0, 0, 70 );
+	}
+
+	// the service cannot run without all of its subsystems, the transport in particular
+	if( status != TsStatusOk ) {
+		ts_scheduler_destroy( service->_scheduler );
+		service->_scheduler = NULL;
+	}
+	return status;
+}
+
 TsStatus_t ts_service_tick( TsServiceRef_t service, uint32_t budget ) {
 
 	ts_status_trace( "ts_service_tick\n" );
@@ -67,51 +167,45 @@ TsStatus_t ts_service_tick( TsServiceRef_t service, uint32_t budget ) {
 	ts_platform_assert( ts_transport != NULL );
 	ts_platform_assert( service != NULL );
 	ts_platform_assert( service->_transport != NULL );
+	ts_platform_assert( service->_scheduler != NULL );
 
-	// perform service tick
-	uint64_t timestamp = ts_platform_time();
-	TsStatus_t status = ts_service->tick( service, budget );
+	TsSchedulerStats_t before, after;
+	TsStatus_t status = ts_scheduler_get_stats( service->_scheduler, TS_SERVICE_TASK_TRANSPORT, &before );
 	if( status != TsStatusOk ) {
-		ts_status_alarm( "ts_service_tick: failed protocol phase, %s, ignoring,...\n", ts_status_string(status) );
-		// do nothing
+		return status;
 	}
 
-	// determine remaining timer budget
-	uint32_t interval = (uint32_t)(ts_platform_time() - timestamp);
+	// run the rate limiter, service, logging, firewall and transport tasks within the budget
+	ts_scheduler_tick( service->_scheduler, budget );
 
-	if( interval >= budget ) {
-		ts_status_debug( "ts_service_tick: after calling service tick, budget exceeded, ignoring,...\n" );
-		interval = 0;
+	// report the transport status (the others are informational only), but only from a run made
+	// by this tick, i.e., a deferred transport (e.g., no budget) has nothing to report but pending work
+	status = ts_scheduler_get_stats( service->_scheduler, TS_SERVICE_TASK_TRANSPORT, &after );
+	if( status != TsStatusOk ) {
+		return status;
 	}
-
-	// logging tick
-	if (service->_logconfig != NULL) {
-		status = ts_logconfig_tick(service->_logconfig, budget - interval);
-		interval = (uint32_t)(ts_platform_time() - timestamp);
-		if (interval >= budget) {
-			ts_status_debug(
-						"ts_service_tick: after calling logconfig tick, budget exceeded, ignoring,...\n");
-			interval = 0;
-		}
+	if( after.runs == before.runs ) {
+		return TsStatusOkTrying;
 	}
+	return after.status;
+}
 
-#ifdef TS_ODS_ENABLED
-	// firewall tick
-	if (service->_firewall != NULL) {
-		status = ts_firewall_tick(service->_firewall, budget - interval);
-		interval = (uint32_t)(ts_platform_time() - timestamp);
-		if (interval >= budget) {
-			ts_status_debug(
-					"ts_service_tick: after calling firewall tick, budget exceeded, ignoring,...\n");
-			interval = 0;
-		}
-	}
+TsStatus_t ts_service_add_task( TsServiceRef_t service, const char * name, TsSchedulerHandler_t handler, void * state, uint32_t period, uint32_t deadline, uint32_t share ) {
 
-	ts_status_debug("After calling firewall tick, remaining timer budget is %d\n");
-#endif
-	// perform transport tick within remaining budget
-	// TODO - return may require user action, e.g., TsStatusErrorConnectionReset - or add processing here.
-	return ts_transport_tick(service->_transport, budget - interval);
+	ts_status_trace( "ts_service_add_task\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_scheduler != NULL );
+
+	return ts_scheduler_add( service->_scheduler, name, handler, state, period, deadline, share );
+}
+
+TsStatus_t ts_service_get_task_stats( TsServiceRef_t service, const char * name, TsSchedulerStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_task_stats\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_scheduler != NULL );
+
+	return ts_scheduler_get_stats( service->_scheduler, name, stats );
 }
 
 TsStatus_t ts_service_set_server_cert_hostname( TsServiceRef_t service, const char * hostname ) {
@@ -174,19 +268,31 @@ TsStatus_t ts_service_dial( TsServiceRef_t service, TsAddress_t address ) {
 	ts_platform_assert( service != NULL );
 	ts_platform_assert( service->_transport != NULL );
 
-	TsStatus_t status = ts_transport_dial( service->_transport, address );
+	// the dial is completed by ts_service_tick, unless the transport can only block
+	TsStatus_t status;
+	if( ts_transport->dial_start != NULL ) {
+		status = ts_transport_dial_start( service->_transport, address );
+	} else {
+		status = ts_transport_dial( service->_transport, address );
+	}
+	service->_dialing = ( status == TsStatusOkTrying );
+	if( status == TsStatusOk ) {
+		_ts_service_connected( service );
+	}
+	return status;
+}
+
+static void _ts_service_connected( TsServiceRef_t service ) {
+
 #ifdef TS_ODS_ENABLED
 	// Send an update message representing version information
-	if (status == TsStatusOk) {
-		TsMessageRef_t versionMessage;
-		if (ts_version_make_update( &versionMessage ) == TsStatusOk) {
-			ts_message_dump(versionMessage);
-			ts_service_enqueue_typed(service, "ts.event.version", versionMessage);
-			ts_message_destroy(versionMessage);
-		}
+	TsMessageRef_t versionMessage;
+	if (ts_version_make_update( &versionMessage ) == TsStatusOk) {
+		ts_message_dump(versionMessage);
+		ts_service_enqueue_typed(service, "ts.event.version", versionMessage);
+		ts_message_destroy(versionMessage);
 	}
 #endif
-	return status;
 }
 
 TsStatus_t ts_service_hangup( TsServiceRef_t service ) {
@@ -196,6 +302,7 @@ TsStatus_t ts_service_hangup( TsServiceRef_t service ) {
 	ts_platform_assert( service != NULL );
 	ts_platform_assert( service->_transport != NULL );
 
+	service->_dialing = false;
 	return ts_transport_hangup( service->_transport );
 }
 
@@ -209,6 +316,19 @@ TsStatus_t ts_service_enqueue( TsServiceRef_t service, TsMessageRef_t message )
 	return ts_service->enqueue( service, message );
 }
 
+TsStatus_t ts_service_enqueue_qos( TsServiceRef_t service, TsMessageRef_t message, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_service_enqueue_qos\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	if( ts_service->enqueueqos == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_service->enqueueqos( service, message, qos );
+}
+
 TsStatus_t ts_service_enqueue_typed(TsServiceRef_t service, char* type, TsMessageRef_t message ) {
 	ts_status_trace( "ts_service_enqueue_typed\n" );
 	ts_platform_assert( ts_transport != NULL );
@@ -235,3 +355,183 @@ TsStatus_t ts_service_dequeue( TsServiceRef_t service, TsServiceAction_t action,
 	// allow protocol specific implementation
 	return ts_service->dequeue( service, action, handler );
 }
+
+TsStatus_t ts_service_set_rate_limit( TsServiceRef_t service, uint32_t messages, uint32_t bytes, TsRateLimitPolicy_t policy ) {
+
+	ts_status_trace( "ts_service_set_rate_limit\n" );
+	ts_platform_assert( service != NULL );
+
+	if( service->_ratelimit == NULL ) {
+		TsStatus_t status = ts_ratelimit_create( &(service->_ratelimit) );
+		if( status != TsStatusOk ) {
+			service->_ratelimit = NULL;
+			return status;
+		}
+	}
+	return ts_ratelimit_set( service->_ratelimit, messages, bytes, policy );
+}
+
+TsStatus_t ts_service_get_rate_limit_stats( TsServiceRef_t service, TsRateLimitStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_rate_limit_stats\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( stats != NULL );
+
+	if( service->_ratelimit == NULL ) {
+		memset( stats, 0x00, sizeof( TsRateLimitStats_t ) );
+		return TsStatusOk;
+	}
+	return ts_ratelimit_get_stats( service->_ratelimit, stats );
+}
+
+TsStatus_t ts_service_speak( TsServiceRef_t service, TsPath_t path, const uint8_t * buffer, size_t buffer_size, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_service_speak\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	// unsolicited traffic is subject to the rate limit (if any), and a transport
+	// without qos support can still send at most once (when the qos allows it)
+	if( service->_ratelimit == NULL ) {
+		if( ts_transport->speak_qos != NULL ) {
+			return ts_transport_speak_qos( service->_transport, path, buffer, buffer_size, qos );
+		}
+		if( qos == TsTransportQos0 ) {
+			return ts_transport_speak( service->_transport, path, buffer, buffer_size );
+		}
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_ratelimit_speak( service->_ratelimit, service->_transport, path, buffer, buffer_size, qos );
+}
+
+TsStatus_t ts_service_speak_vector( TsServiceRef_t service, TsPath_t path, const TsTransportSegment_t * segments, size_t count, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_service_speak_vector\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	if( ts_transport->speak_vector == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+
+	// unsolicited traffic is subject to the rate limit (if any)
+	if( service->_ratelimit == NULL ) {
+		return ts_transport_speak_vector( service->_transport, path, segments, count, qos );
+	}
+	return ts_ratelimit_speak_vector( service->_ratelimit, service->_transport, path, segments, count, qos );
+}
+
+TsStatus_t ts_service_set_reconnect( TsServiceRef_t service, uint32_t min_backoff, uint32_t max_backoff ) {
+
+	ts_status_trace( "ts_service_set_reconnect\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	if( ts_transport->set_reconnect == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_transport_set_reconnect( service->_transport, min_backoff, max_backoff );
+}
+
+TsStatus_t ts_service_get_reconnect_stats( TsServiceRef_t service, TsTransportReconnectStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_reconnect_stats\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	if( ts_transport->get_reconnect_stats == NULL ) {
+		memset( stats, 0x00, sizeof( TsTransportReconnectStats_t ) );
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_transport_get_reconnect_stats( service->_transport, stats );
+}
+
+TsStatus_t ts_service_set_keepalive( TsServiceRef_t service, uint32_t interval, uint32_t max_interval ) {
+
+	ts_status_trace( "ts_service_set_keepalive\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	if( ts_transport->set_keepalive == NULL ) {
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_transport_set_keepalive( service->_transport, interval, max_interval );
+}
+
+TsStatus_t ts_service_get_keepalive_stats( TsServiceRef_t service, TsTransportKeepAliveStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_keepalive_stats\n" );
+	ts_platform_assert( ts_transport != NULL );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	if( ts_transport->get_keepalive_stats == NULL ) {
+		memset( stats, 0x00, sizeof( TsTransportKeepAliveStats_t ) );
+		return TsStatusErrorNotImplemented;
+	}
+	return ts_transport_get_keepalive_stats( service->_transport, stats );
+}
+
+TsStatus_t ts_service_set_resumption( TsServiceRef_t service, bool enable ) {
+
+	ts_status_trace( "ts_service_set_resumption\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	return ts_connection_set_resumption( service->_transport->_connection, enable );
+}
+
+TsStatus_t ts_service_get_session_stats( TsServiceRef_t service, TsSecuritySessionStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_session_stats\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	return ts_connection_get_session_stats( service->_transport->_connection, stats );
+}
+
+TsStatus_t ts_service_get_memory_stats( TsServiceRef_t service, TsSecurityMemoryStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_memory_stats\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	return ts_connection_get_memory_stats( service->_transport->_connection, stats );
+}
+
+TsStatus_t ts_service_set_psk( TsServiceRef_t service, const uint8_t * psk, size_t psk_size ) {
+
+	ts_status_trace( "ts_service_set_psk\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	return ts_connection_set_psk( service->_transport->_connection, psk, psk_size );
+}
+
+TsStatus_t ts_service_set_psk_identity( TsServiceRef_t service, const uint8_t * identity, size_t identity_size ) {
+
+	ts_status_trace( "ts_service_set_psk_identity\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+
+	return ts_connection_set_psk_identity( service->_transport->_connection, identity, identity_size );
+}
+
+TsStatus_t ts_service_get_credential_stats( TsServiceRef_t service, TsSecurityCredentialStats_t * stats ) {
+
+	ts_status_trace( "ts_service_get_credential_stats\n" );
+	ts_platform_assert( service != NULL );
+	ts_platform_assert( service->_transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	return ts_connection_get_credential_stats( service->_transport->_connection, stats );
+}
@@ -5,16 +5,13 @@
 #include "ts_log.h"
 #include "ts_firewall.h"
 
-static TsStatus_t _ts_handle_get( TsMessageRef_t fields );
-static TsStatus_t _ts_handle_set( TsMessageRef_t fields );
+static TsStatus_t _ts_handle_get( TsFirewallRef_t firewall, TsLogConfigRef_t logconfig, TsMessageRef_t fields );
+static TsStatus_t _ts_handle_set( TsFirewallRef_t firewall, TsLogConfigRef_t logconfig, TsMessageRef_t fields );
 
-static TsFirewallRef_t _firewall = NULL;
-static TsLogConfigRef_t _logconfig = NULL;
-
-#define SUSPEND_LOG(s) if (_logconfig != NULL) { ts_log(_logconfig, TsLogLevelInfo, TsCategoryDiagnostic, s); }
+#define SUSPEND_LOG(s) if (logconfig != NULL) { ts_log(logconfig, TsLogLevelInfo, TsCategoryDiagnostic, s); }
 
 /**
- * Set the logconfig used to log suspension events, and that we'll be suspending/resuming.
+ * Deprecated, the logconfig is passed to ts_suspend_handle, this function has no effect.
  * @param config
  * [in] The log configuration to use for logging suspension events.
  * @return
@@ -23,13 +20,12 @@ static TsLogConfigRef_t _logconfig = NULL;
  * - TsStatusError[Code]
  */
 TsStatus_t ts_suspend_set_logconfig(TsLogConfigRef_t config) {
-	_logconfig = config;
 	return TsStatusOk;
 }
 
 
 /**
- * Set the firewall that we'll be suspending/resuming.
+ * Deprecated, the firewall is passed to ts_suspend_handle, this function has no effect.
  * @param firewall
  * [in] The firewall that we'll be suspending/resuming.
  * @return
@@ -38,18 +34,19 @@ TsStatus_t ts_suspend_set_logconfig(TsLogConfigRef_t config) {
  * - TsStatusError[Code]
  */
 TsStatus_t ts_suspend_set_firewall(TsFirewallRef_t firewall) {
-	_firewall = firewall;
 	return TsStatusOk;
 }
 
 #ifdef TEST_SUSPEND
 /**
  * Generate and handle a test suspension message.
+ * @param fw the firewall to suspend/resume, or NULL
+ * @param lc the logconfig to suspend/resume, or NULL
  * @param firewall true to suspend firewall, false to resume
  * @param logconfig true to suspend logging, false to resume
  * @return
  */
-TsStatus_t ts_suspend_test(bool firewall, bool logconfig) {
+TsStatus_t ts_suspend_test(TsFirewallRef_t fw, TsLogConfigRef_t lc, bool firewall, bool logconfig) {
 	TsMessageRef_t testMessage;
 	ts_message_create(&testMessage);
 	ts_message_set_string(testMessage, "action", "set");
@@ -59,7 +56,7 @@ TsStatus_t ts_suspend_test(bool firewall, bool logconfig) {
 	ts_message_set_bool(fields, "firewall", firewall);
 	ts_message_set_bool(fields, "logconfig", logconfig);
 
-	TsStatus_t result = ts_suspend_handle(testMessage);
+	TsStatus_t result = ts_suspend_handle(fw, lc, testMessage);
 	if (result == TsStatusOk) {
 		ts_status_debug("ts_handle_test_suspension: successfully handled message with firewall = %d, logconfig = %d\n");
 	} else {
@@ -73,6 +70,10 @@ TsStatus_t ts_suspend_test(bool firewall, bool logconfig) {
 
 /**
  * Handle a suspension message.
+ * @param firewall
+ * [in] The firewall to be suspended/resumed, or NULL.
+ * @param logconfig
+ * [in] The log configuration to be suspended/resumed and used to log suspension events, or NULL.
  * @param message
  * [in] The configuration message to be handled.
  * @return
@@ -80,7 +81,7 @@ TsStatus_t ts_suspend_test(bool firewall, bool logconfig) {
  * - TsStatusOk
  * - TsStatusError[Code]
  */
-TsStatus_t ts_suspend_handle(TsMessageRef_t message) {
+TsStatus_t ts_suspend_handle(TsFirewallRef_t firewall, TsLogConfigRef_t logconfig, TsMessageRef_t message) {
 
 	ts_status_trace("ts_suspend_handle");
 	ts_platform_assert(message != NULL);
@@ -104,14 +105,14 @@ TsStatus_t ts_suspend_handle(TsMessageRef_t message) {
 					// set the suspend fields
 					ts_status_info(
 							"ts_suspend_handle: delegate to set handler\n");
-					return _ts_handle_set(fields);
+					return _ts_handle_set(firewall, logconfig, fields);
 
 				} else if (strcmp(action, "get") == 0) {
 
 					// get the suspend information
 					ts_status_debug(
 							"ts_suspend_handle: delegate to get handler\n");
-					status = _ts_handle_get(fields);
+					status = _ts_handle_get(firewall, logconfig, fields);
 
 				} else {
 
@@ -137,22 +138,22 @@ TsStatus_t ts_suspend_handle(TsMessageRef_t message) {
 	return status;
 }
 
-static TsStatus_t _ts_handle_get( TsMessageRef_t fields ) {
+static TsStatus_t _ts_handle_get( TsFirewallRef_t firewall, TsLogConfigRef_t logconfig, TsMessageRef_t fields ) {
 	TsMessageRef_t contents;
-	if (ts_message_has(fields, "firewall", &contents) == TsStatusOk) {
+	if (firewall != NULL && ts_message_has(fields, "firewall", &contents) == TsStatusOk) {
 		ts_status_debug("_ts_handle_get: get firewall suspend\n");
-		ts_message_set_bool(fields, "firewall", ts_firewall_suspended(_firewall));
+		ts_message_set_bool(fields, "firewall", ts_firewall_suspended(firewall));
 	}
-	if (ts_message_has(fields, "logconfig", &contents) == TsStatusOk) {
+	if (logconfig != NULL && ts_message_has(fields, "logconfig", &contents) == TsStatusOk) {
 		ts_status_debug("_ts_handle_get: get logconfig suspend\n");
-		ts_message_set_bool(fields, "logconfig", ts_logconfig_suspended(_logconfig));
+		ts_message_set_bool(fields, "logconfig", ts_logconfig_suspended(logconfig));
 	}
 	return TsStatusOk;
 }
 
-static TsStatus_t _ts_handle_set( TsMessageRef_t fields ) {
+static TsStatus_t _ts_handle_set( TsFirewallRef_t firewall, TsLogConfigRef_t logconfig, TsMessageRef_t fields ) {
 	bool firewall_suspend;
-	if (ts_message_get_bool(fields, "firewall", &firewall_suspend) == TsStatusOk) {
+	if (firewall != NULL && ts_message_get_bool(fields, "firewall", &firewall_suspend) == TsStatusOk) {
 		if (firewall_suspend) {
 			ts_status_debug("_ts_handle_set: suspending firewall\n");
 			SUSPEND_LOG("Firewall suspended\n");
@@ -161,20 +162,20 @@ static TsStatus_t _ts_handle_set( TsMessageRef_t fields ) {
 			ts_status_debug("_ts_handle_set: resuming firewall\n");
 			SUSPEND_LOG("Firewall resumed\n");
 		}
-		ts_firewall_set_suspended(_firewall, firewall_suspend);
+		ts_firewall_set_suspended(firewall, firewall_suspend);
 	}
 	bool log_suspend;
-	if (ts_message_get_bool(fields, "logconfig", &log_suspend) == TsStatusOk) {
+	if (logconfig != NULL && ts_message_get_bool(fields, "logconfig", &log_suspend) == TsStatusOk) {
 		if (log_suspend) {
 			ts_status_debug("_ts_handle_set: suspending logging\n");
 			// log before suspending the logging
 			SUSPEND_LOG("Logging suspended\n");
-			ts_logconfig_set_suspended(_logconfig, log_suspend);
+			ts_logconfig_set_suspended(logconfig, log_suspend);
 		}
 		else {
 			ts_status_debug("_ts_handle_set: resuming logging\n");
 			// log after resuming the logging
-			ts_logconfig_set_suspended(_logconfig, log_suspend);
+			ts_logconfig_set_suspended(logconfig, log_suspend);
 			SUSPEND_LOG("Logging resumed\n");
 		}
 	}
@@ -35,22 +35,9 @@
  */
 #define IDLE_TIME_MS		5
 
-static TsDriverRef_t driver;
-
-struct {
-	size_t sz;
-	at_urc_desc *urcs;
-} urc_list;
-
-static bool echo_en;		/* Set when echo is enabled on the modem. */
-
-static rbuf r;			/* AT ring buffer. */
-static uint8_t atb[AT_BUF_SZ];	/* Underlying buffer to use. */
-static bool at_dbg_en;		/* Set to true to enable debug output. */
-
-void at_toggle_cmd_echo(bool on)
+void at_toggle_cmd_echo(at_intfc *at, bool on)
 {
-	at_dbg_en = on;
+	at->dbg_en = on;
 }
 
 #define ts_platform_time_ms()	(ts_platform_time() / TS_TIME_MSEC_TO_USEC)
@@ -62,14 +49,14 @@ void at_toggle_cmd_echo(bool on)
  * available, dump all bytes. This should not be called from the interrupt
  * context.
  */
-static void dump_buf(size_t sz, uint8_t buf[])
+static void dump_buf(at_intfc *at, size_t sz, uint8_t buf[])
 {
-	size_t unread = rbuf_unread(&r);
+	size_t unread = rbuf_unread(&at->r);
 	unread = unread > sz ? sz : unread;
 	if (unread == 0)
 		return;
 	atdbg("Dumping first %u bytes\n", unread);
-	rbuf_rbs(&r, unread, buf);
+	rbuf_rbs(&at->r, unread, buf);
 	atdbg("{%02x", buf[0]);
 	for (size_t i = 1; i < unread; i++)
 		atdbg(", %02x", buf[i]);
@@ -78,70 +65,89 @@ static void dump_buf(size_t sz, uint8_t buf[])
 
 /*
  * Attempt to detect and process a URC. The URC callback is invoked if a complete
- * match is found. Return 'true' on a complete or partial match. If no URC was
- * detected, return 'false'.
+ * match is found. All registered URCs are matched together, in a single pass
+ * over the received bytes (see rbuf_match_set). Return the result of the match.
  */
-static match_res_t process_urcs(void)
+static match_res_t process_urcs(at_intfc *at)
 {
-	bool partial_match = false;
-	for (size_t i = 0; i < urc_list.sz; i++) {
-		size_t msz = 0;
-		match_res_t res = rbuf_matchf(&r, &urc_list.urcs[i].urc, &msz);
-		if (res == MATCH_OK) {
+	size_t i = 0;
+	size_t msz = 0;
+	match_res_t res = rbuf_match_set(&at->r, &at->urc_set, &i, &msz);
+	if (res == MATCH_OK) {
+		urc_callback cb = at->urcs[i].urc_cb;
+		const uint8_t *urc = NULL;
+		if (rbuf_peek(&at->r, &urc) >= msz) {
+			/* Parse in place, URC callbacks don't touch the ring buffer. */
+			if (cb != NULL)
+				cb(msz, (const char *)urc, at->urc_data);
+			rbuf_commit(&at->r, msz);
+		} else {
+			/* The URC wraps around the end of the ring buffer. */
 			char scratch_space[MAX_SCRATCH_SPACE_SZ];
-			rbuf_rbs(&r, msz, (uint8_t *)scratch_space);
-			urc_callback cb = urc_list.urcs[i].urc_cb;
+			size_t ssz = msz > sizeof(scratch_space) ? sizeof(scratch_space) : msz;
+			rbuf_rbs(&at->r, ssz, (uint8_t *)scratch_space);
+			rbuf_commit(&at->r, msz - ssz);
 			if (cb != NULL)
-				cb(msz, scratch_space);
-			rbuf_reset_fmt_desc(&urc_list.urcs[i].urc);
-			return res;
+				cb(ssz, scratch_space, at->urc_data);
 		}
-		if (res == MATCH_PARTIAL)
-			partial_match = true;
-		else
-			rbuf_reset_fmt_desc(&urc_list.urcs[i].urc);
 	}
-	return partial_match ? MATCH_PARTIAL : MATCH_FAIL;
+	return res;
 }
 
-/* Return true if at least one URC was detected. */
-static inline bool attempt_proc_urc(void)
+/*
+ * Report receive buffer overflows, i.e. bytes dropped by the reader callback
+ * before they could be parsed (which otherwise surface as corrupt responses).
+ */
+static void check_rx_overflow(at_intfc *at)
+{
+	rbuf_stats stats;
+	rbuf_get_stats(&at->r, &stats);
+	if (stats.overflows == at->rx_overflows)
+		return;
+	ts_status_alarm("at_intfc: receive buffer overflow, %u bytes dropped so far, high water %u of %u bytes\n",
+		(uint32_t)stats.dropped, (uint32_t)stats.high_water, (uint32_t)at->r.sz);
+	at->rx_overflows = stats.overflows;
+}
+
+/*
+ * Return true if at least one URC was detected. A partial URC is left in place,
+ * its search resumes where it stopped once more bytes arrive.
+ */
+static inline bool attempt_proc_urc(at_intfc *at)
 {
 	bool urc_detected = false;
-	if (rbuf_unread(&r) == 0)
-		return false;
-	while (1) {
-		match_res_t res = process_urcs();
-		if (res == MATCH_OK)
-			urc_detected = true;
-		else if (res == MATCH_FAIL)
-			break;
-		ts_platform_sleep_ms(IDLE_TIME_MS);
-	}
+	while (process_urcs(at) == MATCH_OK)
+		urc_detected = true;
 	return urc_detected;
 }
 
 static TsStatus_t rx_cb(TsDriverRef_t driver, void *reader_state, const uint8_t *data, size_t sz)
 {
-	rbuf_wbs(&r, sz, data);
+	at_intfc *at = reader_state;
+	if (!rbuf_wbs(&at->r, sz, data))
+		return TsStatusErrorNoResourceAvailable;
+	/* Only bytes that made it into the buffer are worth waking up for */
+	at->rx_ready = true;
 	return TsStatusOk;
 }
 
-bool at_init(TsDriverRef_t d)
+bool at_init(at_intfc *at, TsDriverRef_t d)
 {
-	if (d == NULL)
+	if (at == NULL || d == NULL)
 		return false;
-	driver = d;
-	at_dbg_en = true;
+	memset(at, 0, sizeof(*at));
+	at->driver = d;
+	at->dbg_en = true;
+	rbuf_init_set(&at->urc_set);
 
 	atdbg("Initializing modem receive buffer\n");
-	if (!rbuf_init(&r, sizeof(atb), atb)) {
+	if (!rbuf_init(&at->r, sizeof(at->buf), at->buf)) {
 		atdbg("Initialization failed\n");
 		return false;
 	}
 
 	atdbg("Setting modem communication port callback\n");
-	if (ts_driver_reader(driver, NULL, rx_cb) != TsStatusOk) {
+	if (ts_driver_reader(at->driver, at, rx_cb) != TsStatusOk) {
 		atdbg("Initialization failed\n");
 		return false;
 	}
@@ -149,16 +155,26 @@ bool at_init(TsDriverRef_t d)
 	return true;
 }
 
-void at_reg_urcs(size_t sz, at_urc_desc urcs[])
+void at_reg_urcs(at_intfc *at, size_t sz, const at_urc_desc urcs[], void *pvt_data)
 {
 	if (urcs == NULL || sz == 0)
 		return;
+	if (sz > AT_MAX_URCS) {
+		atdbg("Only registering the first %u URC(s)\n", AT_MAX_URCS);
+		sz = AT_MAX_URCS;
+	}
 	atdbg("Registering %u new URC(s)\n", sz);
-	urc_list.sz = sz;
-	urc_list.urcs = urcs;
+	at->num_urcs = 0;
+	at->urc_data = pvt_data;
+	rbuf_init_set(&at->urc_set);
 	for (size_t i = 0; i < sz; i++) {
-		atdbg("%s\n", urcs[i].urc.fmt);
-		rbuf_reset_fmt_desc(&urcs[i].urc);
+		if (!rbuf_add_to_set(&at->urc_set, urcs[i].urc.fmt, i)) {
+			atdbg("Only registering the first %u URC(s)\n", i);
+			break;
+		}
+		at->urcs[i] = urcs[i];
+		at->num_urcs++;
+		atdbg("%s\n", at->urcs[i].urc.fmt);
 	}
 }
 
@@ -202,150 +218,251 @@ static void print_at_wcmd_result(const char * f, at_wcmd_res res)
  * Read the response of size sz bytes from the ring buffer. Call the corresponding
  * response handler - its index is given by 'idx'.
  */
-static void invoke_resp_cb(uint8_t idx, size_t sz, const at_cmd_desc *cmd)
+static void invoke_resp_cb(at_intfc *at, uint8_t idx, size_t sz, const at_cmd_desc *cmd)
 {
 	char scratch_space[MAX_SCRATCH_SPACE_SZ];
 	resp_callback cb = cmd->resp[idx].resp_cb;
-	rbuf_rbs(&r, sz, (uint8_t *)scratch_space);
+	rbuf_rbs(&at->r, sz, (uint8_t *)scratch_space);
 	if (cb != NULL)
 		cb(sz, scratch_space, cmd->resp[idx].pvt_data);
 }
 
-/* Attempt to eat the echoed command. If successful, return true, else false. */
-static bool eat_echo(const at_cmd_desc *cmd, uint32_t timeout)
-{
-	match_fmt_t cmd_match;
-	rbuf_reset_fmt_desc(&cmd_match);
-	cmd_match.fmt = cmd->cmd;
-	uint32_t start = ts_platform_time_ms();
-	size_t sz = 0;
-	while (1) {
-		if (ts_platform_time_ms() - start > timeout)
-			return false;
-		match_res_t mres = rbuf_matchf(&r, &cmd_match, &sz);
-		if (mres == MATCH_OK) {
-			uint8_t buf[sz];
-			rbuf_rbs(&r, sz, buf);
-			return true;
-		} else {
-			ts_platform_sleep_ms(IDLE_TIME_MS);
-		}
-	}
-	return false;
-}
-
 /*
  * Attempt matching the response from the modem with the stored expected response
  * or the error string of the command. If there's a match, return MATCH_OK and
  * fill in the index from the list of format descriptors that matched. Also
- * fill in the size of the match. If neither match, return MATCH_FAIL.
+ * fill in the size of the match. Otherwise return MATCH_PARTIAL if either may
+ * still match, or MATCH_FAIL.
  */
-static match_res_t match_rsp_err(match_fmt_t m[2], size_t *midx, size_t *msz)
+static match_res_t match_rsp_err(at_intfc *at, match_fmt_t m[2], size_t *midx, size_t *msz)
 {
+	bool partial_match = false;
 	for (size_t i = 0; i < 2; i++) {
-		match_res_t res = rbuf_matchf(&r, &m[i], msz);
+		match_res_t res = rbuf_matchf(&at->r, &m[i], msz);
 		if (res == MATCH_OK) {
 			*midx = i;
 			rbuf_reset_fmt_desc(&m[i]);
 			return res;
 		}
-		if (res != MATCH_PARTIAL)
+		if (res == MATCH_PARTIAL)
+			partial_match = true;
+		else
 			rbuf_reset_fmt_desc(&m[i]);
 	}
-	return MATCH_FAIL;
+	return partial_match ? MATCH_PARTIAL : MATCH_FAIL;
 }
 
 #define RSP		0
 #define ERR		1
 #define ECHO_TMO_MS	250
-at_wcmd_res at_wcmd(const at_cmd_desc *at_cmd)
+
+/* Complete the command in progress, and start the next one (if any). */
+static void finish_cmd(at_intfc *at, at_wcmd_res res)
 {
-	attempt_proc_urc();
+	at_cmd_entry entry = at->queue[at->queue_head];
+	at->queue_head = (at->queue_head + 1) % AT_CMD_QUEUE_SZ;
+	at->queue_count--;
+	at->cmd_state = at->queue_count > 0 ? AT_CMD_PENDING : AT_CMD_IDLE;
+	at->data_sz = 0;
+
+	/* Recommended wait time after a response is received. */
+	if (res == AT_WCMD_OK || res == AT_WCMD_ERR)
+		at->quiet_until = ts_platform_time_ms() + MAX_RESP_INTERVAL_MS;
+	print_at_wcmd_result("at_wcmd", res);
+	if (entry.done != NULL)
+		entry.done(res, entry.done_data);
+}
 
-	at_wcmd_res res = AT_WCMD_OK;
-	if (at_cmd == NULL || at_cmd->cmd == NULL || strlen(at_cmd->cmd) == 0) {
-		atdbg("Invalid parameters\n");
-		return AT_WCMD_INV;
+/* Move on to the next expected response of the command, or complete it. */
+static void next_resp(at_intfc *at)
+{
+	const at_cmd_desc *cmd = &at->queue[at->queue_head].cmd;
+	while (at->resp_idx < MAX_RESP && cmd->resp[at->resp_idx].exp_resp == NULL)
+		at->resp_idx++;
+	if (at->resp_idx >= MAX_RESP) {
+		finish_cmd(at, AT_WCMD_OK);
+		return;
 	}
+	load_resp_err_fmts(at->resp_idx, cmd, &at->cmd_match[RSP], &at->cmd_match[ERR]);
+	at->cmd_start = ts_platform_time_ms();
+	at->cmd_state = AT_CMD_RESP;
+}
+
+/*
+ * Advance the command in progress by one step, without waiting. Return true
+ * if it progressed (so that the next step may be attempted right away).
+ */
+static bool step_cmd(at_intfc *at)
+{
+	const at_cmd_desc *cmd = &at->queue[at->queue_head].cmd;
+	uint64_t now = ts_platform_time_ms();
+	size_t sz = 0;
+	switch (at->cmd_state) {
+	case AT_CMD_IDLE:
+		return false;
 
-	size_t cmd_len = at_cmd->cmd_len == 0 ? strlen(at_cmd->cmd)
-		: at_cmd->cmd_len;
-	if (at_dbg_en && at_cmd->cmd_len == 0)
-		atdbg("Issuing: %s\n", at_cmd->cmd);
-	if (!at_write(cmd_len, (const uint8_t *)at_cmd->cmd))
-		return AT_WCMD_TX_ERR;
-
-	/* If echo is enabled, command will repeat before response. */
-	if (echo_en && !eat_echo(at_cmd, ECHO_TMO_MS)) {
-		atdbg("Expected echo of command\n");
-		return AT_WCMD_TX_ERR;
+	case AT_CMD_PENDING: {
+		if (now < at->quiet_until)
+			return false;
+		/* URCs received beforehand mustn't be taken for the response. */
+		attempt_proc_urc(at);
+		size_t cmd_len = cmd->cmd_len == 0 ? strlen(cmd->cmd) : cmd->cmd_len;
+		if (at->dbg_en && cmd->cmd_len == 0)
+			atdbg("Issuing: %s\n", cmd->cmd);
+		if (!at_write(at, cmd_len, (const uint8_t *)cmd->cmd)) {
+			finish_cmd(at, AT_WCMD_TX_ERR);
+			return true;
+		}
+		at->resp_idx = 0;
+		if (at->echo_en) {
+			/* If echo is enabled, command will repeat before response. */
+			rbuf_reset_fmt_desc(&at->cmd_match[RSP]);
+			at->cmd_match[RSP].fmt = cmd->cmd;
+			at->cmd_start = now;
+			at->cmd_state = AT_CMD_ECHO;
+		} else {
+			next_resp(at);
+		}
+		return true;
 	}
 
-	match_fmt_t m_list[2];
-	uint8_t i = 0;
-	while (i < MAX_RESP) {
-		if (at_cmd->resp[i].exp_resp == NULL) {
-			i++;
-			continue;
+	case AT_CMD_ECHO: {
+		match_res_t res = rbuf_matchf(&at->r, &at->cmd_match[RSP], &sz);
+		if (res == MATCH_OK) {
+			rbuf_commit(&at->r, sz);
+			next_resp(at);
+			return true;
 		}
+		if (res != MATCH_PARTIAL)
+			rbuf_reset_fmt_desc(&at->cmd_match[RSP]);
+		if (now - at->cmd_start > ECHO_TMO_MS) {
+			atdbg("Expected echo of command\n");
+			finish_cmd(at, AT_WCMD_TX_ERR);
+			return true;
+		}
+		return false;
+	}
 
+	case AT_CMD_RESP: {
 		size_t m_idx = 0;
-		size_t m_sz = 0;
-		match_res_t m_res = MATCH_FAIL;
-		load_resp_err_fmts(i, at_cmd, &m_list[RSP], &m_list[ERR]);
-
-		uint32_t start = ts_platform_time_ms();
-		while (1) {	/* Wait for response / error or timeout. */
-			if (ts_platform_time_ms() - start > at_cmd->timeout) {
-				res = AT_WCMD_TO;
-				break;
-			}
-			m_res = match_rsp_err(m_list, &m_idx, &m_sz);
-			if (m_res == MATCH_OK) {
-				if (m_idx == RSP) {
-					res = AT_WCMD_OK;
-					invoke_resp_cb(i, m_sz, at_cmd);
-					break;
-				} else if (m_idx == ERR) {
-					res = AT_WCMD_ERR;
-					goto check_urc;
-				}
+		match_res_t res = match_rsp_err(at, at->cmd_match, &m_idx, &sz);
+		if (res == MATCH_OK && m_idx == RSP) {
+			invoke_resp_cb(at, at->resp_idx, sz, cmd);
+			at->resp_idx++;
+			if (at->data_sz > 0) {
+				at->cmd_start = now;
+				at->cmd_state = AT_CMD_DATA;
 			} else {
-				ts_platform_sleep_ms(IDLE_TIME_MS);
+				next_resp(at);
 			}
+			return true;
 		}
-
-		if (m_res == MATCH_FAIL) {
-			/*
-			 * On the Ublox modem, a URC cannot appear between the
-			 * command and its response. It's not clear if this is
-			 * possible on other modems. The following statement
-			 * handles this case.
-			 */
-			if (attempt_proc_urc())
-				continue;
-			if (res == AT_WCMD_TO)
-				goto exit_wcmd;
-			res = AT_WCMD_UNEXP;
+		if (res == MATCH_OK) {
+			rbuf_commit(&at->r, sz);
+			finish_cmd(at, AT_WCMD_ERR);
+			return true;
+		}
+		/*
+		 * On the Ublox modem, a URC cannot appear between the command
+		 * and its response. It's not clear if this is possible on other
+		 * modems. The following statement handles this case.
+		 */
+		if (res == MATCH_FAIL && rbuf_unread(&at->r) > 0 && process_urcs(at) == MATCH_OK)
+			return true;
+		if (now - at->cmd_start > cmd->timeout) {
+			if (rbuf_unread(&at->r) == 0) {
+				finish_cmd(at, AT_WCMD_TO);
+				return true;
+			}
 			uint8_t buf_dump[MAX_DUMP_SZ];
-			dump_buf(sizeof(buf_dump), buf_dump);
-			rbuf_clear(&r);
-			goto exit_wcmd;
+			dump_buf(at, sizeof(buf_dump), buf_dump);
+			rbuf_clear(&at->r);
+			finish_cmd(at, AT_WCMD_UNEXP);
+			return true;
 		}
-		i++;
+		return false;
 	}
 
-check_urc:
-	/* Recommended wait time after a response / URC is received. */
-	ts_platform_sleep_ms(MAX_RESP_INTERVAL_MS);
-	if (attempt_proc_urc())
-		ts_platform_sleep_ms(MAX_RESP_INTERVAL_MS);
-exit_wcmd:
-	print_at_wcmd_result(__func__, res);
-	return res;
+	case AT_CMD_DATA: {
+		/* Copy the data bytes as they arrive, the responses resume after them. */
+		sz = at_read_bytes(at, at->data_sz, at->data);
+		at->data += sz;
+		at->data_sz -= sz;
+		if (at->data_sz == 0) {
+			next_resp(at);
+			return true;
+		}
+		if (now - at->cmd_start > cmd->timeout) {
+			finish_cmd(at, AT_WCMD_TO);
+			return true;
+		}
+		return sz > 0;
+	}
+	}
+	return false;
+}
+
+bool at_submit(at_intfc *at, const at_cmd_desc *at_cmd, at_done_callback done, void *done_data)
+{
+	if (at_cmd == NULL || at_cmd->cmd == NULL || strlen(at_cmd->cmd) == 0) {
+		atdbg("Invalid parameters\n");
+		return false;
+	}
+	if (at->queue_count >= AT_CMD_QUEUE_SZ) {
+		atdbg("Command queue full\n");
+		return false;
+	}
+	at_cmd_entry *entry = &at->queue[(at->queue_head + at->queue_count) % AT_CMD_QUEUE_SZ];
+	entry->cmd = *at_cmd;
+	entry->done = done;
+	entry->done_data = done_data;
+	at->queue_count++;
+	if (at->cmd_state == AT_CMD_IDLE)
+		at->cmd_state = AT_CMD_PENDING;
+	return true;
 }
 
-bool at_write(size_t sz, const uint8_t data[])
+bool at_busy(at_intfc *at)
+{
+	return at->queue_count > 0;
+}
+
+void at_expect_data(at_intfc *at, size_t sz, uint8_t data[])
+{
+	at->data = data;
+	at->data_sz = data == NULL ? 0 : sz;
+}
+
+/* Completion state of a command issued by at_wcmd. */
+typedef struct {
+	bool done;
+	at_wcmd_res res;
+} wcmd_wait;
+
+static void wcmd_done(at_wcmd_res res, void *done_data)
+{
+	wcmd_wait *wait = done_data;
+	wait->res = res;
+	wait->done = true;
+}
+
+at_wcmd_res at_wcmd(at_intfc *at, const at_cmd_desc *at_cmd)
+{
+	wcmd_wait wait = { false, AT_WCMD_OK };
+	if (!at_submit(at, at_cmd, wcmd_done, &wait))
+		return AT_WCMD_INV;
+
+	/* Drive the queue until this command completes, sleeping when there's nothing to do. */
+	while (1) {
+		at_intfc_service(at);
+		if (wait.done)
+			break;
+		at_wait_rx(at, IDLE_TIME_MS);
+	}
+	return wait.res;
+}
+
+bool at_write(at_intfc *at, size_t sz, const uint8_t data[])
 {
 	if (data == NULL)
 		return false;
@@ -358,48 +475,78 @@ bool at_write(size_t sz, const uint8_t data[])
 	atdbg("}\n");
 #endif
 
-	if (ts_driver_write(driver, data, &sz, MSEC2USEC(TX_TIMEOUT_MS)) != TsStatusOk) {
+	if (ts_driver_write(at->driver, data, &sz, MSEC2USEC(TX_TIMEOUT_MS)) != TsStatusOk) {
 		atdbg("Timed out / error while writing write\n");
 		return false;
 	}
 	return true;
 }
 
-size_t at_avail_bytes(void)
+size_t at_avail_bytes(at_intfc *at)
+{
+	return rbuf_unread(&at->r);
+}
+
+void at_get_rx_stats(at_intfc *at, rbuf_stats *stats)
 {
-	return rbuf_unread(&r);
+	rbuf_get_stats(&at->r, stats);
 }
 
-size_t at_read_bytes(size_t sz, uint8_t data[])
+size_t at_read_bytes(at_intfc *at, size_t sz, uint8_t data[])
 {
-	size_t unread = rbuf_unread(&r);
+	size_t unread = rbuf_unread(&at->r);
 	size_t actual_sz = sz > unread ? unread : sz;
-	if (actual_sz == 0 || !rbuf_rbs(&r, actual_sz, data))
+	if (actual_sz == 0 || !rbuf_rbs(&at->r, actual_sz, data))
 		return 0;
 	else
 		return actual_sz;
 }
 
-void at_clear_rxbuf(void)
+void at_clear_rxbuf(at_intfc *at)
 {
-	rbuf_clear(&r);
+	rbuf_clear(&at->r);
 }
 
-void at_set_echo(bool on)
+void at_set_echo(at_intfc *at, bool on)
 {
-	echo_en = on;
+	at->echo_en = on;
 	atdbg("Echo %s\n", on ? "on" : "off");
 }
 
-void at_intfc_service(void)
+bool at_rx_ready(at_intfc *at)
+{
+	if (!at->rx_ready)
+		return false;
+	at->rx_ready = false;
+	return true;
+}
+
+bool at_wait_rx(at_intfc *at, uint32_t timeout_ms)
+{
+	uint64_t start = ts_platform_time_ms();
+	while (!at_rx_ready(at)) {
+		uint64_t elapsed = ts_platform_time_ms() - start;
+		if (elapsed >= timeout_ms)
+			return false;
+		uint64_t remaining = timeout_ms - elapsed;
+		ts_platform_sleep_ms(remaining < IDLE_TIME_MS ? remaining : IDLE_TIME_MS);
+	}
+	return true;
+}
+
+void at_intfc_service(at_intfc *at)
 {
-	attempt_proc_urc();
+	check_rx_overflow(at);
+	while (step_cmd(at))
+		;
+	if (at->cmd_state == AT_CMD_IDLE || at->cmd_state == AT_CMD_PENDING)
+		attempt_proc_urc(at);
 }
 
-void at_discard_begin_bytes(size_t sz)
+void at_discard_begin_bytes(at_intfc *at, size_t sz)
 {
-	size_t unread = rbuf_unread(&r);
+	size_t unread = rbuf_unread(&at->r);
 	if (sz > unread)
 		sz = unread;
-	r.ridx += sz;
+	rbuf_commit(&at->r, sz);
 }
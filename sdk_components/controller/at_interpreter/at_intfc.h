@@ -19,7 +19,7 @@
 #include "ts_driver.h"
 
 /**
- * \brief Size of the buffer held by the AT command interpreter.
+ * \brief Size of the buffer held by the AT command interpreter (a power of two).
  */
 #define AT_BUF_SZ		((size_t)2048)
 
@@ -28,6 +28,11 @@
  */
 #define MAX_RESP		2
 
+/**
+ * \brief Maximum number of URCs that can be registered with an interface.
+ */
+#define AT_MAX_URCS		8
+
 /**
  * \brief Maximum time in milliseconds to complete transmission to modem.
  * \details This is the maximum amount of time the module will wait for a
@@ -37,6 +42,11 @@
  */
 #define TX_TIMEOUT_MS		5000
 
+/**
+ * \brief Maximum number of AT commands queued (including the one in progress).
+ */
+#define AT_CMD_QUEUE_SZ		4
+
 /**
  * \brief Callback that is invoked on receiving a matched response.
  *
@@ -60,6 +70,7 @@ typedef void (*resp_callback)(size_t sz, const char resp[], void *pvt_data);
  *
  * \param[out] sz Number of bytes in the URC.
  * \param[out] urc_text Text of the URC.
+ * \param[out] pvt_data Pointer to the private data given to \ref at_reg_urcs.
  *
  * \note URCs are stored in the internal AT buffer in the order they are sent
  * by the modem. Therefore URC callbacks are also invoked in the same order. A
@@ -68,7 +79,7 @@ typedef void (*resp_callback)(size_t sz, const char resp[], void *pvt_data);
  *
  * \warning \ref at_wmcd should not be called from the URC callback.
  */
-typedef void (*urc_callback)(size_t sz, const char urc_text[]);
+typedef void (*urc_callback)(size_t sz, const char urc_text[], void *pvt_data);
 
 /**
  * \brief Defines a descriptor to store the expected response and associated
@@ -135,57 +146,197 @@ typedef enum {
 	AT_WCMD_TO		/**< Timed out waiting for response */
 } at_wcmd_res;
 
+/**
+ * \brief Callback that is invoked when a submitted AT command completes.
+ * \details The callback is invoked from \ref at_intfc_service (i.e. outside
+ * the interrupt context), once the command's responses were received, or it
+ * failed. The next command may be submitted from the callback.
+ *
+ * \param[out] res The result of the command, see \ref at_wcmd_res.
+ * \param[out] done_data Pointer to the private data given to \ref at_submit.
+ */
+typedef void (*at_done_callback)(at_wcmd_res res, void *done_data);
+
+/**
+ * \brief Type describing the progress of the AT command in progress.
+ */
+typedef enum {
+	AT_CMD_IDLE,		/**< No command queued */
+	AT_CMD_PENDING,		/**< Waiting to write the command */
+	AT_CMD_ECHO,		/**< Waiting for the echo of the command */
+	AT_CMD_RESP,		/**< Waiting for a response (or error) */
+	AT_CMD_DATA		/**< Receiving binary data following a response */
+} at_cmd_state;
+
+/**
+ * \brief Defines a queued AT command, along with its completion callback.
+ */
+typedef struct {
+	at_cmd_desc cmd;		/**< Copy of the command descriptor. */
+	at_done_callback done;		/**< Completion callback, or NULL. */
+	void *done_data;		/**< Private data passed to the completion callback. */
+} at_cmd_entry;
+
+/**
+ * \brief Type describing an instance of the AT command interpreter.
+ * \details All state is held per instance, so that more than one modem may be
+ * driven from the same process. The fields are private and shouldn't be
+ * accessed directly.
+ */
+typedef struct {
+	TsDriverRef_t driver;		/**< Driver of the modem's port. */
+	size_t num_urcs;		/**< Number of registered URCs. */
+	at_urc_desc urcs[AT_MAX_URCS];	/**< Registered URCs. */
+	match_set_t urc_set;		/**< Registered URCs, compiled into one matcher. */
+	void *urc_data;			/**< Private data passed to URC callbacks. */
+	bool echo_en;			/**< Set when echo is enabled on the modem. */
+	bool dbg_en;			/**< Set to true to enable debug output. */
+	volatile bool rx_ready;		/**< Set by the driver's reader callback when bytes arrive. */
+	size_t rx_overflows;		/**< Number of receive overflows reported so far. */
+	rbuf r;				/**< AT ring buffer. */
+	uint8_t buf[AT_BUF_SZ];		/**< Underlying buffer to use. */
+	at_cmd_entry queue[AT_CMD_QUEUE_SZ];	/**< Queued commands, the first is in progress. */
+	size_t queue_head;		/**< Index of the command in progress. */
+	size_t queue_count;		/**< Number of queued commands. */
+	at_cmd_state cmd_state;		/**< Progress of the command in progress. */
+	uint8_t resp_idx;		/**< Index of the response being matched. */
+	match_fmt_t cmd_match[2];	/**< Response and error (or echo) match state. */
+	uint64_t cmd_start;		/**< Time (ms) the current wait started. */
+	uint64_t quiet_until;		/**< Time (ms) before which no command is written. */
+	uint8_t *data;			/**< Destination of the expected binary data. */
+	size_t data_sz;			/**< Number of expected binary data bytes left. */
+} at_intfc;
+
 /**
  * \brief Initialize the AT command interpreter interface.
+ * \param[in] at Pointer to the interface instance to initialize.
  * \param[in] driver Pointer to the modem's driver.
  * \retval true AT interpreter was successfully initialized.
  * \retval false Initialization failed.
  * \note This routine must be called once before all other routines in this module.
  */
-bool at_init(TsDriverRef_t driver);
+bool at_init(at_intfc *at, TsDriverRef_t driver);
 
 /**
  * \brief Register URC descriptors with the AT interface.
  * \details If a new set of URCs are registered, the older set is automatically
- * unregistered.
+ * unregistered. The descriptors are copied into the interface, so the same
+ * (constant) array may be registered with several interfaces. At most
+ * \ref AT_MAX_URCS descriptors are registered.
+ * \param[in] at Pointer to the interface instance.
  * \param[in] sz Number of elements in the URC descriptor array.
  * \param[in] urc Pointer to an array of URC descriptors.
+ * \param[in] pvt_data Pointer to private data passed to the URC callbacks.
  * \pre \ref at_init must be called before using this routine.
  */
-void at_reg_urcs(size_t sz, at_urc_desc urcs[]);
+void at_reg_urcs(at_intfc *at, size_t sz, const at_urc_desc urcs[], void *pvt_data);
 
 /**
- * \brief Issue a command on the AT interface.
+ * \brief Issue a command on the AT interface, and wait for its completion.
+ * \details The command is queued (see \ref at_submit), and the interface is
+ * serviced until it completes, sleeping whenever there's nothing to process.
+ * \param[in] at Pointer to the interface instance.
  * \param[in] at_cmd Pointer to the command descriptor of the AT command to be
  * issued.
  * \return A value of \ref at_wcmd_res type that describes the result of the
  * operation.
  * \pre \ref at_init must be called before using this routine.
  */
-at_wcmd_res at_wcmd(const at_cmd_desc *at_cmd);
+at_wcmd_res at_wcmd(at_intfc *at, const at_cmd_desc *at_cmd);
+
+/**
+ * \brief Queue a command on the AT interface, without waiting.
+ * \details The command is written, and its responses matched, as the
+ * interface is serviced (see \ref at_intfc_service), then the completion
+ * callback is invoked. The descriptor is copied, but the command bytes and
+ * the response private data it points to must remain valid until completion.
+ * \param[in] at Pointer to the interface instance.
+ * \param[in] at_cmd Pointer to the command descriptor.
+ * \param[in] done Completion callback, or NULL.
+ * \param[in] done_data Pointer to private data passed to the callback.
+ * \retval true The command was queued.
+ * \retval false Invalid parameters, or the queue is full.
+ * \pre \ref at_init must be called before using this routine.
+ */
+bool at_submit(at_intfc *at, const at_cmd_desc *at_cmd, at_done_callback done, void *done_data);
+
+/**
+ * \brief Check whether commands are queued on the AT interface.
+ * \param[in] at Pointer to the interface instance.
+ * \retval true At least one command is queued or in progress.
+ * \retval false The interface is idle.
+ */
+bool at_busy(at_intfc *at);
+
+/**
+ * \brief Expect binary data after the response being processed.
+ * \details Called from a response callback, when the response announces a
+ * number of data bytes (e.g. a socket read). The bytes are copied into the
+ * given buffer as they arrive, before any following response is matched.
+ * \param[in] at Pointer to the interface instance.
+ * \param[in] sz Number of data bytes.
+ * \param[in] data Pointer to the buffer receiving the data bytes.
+ */
+void at_expect_data(at_intfc *at, size_t sz, uint8_t data[]);
+
+/**
+ * \brief Wait for received bytes.
+ * \details Sleeps until the driver delivers bytes (see \ref at_rx_ready) or
+ * the timeout expires.
+ * \param[in] at Pointer to the interface instance.
+ * \param[in] timeout_ms Maximum time to wait, in milliseconds.
+ * \retval true Bytes arrived.
+ * \retval false The timeout expired.
+ */
+bool at_wait_rx(at_intfc *at, uint32_t timeout_ms);
 
 /**
  * \brief Write raw bytes to the AT interface.
+ * \param[in] at Pointer to the interface instance.
  * \param[in] sz Number of bytes to write to the interface.
  * \param[in] data Pointer to the source data.
  * \retval true Write succeeded.
  * \retval false Write failed.
  * \pre \ref at_init must be called before using this routine.
  */
-bool at_write(size_t sz, const uint8_t data[]);
+bool at_write(at_intfc *at, size_t sz, const uint8_t data[]);
 
 /**
  * \brief Return the number of unread bytes in the internal AT buffer.
+ * \param[in] at Pointer to the interface instance.
  * \return Number of bytes that are unread in the internal AT buffer.
  * \pre \ref at_init must be called before using this routine.
  */
-size_t at_avail_bytes(void);
+size_t at_avail_bytes(at_intfc *at);
+
+/**
+ * \brief Check (and clear) the receive notification.
+ * \details The driver's reader callback (usually an interrupt) flags every
+ * arrival of bytes, so that a caller waiting on the modem can sleep between
+ * checks rather than scanning the internal AT buffer.
+ * \param[in] at Pointer to the interface instance.
+ * \retval true Bytes arrived since the last check.
+ * \retval false Nothing arrived since the last check.
+ * \pre \ref at_init must be called before using this routine.
+ */
+bool at_rx_ready(at_intfc *at);
+
+/**
+ * \brief Retrieve the overflow accounting of the internal AT buffer.
+ * \details Bytes delivered by the driver while the buffer is full are
+ * dropped, see \ref rbuf_stats.
+ * \param[in] at Pointer to the interface instance.
+ * \param[out] stats Pointer to the statistics to fill in.
+ * \pre \ref at_init must be called before using this routine.
+ */
+void at_get_rx_stats(at_intfc *at, rbuf_stats *stats);
 
 /**
  * \brief Read the next few unread bytes.
  * \details This routine is used to read the unread bytes into the user supplied
  * buffer from the beginning of the internal AT buffer.
  *
+ * \param[in] at Pointer to the interface instance.
  * \param[in] sz Number of bytes to read.
  * \param[in] data Pointer to the buffer where the data will be read into.
  *
@@ -194,15 +345,16 @@ size_t at_avail_bytes(void);
  *
  * \pre \ref at_init must be called before using this routine.
  */
-size_t at_read_bytes(size_t sz, uint8_t data[]);
+size_t at_read_bytes(at_intfc *at, size_t sz, uint8_t data[]);
 
 /**
  * \brief Clear the AT receive buffer.
  * \details Unprocessed URCs and command responses will be lost after a call to
  * this routine.
+ * \param[in] at Pointer to the interface instance.
  * \pre \ref at_init must be called before using this routine.
  */
-void at_clear_rxbuf(void);
+void at_clear_rxbuf(at_intfc *at);
 
 /**
  * \brief Inform the AT interface the state of the modem's echo settings.
@@ -210,32 +362,37 @@ void at_clear_rxbuf(void);
  * response correctly. If echo is on, the effective response received by the
  * modem is prepended by the command. When echo is off, only the response is
  * returned.
+ * \param[in] at Pointer to the interface instance.
  * \param[in] on If set to true, it means that the modem has echo enabled.
  */
-void at_set_echo(bool on);
+void at_set_echo(at_intfc *at, bool on);
 
 /**
  * \brief Service the AT interface.
  * \details This routine must be called periodically to ensure the AT interface
- * processes all inputs and reacts to all URCs.
+ * processes all inputs and reacts to all URCs. It advances the queued commands
+ * as far as the received bytes allow, and never waits.
+ * \param[in] at Pointer to the interface instance.
  */
-void at_intfc_service(void);
+void at_intfc_service(at_intfc *at);
 
 /**
  * \brief Flush the first few bytes.
  * \detail Removes bytes from the beginning of the internal AT buffer.
+ * \param[in] at Pointer to the interface instance.
  * \param[in] sz Number of bytes to remove. If this is larger than the number of
  * bytes available, all bytes are removed.
  */
-void at_discard_begin_bytes(size_t sz);
+void at_discard_begin_bytes(at_intfc *at, size_t sz);
 
 /**
  * \brief Helper function to toggle debug output.
  * \detail This routine can be used to prevent \ref at_wcmd from echoing the
  * command it is executing. It can be useful when the command involves writing
  * non-ASCII characters to the debug port.
+ * \param[in] at Pointer to the interface instance.
  * \param[in] on Set to true to turn on echo, false to turn it off.
  */
-void at_toggle_cmd_echo(bool on);
+void at_toggle_cmd_echo(at_intfc *at, bool on);
 
 #endif
@@ -6,35 +6,97 @@
 /* Refers to the first unread byte in the ring buffer. */
 #define RBUF_BEGIN                     ((size_t)0xFFFFFFFF)
 
+/* Position of the free running index i in the (power of two sized) buffer. */
+#define RBUF_POS(r, i)                 ((i) & ((r)->sz - 1))
+
+/*
+ * Index ordering between the producer (usually an interrupt) and the consumer.
+ * An index is published with release semantics only once the bytes it covers
+ * are copied, and the other side's index is loaded with acquire semantics
+ * before the bytes are touched. Toolchains without the atomic builtins fall
+ * back to the volatile accesses, which suffice on single core targets.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define RBUF_LOAD_ACQUIRE(p)           __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RBUF_STORE_RELEASE(p, v)       __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define RBUF_LOAD_ACQUIRE(p)           (*(p))
+#define RBUF_STORE_RELEASE(p, v)       (*(p) = (v))
+#endif
+
 bool rbuf_init(rbuf *r, size_t len, volatile uint8_t buffer[])
 {
-	if (r == NULL || len == RBUF_BEGIN || buffer == NULL)
+	if (r == NULL || len == 0 || (len & (len - 1)) != 0 || buffer == NULL)
 		return false;
 	r->sz = len;
 	r->data = buffer;
-	rbuf_clear(r);
+	r->ridx = 0;
+	r->widx = 0;
+	memset((void *)&r->stats, 0, sizeof(r->stats));
 	return true;
 }
 
+/*
+ * Called by the producer only. Copy in at most two segments, i.e. up to the
+ * end of the buffer and then from its beginning. A write that doesn't fit is
+ * dropped as a whole, and accounted for in the statistics.
+ */
 bool rbuf_wbs(rbuf *r, size_t sz, const uint8_t data[])
 {
-	if (r == NULL || data == NULL || (r->widx - r->ridx) + sz > r->sz)
+	if (r == NULL || data == NULL)
+		return false;
+	size_t widx = r->widx;
+	size_t unread = widx - RBUF_LOAD_ACQUIRE(&r->ridx);
+	if (unread + sz > r->sz) {
+		r->stats.overflows++;
+		r->stats.dropped += sz;
 		return false;
-	for (size_t i = 0; i < sz; i++) {
-		r->data[r->widx % r->sz] = data[i];
-		r->widx++;
 	}
+	size_t pos = RBUF_POS(r, widx);
+	size_t first = r->sz - pos < sz ? r->sz - pos : sz;
+	memcpy((uint8_t *)r->data + pos, data, first);
+	memcpy((uint8_t *)r->data, data + first, sz - first);
+	RBUF_STORE_RELEASE(&r->widx, widx + sz);
+	if (unread + sz > r->stats.high_water)
+		r->stats.high_water = unread + sz;
 	return true;
 }
 
+/* Called by the consumer only, as are all the following routines. */
 bool rbuf_rbs(rbuf *r, size_t sz, uint8_t data[])
 {
-	if (r == NULL || data == NULL || r->widx - r->ridx < sz)
+	if (r == NULL || data == NULL)
 		return false;
-	for (size_t i = 0; i < sz; i++) {
-		data[i] = r->data[r->ridx % r->sz];
-		r->ridx++;
-	}
+	size_t ridx = r->ridx;
+	if (RBUF_LOAD_ACQUIRE(&r->widx) - ridx < sz)
+		return false;
+	size_t pos = RBUF_POS(r, ridx);
+	size_t first = r->sz - pos < sz ? r->sz - pos : sz;
+	memcpy(data, (const uint8_t *)r->data + pos, first);
+	memcpy(data + first, (const uint8_t *)r->data, sz - first);
+	RBUF_STORE_RELEASE(&r->ridx, ridx + sz);
+	return true;
+}
+
+size_t rbuf_peek(const rbuf * const r, const uint8_t **data)
+{
+	if (r == NULL || data == NULL)
+		return 0;
+	size_t ridx = r->ridx;
+	size_t unread = RBUF_LOAD_ACQUIRE(&r->widx) - ridx;
+	size_t pos = RBUF_POS(r, ridx);
+	*data = (const uint8_t *)r->data + pos;
+	return r->sz - pos < unread ? r->sz - pos : unread;
+}
+
+bool rbuf_commit(rbuf *r, size_t sz)
+{
+	if (r == NULL)
+		return false;
+	size_t ridx = r->ridx;
+	if (RBUF_LOAD_ACQUIRE(&r->widx) - ridx < sz)
+		return false;
+	RBUF_STORE_RELEASE(&r->ridx, ridx + sz);
 	return true;
 }
 
@@ -42,15 +104,24 @@ size_t rbuf_unread(const rbuf * const r)
 {
 	if (r == NULL)
 		return 0;
-	return (size_t)(r->widx - r->ridx);
+	return (size_t)(RBUF_LOAD_ACQUIRE(&r->widx) - r->ridx);
 }
 
+/* The write index belongs to the producer, so clearing consumes all unread bytes instead. */
 void rbuf_clear(rbuf *r)
 {
 	if (r == NULL)
 		return;
-	r->ridx = 0;
-	r->widx = 0;
+	RBUF_STORE_RELEASE(&r->ridx, RBUF_LOAD_ACQUIRE(&r->widx));
+}
+
+void rbuf_get_stats(const rbuf * const r, rbuf_stats *stats)
+{
+	if (r == NULL || stats == NULL)
+		return;
+	stats->overflows = RBUF_LOAD_ACQUIRE(&r->stats.overflows);
+	stats->dropped = RBUF_LOAD_ACQUIRE(&r->stats.dropped);
+	stats->high_water = RBUF_LOAD_ACQUIRE(&r->stats.high_water);
 }
 
 void rbuf_reset_fmt_desc(match_fmt_t *m)
@@ -95,7 +166,9 @@ match_res_t rbuf_matchf(const rbuf * const r, match_fmt_t *m, size_t *sz)
 	if (r == NULL || m == NULL || sz == NULL)
 		return MATCH_ERR;
 
-	if (r->widx - r->ridx == 0 || m->fmt == NULL)
+	/* Match against the bytes written so far, i.e. a snapshot of the write index. */
+	size_t widx = RBUF_LOAD_ACQUIRE(&r->widx);
+	if (widx - r->ridx == 0 || m->fmt == NULL)
 		return MATCH_FAIL;
 
 	/*
@@ -107,12 +180,12 @@ match_res_t rbuf_matchf(const rbuf * const r, match_fmt_t *m, size_t *sz)
 
 	size_t i = m->sidx == RBUF_BEGIN ? r->ridx : m->sidx;
 
-	while (i != r->widx && m->fmt[m->cidx] != '\0') {
+	while (i != widx && m->fmt[m->cidx] != '\0') {
 		if (m->m_func == NULL && m->fmt[m->cidx] == '%')
 			if (!set_match_func(m))
 				return MATCH_ERR;
 
-		size_t ridx = i % r->sz;		/* Adjust read index into buffer */
+		size_t ridx = RBUF_POS(r, i);		/* Adjust read index into buffer */
 		if (m->m_func == NULL) {		/* Literal comparison */
 			if (m->fmt[m->cidx++] != r->data[ridx])
 				return MATCH_FAIL;
@@ -137,3 +210,175 @@ match_res_t rbuf_matchf(const rbuf * const r, match_fmt_t *m, size_t *sz)
 	m->sidx = i;
 	return MATCH_PARTIAL;
 }
+
+void rbuf_init_set(match_set_t *s)
+{
+	memset(s, 0, sizeof(*s));
+	s->num_nodes = 1;			/* The root */
+	rbuf_reset_set(s);
+}
+
+void rbuf_reset_set(match_set_t *s)
+{
+	s->sidx = RBUF_BEGIN;
+	s->num_active = 0;
+}
+
+/* Return non-zero if ch belongs to the wildcard class. */
+static int match_class(uint8_t cls, int ch)
+{
+	switch (cls) {
+	case 'u':
+		return isdigit(ch);
+	case 's':
+		return isalnum(ch);
+	case 'x':
+		return isxdigit(ch);
+	default:
+		return 0;
+	}
+}
+
+bool rbuf_add_to_set(match_set_t *s, const char *fmt, size_t idx)
+{
+	if (s == NULL || fmt == NULL || fmt[0] == '\0' || idx >= UINT8_MAX)
+		return false;
+
+	size_t num_nodes = s->num_nodes;
+	size_t node = 0;
+	for (size_t cidx = 0; fmt[cidx] != '\0'; cidx++) {
+		uint8_t ch = (uint8_t)fmt[cidx];
+		uint8_t cls = 0;
+		if (ch == '%') {
+			cidx++;
+			switch (fmt[cidx]) {
+			case 'u':
+			case 's':
+			case 'x':
+				cls = (uint8_t)fmt[cidx];
+				ch = 0;
+				break;
+			case '%':
+				break;
+			default:
+				goto undo;		/* Format string error */
+			}
+		}
+
+		/* Follow the shared prefix, or append a new node. */
+		size_t next = s->nodes[node].child;
+		size_t last = 0;
+		while (next != 0 && (s->nodes[next].cls != cls || s->nodes[next].ch != ch)) {
+			last = next;
+			next = s->nodes[next].sibling;
+		}
+		if (next == 0) {
+			if (s->num_nodes >= MATCH_SET_MAX_NODES)
+				goto undo;
+			next = s->num_nodes++;
+			memset(&s->nodes[next], 0, sizeof(s->nodes[next]));
+			s->nodes[next].ch = ch;
+			s->nodes[next].cls = cls;
+			if (last == 0)
+				s->nodes[node].child = (uint8_t)next;
+			else
+				s->nodes[last].sibling = (uint8_t)next;
+		}
+		node = next;
+	}
+	if (s->nodes[node].accept == 0)
+		s->nodes[node].accept = (uint8_t)(idx + 1);
+	rbuf_reset_set(s);
+	return true;
+
+undo:
+	/* Unlink the nodes appended by this format. */
+	for (size_t i = 0; i < num_nodes; i++) {
+		if (s->nodes[i].child >= num_nodes)
+			s->nodes[i].child = 0;
+		if (s->nodes[i].sibling >= num_nodes)
+			s->nodes[i].sibling = 0;
+	}
+	s->num_nodes = num_nodes;
+	return false;
+}
+
+/*
+ * Advance every active node by one byte. A wildcard that matched at least one
+ * byte is greedy, i.e. it keeps the byte whenever it belongs to its class,
+ * otherwise the byte is compared against the node's children.
+ */
+static size_t advance_set(const match_set_t *s, const uint8_t active[], size_t num_active,
+		uint8_t ch, uint8_t next[])
+{
+	uint32_t seen[(MATCH_SET_MAX_NODES + 31) / 32] = { 0 };
+	size_t num_next = 0;
+	for (size_t a = 0; a < num_active; a++) {
+		size_t node = active[a];
+		if (s->nodes[node].cls != 0 && match_class(s->nodes[node].cls, ch)) {
+			if (!(seen[node / 32] & (1UL << (node % 32)))) {
+				seen[node / 32] |= 1UL << (node % 32);
+				next[num_next++] = (uint8_t)node;
+			}
+			continue;
+		}
+		for (size_t c = s->nodes[node].child; c != 0; c = s->nodes[c].sibling) {
+			const match_node_t *n = &s->nodes[c];
+			if (n->cls == 0 ? n->ch != ch : !match_class(n->cls, ch))
+				continue;
+			if (!(seen[c / 32] & (1UL << (c % 32)))) {
+				seen[c / 32] |= 1UL << (c % 32);
+				next[num_next++] = (uint8_t)c;
+			}
+		}
+	}
+	return num_next;
+}
+
+match_res_t rbuf_match_set(const rbuf * const r, match_set_t *s, size_t *idx, size_t *sz)
+{
+	if (r == NULL || s == NULL || idx == NULL || sz == NULL)
+		return MATCH_ERR;
+
+	size_t widx = RBUF_LOAD_ACQUIRE(&r->widx);
+	size_t ridx = r->ridx;
+	if (widx - ridx == 0 || s->num_nodes <= 1)
+		return MATCH_FAIL;
+
+	/* Resume the search, unless the bytes it covered were consumed since. */
+	if (s->sidx == RBUF_BEGIN || s->ridx != ridx) {
+		s->sidx = ridx;
+		s->ridx = ridx;
+		s->active[0] = 0;
+		s->num_active = 1;
+	}
+
+	size_t i = s->sidx;
+	while (i != widx) {
+		uint8_t next[MATCH_SET_MAX_NODES];
+		uint8_t ch = r->data[RBUF_POS(r, i)];
+		size_t num_next = advance_set(s, s->active, s->num_active, ch, next);
+		i++;
+		if (num_next == 0) {
+			rbuf_reset_set(s);
+			return MATCH_FAIL;
+		}
+		memcpy(s->active, next, num_next);
+		s->num_active = num_next;
+
+		uint8_t accept = 0;
+		for (size_t a = 0; a < num_next; a++) {
+			uint8_t node_accept = s->nodes[next[a]].accept;
+			if (node_accept != 0 && (accept == 0 || node_accept < accept))
+				accept = node_accept;
+		}
+		if (accept != 0) {
+			*idx = (size_t)(accept - 1);
+			*sz = (size_t)(i - ridx);
+			rbuf_reset_set(s);
+			return MATCH_OK;
+		}
+	}
+	s->sidx = i;
+	return MATCH_PARTIAL;
+}
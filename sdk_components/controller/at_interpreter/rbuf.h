@@ -5,6 +5,13 @@
  * \details Usually, the writer is an interrupt and the consumer is the
  * execution thread. In addition to reading from and writing to the ring buffer,
  * this module also provides a wildcard based search function.
+ *
+ * No locks are taken. The producer only ever advances the write index, and
+ * only after the bytes are copied (release). The consumer only ever advances
+ * the read index, and only reads bytes below the write index it loaded
+ * (acquire). \ref rbuf_wbs is the only producer routine, all the others
+ * belong to the consumer (\ref rbuf_init excepted, which is called before
+ * either side starts).
  */
 
 #ifndef _RBUF_H
@@ -14,14 +21,25 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * \brief Type describing the overflow accounting of a ring buffer.
+ * \details Only updated by the producer, see \ref rbuf_get_stats.
+ */
+typedef struct {
+	volatile size_t overflows;	/**< Number of writes dropped for lack of space */
+	volatile size_t dropped;	/**< Number of bytes dropped for lack of space */
+	volatile size_t high_water;	/**< Largest number of unread bytes so far */
+} rbuf_stats;
+
 /**
  * \brief Type describing a single producer, single consumer ring buffer.
  */
 typedef struct {
-	volatile size_t ridx;	/**< Read index */
-	volatile size_t widx;	/**< Write index */
-	size_t sz;		/**< Maximum size of the ring buffer */
+	volatile size_t ridx;	/**< Read index, only advanced by the consumer */
+	volatile size_t widx;	/**< Write index, only advanced by the producer */
+	size_t sz;		/**< Maximum size of the ring buffer (a power of two) */
 	volatile uint8_t *data;	/**< Pointer to the data buffer */
+	rbuf_stats stats;	/**< Overflow accounting */
 } rbuf;
 
 /**
@@ -55,6 +73,41 @@ typedef struct {
 	match_func_t m_func;	/**< Privately used function pointer. */
 } match_fmt_t;
 
+/**
+ * \brief Maximum number of nodes in a compiled match set.
+ */
+#define MATCH_SET_MAX_NODES	128
+
+/**
+ * \brief Defines a node of a compiled match set, i.e. one literal byte or one
+ * wildcard of a format string.
+ * \note The fields are private and shouldn't be modified directly.
+ */
+typedef struct {
+	uint8_t ch;		/**< Literal byte, when cls is zero. */
+	uint8_t cls;		/**< Wildcard class ('u', 's' or 'x'), or zero. */
+	uint8_t child;		/**< First child node, or zero. */
+	uint8_t sibling;	/**< Next sibling node, or zero. */
+	uint8_t accept;		/**< Index (plus one) of the format ending here, or zero. */
+} match_node_t;
+
+/**
+ * \brief Defines a set of format strings compiled into a single automaton.
+ * \details The formats share their common prefixes (in a trie), and are
+ * matched together in a single pass over the ring buffer, so that the cost of
+ * a match doesn't grow with the number of formats. The formats use the same
+ * wildcards as \ref match_fmt_t.
+ * \note The fields are private and shouldn't be modified directly.
+ */
+typedef struct {
+	match_node_t nodes[MATCH_SET_MAX_NODES];	/**< The trie, node 0 is the root. */
+	size_t num_nodes;				/**< Number of nodes in use. */
+	size_t sidx;					/**< Privately used counter. */
+	size_t ridx;					/**< Privately used counter. */
+	uint8_t active[MATCH_SET_MAX_NODES];		/**< Nodes matched so far. */
+	size_t num_active;				/**< Number of nodes matched so far. */
+} match_set_t;
+
 /**
  * \brief Type describing the result of the match routine.
  */
@@ -67,8 +120,10 @@ typedef enum {
 
 /**
  * \brief Initialize the ring buffer descriptor.
+ * \details The size must be a power of two, so that indices wrap with a mask
+ * rather than a division.
  * \param[in] r Pointer to the ring buffer descriptor to initialize.
- * \param[in] len Maximum size of the ring buffer in bytes.
+ * \param[in] len Maximum size of the ring buffer in bytes (a power of two).
  * \param[in] buffer Pointer to the underlying buffer to be used.
  * \retval true Ring buffer was initialized successfully.
  * \retval false Failed to initialize ring buffer.
@@ -81,7 +136,8 @@ bool rbuf_init(rbuf *r, size_t len, volatile uint8_t buffer[]);
  * \param[in] sz Size of the data to write into the ring buffer.
  * \param[in] data Pointer to source data buffer.
  * \retval true Data was successfully written into the ring buffer.
- * \retval false Write failed due to space availability.
+ * \retval false Write failed due to space availability. The data is dropped
+ * as a whole, and counted in the overflow statistics.
  */
 bool rbuf_wbs(rbuf *r, size_t sz, const uint8_t data[]);
 
@@ -95,6 +151,28 @@ bool rbuf_wbs(rbuf *r, size_t sz, const uint8_t data[]);
  */
 bool rbuf_rbs(rbuf *r, size_t sz, uint8_t data[]);
 
+/**
+ * \brief Peek at the unread bytes without copying them.
+ * \details Points at the first unread byte, and returns the number of unread
+ * bytes that follow it contiguously, i.e. up to the end of the underlying
+ * buffer. The bytes remain unread until \ref rbuf_commit is called.
+ * \param[in] r Pointer to the ring buffer to use.
+ * \param[out] data Pointer set to the first unread byte.
+ * \returns Number of contiguous unread bytes at \ref data.
+ */
+size_t rbuf_peek(const rbuf * const r, const uint8_t **data);
+
+/**
+ * \brief Consume bytes from the ring buffer without copying them.
+ * \details Typically called once the bytes returned by \ref rbuf_peek are
+ * parsed, or to discard bytes.
+ * \param[in] r Pointer to the ring buffer to use.
+ * \param[in] sz Number of bytes to consume.
+ * \retval true The bytes were consumed.
+ * \retval false Failed due to inavailibility of data in the ring buffer.
+ */
+bool rbuf_commit(rbuf *r, size_t sz);
+
 /**
  * \brief Retrieve the number of unread bytes.
  * \param[in] r Pointer to ring buffer to use.
@@ -104,10 +182,19 @@ size_t rbuf_unread(const rbuf * const r);
 
 /**
  * \brief Clear the ring contents of the ring buffer.
+ * \details The unread bytes are consumed, i.e. this is safe to call while the
+ * producer is writing.
  * \param[in] r Pointer to the ring buffer to use.
  */
 void rbuf_clear(rbuf *r);
 
+/**
+ * \brief Retrieve the overflow accounting of the ring buffer.
+ * \param[in] r Pointer to the ring buffer to use.
+ * \param[out] stats Pointer to the statistics to fill in.
+ */
+void rbuf_get_stats(const rbuf * const r, rbuf_stats *stats);
+
 /**
  * \brief Attempt matching the contents of the ring buffer to the format string.
  * \details The search begins at the first unread byte of the ring buffer. On a
@@ -128,4 +215,44 @@ match_res_t rbuf_matchf(const rbuf * const r, match_fmt_t *m, size_t *sz);
  * \param[in] m Pointer to the format descriptor.
  */
 void rbuf_reset_fmt_desc(match_fmt_t *m);
+
+/**
+ * \brief Initialize an empty match set.
+ * \param[in] s Pointer to the match set.
+ */
+void rbuf_init_set(match_set_t *s);
+
+/**
+ * \brief Compile a format string into the match set.
+ * \details On failure, the match set is left unchanged.
+ * \param[in] s Pointer to the match set.
+ * \param[in] fmt Pointer to the NULL terminated format string.
+ * \param[in] idx Index reported when this format matches (less than 255).
+ * \retval true The format was added.
+ * \retval false Error in the format string, or the set is full.
+ */
+bool rbuf_add_to_set(match_set_t *s, const char *fmt, size_t idx);
+
+/**
+ * \brief Attempt matching the contents of the ring buffer to a match set.
+ * \details The search begins at the first unread byte of the ring buffer, and
+ * resumes where the previous call stopped on a partial match (each byte is
+ * examined once). On a successful match, \ref idx will hold the index of the
+ * matched format and \ref sz the size, in bytes, of the matched result. When
+ * several formats match, the shortest match wins, then the lowest index.
+ *
+ * \param[in] r Pointer to the ring buffer to use.
+ * \param[in] s Pointer to the match set.
+ * \param[out] idx Pointer to the index of the matched format.
+ * \param[out] sz Pointer to the buffer that will hold the size of the match.
+ *
+ * \returns The result of the match. See \ref match_res_t.
+ */
+match_res_t rbuf_match_set(const rbuf * const r, match_set_t *s, size_t *idx, size_t *sz);
+
+/**
+ * \brief Helper function to reset a match set, i.e. restart the search.
+ * \param[in] s Pointer to the match set.
+ */
+void rbuf_reset_set(match_set_t *s);
 #endif
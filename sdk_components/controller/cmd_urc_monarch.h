@@ -111,7 +111,7 @@ static const at_cmd_desc core_cmd_list[NUM_CORE_CMDS] = {
 	}
 };
 
-static at_cmd_desc query_cmd_list[NUM_MODEM_INFO_CMDS] = {
+static const at_cmd_desc query_cmd_list[NUM_MODEM_INFO_CMDS] = {
 	[QUERY_IMEI] = {
 		.cmd = "at+cgsn\r",
 		.err = err_str,
@@ -241,7 +241,7 @@ static at_cmd_desc query_cmd_list[NUM_MODEM_INFO_CMDS] = {
 	}
 };
 
-static at_cmd_desc tcp_cmd_list[NUM_TCP_CMDS] = {
+static const at_cmd_desc tcp_cmd_list[NUM_TCP_CMDS] = {
 	[PDP_ACT] = {
 		.cmd = "at+cgact=1,"MODEM_PDP_CTX"\r",
 		.err = err_str,
@@ -273,7 +273,7 @@ static at_cmd_desc tcp_cmd_list[NUM_TCP_CMDS] = {
 		.timeout = 5000
 	},
 	[SOCK_DIAL] = {
-		.cmd_fmt = "at+sqnsd="MODEM_SOCK_ID",0,%s,\"%s\",0,0,1\r",
+		.cmd_fmt = "at+sqnsd="MODEM_SOCK_ID",%d,%s,\"%s\",0,0,1\r",
 		.err = err_str,
 		.resp = {
 			{
@@ -319,6 +319,10 @@ static at_cmd_desc tcp_cmd_list[NUM_TCP_CMDS] = {
 			{
 				.exp_resp = "\r\n+SQNSRECV: "MODEM_SOCK_ID",%u\r\n",
 				.resp_cb = parse_tcp_data
+			},
+			{
+				/* Follows the data bytes */
+				.exp_resp = "\r\n\r\nOK\r\n"
 			}
 		},
 		.timeout = 5000
@@ -326,12 +330,12 @@ static at_cmd_desc tcp_cmd_list[NUM_TCP_CMDS] = {
 };
 
 /* URC Callbacks */
-static void sys_start(size_t sz, const char urc_text[]);
-static void parse_cereg_urc(size_t sz, const char urc_text[]);
-static void tcp_conn_closed(size_t sz, const char urc_text[]);
-static void tcp_recv_bytes(size_t sz, const char urc_text[]);
+static void sys_start(size_t sz, const char urc_text[], void *pvt_data);
+static void parse_cereg_urc(size_t sz, const char urc_text[], void *pvt_data);
+static void tcp_conn_closed(size_t sz, const char urc_text[], void *pvt_data);
+static void tcp_recv_bytes(size_t sz, const char urc_text[], void *pvt_data);
 
-static at_urc_desc urc_list[NUM_URCS] = {
+static const at_urc_desc urc_list[NUM_URCS] = {
 	[SYS_START_URC] = {
 		.urc = {
 			.fmt = "\r\n+SYSSTART\r\n"
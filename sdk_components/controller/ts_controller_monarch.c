@@ -23,6 +23,7 @@ static TsStatus_t ts_connect( TsControllerRef_t, TsAddress_t );
 static TsStatus_t ts_disconnect( TsControllerRef_t );
 static TsStatus_t ts_read( TsControllerRef_t, const uint8_t *, size_t *, uint32_t );
 static TsStatus_t ts_write( TsControllerRef_t, const uint8_t *, size_t *, uint32_t );
+static TsStatus_t ts_wait( TsControllerRef_t, uint32_t );
 
 static TsStatus_t ts_get_id( TsControllerRef_t, char * );
 static TsStatus_t ts_get_rssi( TsControllerRef_t, char * );
@@ -43,6 +44,7 @@ TsControllerVtable_t ts_controller_monarch = {
 	.disconnect = ts_disconnect,
 	.read = ts_read,
 	.write = ts_write,
+	.wait = ts_wait,
 
 	.get_id = ts_get_id,
 	.get_rssi = ts_get_rssi,
@@ -77,17 +79,35 @@ typedef struct {
 #define SIZEOF_TEXT_INFO        TS_DRIVER_MAX_ID_SIZE
 #define SIZEOF_IMEI             15
 
+#define MAX_TCP_DATA_LEN            1500
+
 typedef struct TsControllerMonarch * TsControllerMonarchRef_t;
+
+/* State passed to the socket receive response callback. */
+typedef struct {
+	TsControllerMonarchRef_t modem;
+	array_t bytes;
+} tcp_recv_t;
+
 typedef struct TsControllerMonarch {
 
 	TsController_t _controller;
-	bool being_used;
+	at_intfc at;
 	bool modem_started;
 	net_reg_stat reg_to_net;
 	bool tcp_connected;
 	bool tcp_peer_close;
 	size_t unread_tcp;
 
+	/* Socket bytes received ahead of the reads asking for them */
+	uint8_t rx_buf[MAX_TCP_DATA_LEN];
+	size_t rx_index;
+	size_t rx_count;
+	bool rx_pending;
+	at_wcmd_res rx_res;
+	char rx_cmd[32];
+	tcp_recv_t rx_recv;
+
 	/* Diagnostics information */
 	char imei[SIZEOF_IMEI + 1];
 	char rssi[SIZEOF_RSSI + 1];
@@ -101,12 +121,9 @@ typedef struct TsControllerMonarch {
 
 } TsControllerMonarch_t;
 
-// XXX: For now, only one instance of the controller is possible.
-// This needs to be configurable in a future release.
-static TsControllerMonarch_t monarch;
-
-static void sys_start( size_t sz, const char urc_text[] ) {
-	monarch.modem_started = true;
+static void sys_start( size_t sz, const char urc_text[], void * pvt_data ) {
+	TsControllerMonarchRef_t modem = pvt_data;
+	modem->modem_started = true;
 }
 
 static void parse_imei( size_t sz, const char resp[], void * pvt_data ) {
@@ -174,64 +191,67 @@ static void parse_firmware_version( size_t sz, const char resp[], void * pvt_dat
 		fw->data[ ( fw->sz )++ ] = resp[ i++ ];
 }
 
-#define TCP_RECV_TIMEOUT_MS            5000
-#define TCP_RECV_TRAIL_SZ            8
+/*
+ * The response header gives the number of data bytes that follow it, i.e., "\r\n+SQNSRECV: 1,<count>\r\n",
+ * the AT interface copies them as they arrive, then matches the trailing "\r\n\r\nOK\r\n".
+ */
 static void parse_tcp_data( size_t sz, const char resp[], void * pvt_data ) {
-	array_t * bytes = pvt_data;
-	size_t data_sz = bytes->sz;
-
-	uint64_t start = ts_platform_time_ms();
-	bool timeout = true;
-	do {
-		if( at_avail_bytes() >= data_sz + TCP_RECV_TRAIL_SZ ) {
-			timeout = false;
-			break;
-		}
-	} while(ts_platform_time_ms() - start <= TCP_RECV_TIMEOUT_MS );
-
-	if( timeout ) {
-		bytes->sz = 0;
-		return;
-	}
-
-	if( at_read_bytes( data_sz, (uint8_t *) bytes->data ) != data_sz ) {
-		bytes->sz = 0;
-		return;
-	}
+	tcp_recv_t * recv = pvt_data;
+	TsControllerMonarchRef_t modem = recv->modem;
+	array_t * bytes = &recv->bytes;
 
-	monarch.unread_tcp -= data_sz;
+	size_t num_idx = 0;
+	while( num_idx < sz && resp[ num_idx ] != ',' )
+		num_idx++;
+	size_t data_sz = 0;
+	for( num_idx++; num_idx < sz && resp[ num_idx ] >= '0' && resp[ num_idx ] <= '9'; num_idx++ )
+		data_sz = data_sz*10 + resp[ num_idx ] - '0';
 
-	/* Read the last 8 bytes: \r\n\r\nOK\r\n\. */
-	at_discard_begin_bytes( TCP_RECV_TRAIL_SZ );
+	if( data_sz > bytes->sz )
+		data_sz = bytes->sz;
+	bytes->sz = data_sz;
+	at_expect_data( &modem->at, data_sz, (uint8_t *) bytes->data );
 }
 
-static void parse_cereg_urc( size_t sz, const char urc_text[] ) {
+static void parse_cereg_urc( size_t sz, const char urc_text[], void * pvt_data ) {
+	TsControllerMonarchRef_t modem = pvt_data;
 	const uint8_t stat_idx = 10;
 	uint8_t net_stat = urc_text[ stat_idx ] - '0';
 	if( net_stat > MODEM_SEARCH_NET )
 		return;
-	monarch.reg_to_net = net_stat;
+	modem->reg_to_net = net_stat;
 }
 
-static void tcp_conn_closed( size_t sz, const char urc_text[] ) {
-	monarch.tcp_connected = false;
-	monarch.tcp_peer_close = true;
+static void tcp_conn_closed( size_t sz, const char urc_text[], void * pvt_data ) {
+	TsControllerMonarchRef_t modem = pvt_data;
+	modem->tcp_connected = false;
+	modem->tcp_peer_close = true;
 	mdbg( "Peer closed connection\n" );
 }
 
-static void tcp_recv_bytes( size_t sz, const char urc_text[] ) {
+static void tcp_recv_bytes( size_t sz, const char urc_text[], void * pvt_data ) {
+	TsControllerMonarchRef_t modem = pvt_data;
 	uint8_t num_idx = 15;
 	size_t num_unread = 0;
 	while( urc_text[ num_idx ] != '\r' ) {
 		num_unread = num_unread*10 + urc_text[ num_idx ] - '0';
 		num_idx++;
 	}
-	monarch.unread_tcp += num_unread;
+	modem->unread_tcp += num_unread;
+}
+
+/*
+ * The command tables are shared by all modem instances, so the response state is set on a
+ * copy of the descriptor rather than on the table itself.
+ */
+static bool modem_query( TsControllerMonarchRef_t modem, enum modem_info_cmds idx, void * pvt_data ) {
+	at_cmd_desc query = query_cmd_list[ idx ];
+	query.resp[ 0 ].pvt_data = pvt_data;
+	return at_wcmd( &modem->at, &query ) == AT_WCMD_OK;
 }
 
 static bool modem_get_imei( TsControllerMonarchRef_t modem ) {
-	query_cmd_list[ QUERY_IMEI ].resp[ 0 ].pvt_data = modem->imei;
-	if( at_wcmd( &query_cmd_list[ QUERY_IMEI ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_IMEI, modem->imei ))
 		return false;
 	modem->imei[ SIZEOF_IMEI ] = '\0';
 	return true;
@@ -239,8 +259,7 @@ static bool modem_get_imei( TsControllerMonarchRef_t modem ) {
 
 static bool modem_get_rssi( TsControllerMonarchRef_t modem ) {
 	array_t rssi_data = { 0, modem->rssi };
-	query_cmd_list[ QUERY_RSSI ].resp[ 0 ].pvt_data = &rssi_data;
-	if( at_wcmd( &query_cmd_list[ QUERY_RSSI ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_RSSI, &rssi_data ))
 		return false;
 	modem->rssi[ rssi_data.sz ] = '\0';
 	return true;
@@ -248,32 +267,28 @@ static bool modem_get_rssi( TsControllerMonarchRef_t modem ) {
 
 static bool modem_get_ipv4_addr( TsControllerMonarchRef_t modem ) {
 	array_t ip_data = { 0, modem->ipv4_addr };
-	query_cmd_list[ QUERY_IPV4_ADDR ].resp[ 0 ].pvt_data = &ip_data;
-	if( at_wcmd( &query_cmd_list[ QUERY_IPV4_ADDR ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_IPV4_ADDR, &ip_data ))
 		return false;
 	modem->ipv4_addr[ ip_data.sz ] = '\0';
 	return true;
 }
 
 static bool modem_get_iccid( TsControllerMonarchRef_t modem ) {
-	query_cmd_list[ QUERY_ICCID ].resp[ 0 ].pvt_data = modem->iccid;
-	if( at_wcmd( &query_cmd_list[ QUERY_ICCID ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_ICCID, modem->iccid ))
 		return false;
 	modem->iccid[ SIZEOF_ICCID ] = '\0';
 	return true;
 }
 
 static bool modem_get_date_and_time( TsControllerMonarchRef_t modem ) {
-	query_cmd_list[ QUERY_DATE_AND_TIME ].resp[ 0 ].pvt_data = modem->date_and_time;
-	if( at_wcmd( &query_cmd_list[ QUERY_DATE_AND_TIME ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_DATE_AND_TIME, modem->date_and_time ))
 		return false;
 	modem->date_and_time[ SIZEOF_DATE_AND_TIME ] = '\0';
 	return true;
 }
 
 static bool modem_get_imsi( TsControllerMonarchRef_t modem ) {
-	query_cmd_list[ QUERY_IMSI ].resp[ 0 ].pvt_data = modem->imsi;
-	if( at_wcmd( &query_cmd_list[ QUERY_IMSI ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_IMSI, modem->imsi ))
 		return false;
 	modem->imsi[ SIZEOF_IMSI ] = '\0';
 	return true;
@@ -281,8 +296,7 @@ static bool modem_get_imsi( TsControllerMonarchRef_t modem ) {
 
 static bool modem_get_manufacturer( TsControllerMonarchRef_t modem ) {
 	array_t man_data = { 0, modem->manufacturer };
-	query_cmd_list[ QUERY_MANUFACTURER ].resp[ 0 ].pvt_data = &man_data;
-	if( at_wcmd( &query_cmd_list[ QUERY_MANUFACTURER ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_MANUFACTURER, &man_data ))
 		return false;
 	modem->manufacturer[ man_data.sz ] = '\0';
 	return true;
@@ -290,8 +304,7 @@ static bool modem_get_manufacturer( TsControllerMonarchRef_t modem ) {
 
 static bool modem_get_module_name( TsControllerMonarchRef_t modem ) {
 	array_t mod_data = { 0, modem->module_name };
-	query_cmd_list[ QUERY_MODULE_NAME ].resp[ 0 ].pvt_data = &mod_data;
-	if( at_wcmd( &query_cmd_list[ QUERY_MODULE_NAME ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_MODULE_NAME, &mod_data ))
 		return false;
 	modem->module_name[ mod_data.sz ] = '\0';
 	return true;
@@ -299,8 +312,7 @@ static bool modem_get_module_name( TsControllerMonarchRef_t modem ) {
 
 static bool modem_get_firmware_version( TsControllerMonarchRef_t modem ) {
 	array_t fwver_data = { 0, modem->firmware_version };
-	query_cmd_list[ QUERY_FIRMWARE_VERSION ].resp[ 0 ].pvt_data = &fwver_data;
-	if( at_wcmd( &query_cmd_list[ QUERY_FIRMWARE_VERSION ] ) != AT_WCMD_OK )
+	if( !modem_query( modem, QUERY_FIRMWARE_VERSION, &fwver_data ))
 		return false;
 	modem->firmware_version[ fwver_data.sz ] = '\0';
 	return true;
@@ -313,19 +325,19 @@ static bool wait_for_net_reg( TsControllerMonarchRef_t m, uint32_t timeout_ms )
 			mdbg( "Timed out waiting for network attach\n" );
 			return false;
 		}
-		at_intfc_service();
-		ts_platform_sleep_ms( IDLE_TIME_MS );
+		at_intfc_service( &m->at );
+		at_wait_rx( &m->at, IDLE_TIME_MS );
 	}
 	return true;
 }
 
-static bool tcp_init( void ) {
+static bool tcp_init( TsControllerMonarchRef_t m ) {
 	ts_platform_sleep_ms( 1000 );
-	if( at_wcmd( &tcp_cmd_list[ PDP_ACT ] ) != AT_WCMD_OK )
+	if( at_wcmd( &m->at, &tcp_cmd_list[ PDP_ACT ] ) != AT_WCMD_OK )
 		return false;
-	if( at_wcmd( &tcp_cmd_list[ SOCK_CONF ] ) != AT_WCMD_OK )
+	if( at_wcmd( &m->at, &tcp_cmd_list[ SOCK_CONF ] ) != AT_WCMD_OK )
 		return false;
-	if( at_wcmd( &tcp_cmd_list[ SOCK_CONF_EXT ] ) != AT_WCMD_OK )
+	if( at_wcmd( &m->at, &tcp_cmd_list[ SOCK_CONF_EXT ] ) != AT_WCMD_OK )
 		return false;
 	return true;
 }
@@ -338,15 +350,15 @@ static bool process_startup_urcs( TsControllerMonarchRef_t m ) {
 			mdbg( "Timed out waiting for modem to start\n" );
 			return false;
 		}
-		at_intfc_service();
-		ts_platform_sleep_ms( IDLE_TIME_MS );
+		at_intfc_service( &m->at );
+		at_wait_rx( &m->at, IDLE_TIME_MS );
 	}
 	return true;
 }
 
 static bool modem_hardware_reset( TsControllerMonarchRef_t m ) {
 	m->modem_started = false;
-	at_clear_rxbuf();
+	at_clear_rxbuf( &m->at );
 	ts_driver_reset( m->_controller._driver );
 	return process_startup_urcs( m );
 }
@@ -385,15 +397,31 @@ void debug_diag( TsControllerMonarchRef_t modem ) {
 	mdbg( "Modem firmware version: %s\n", modem->firmware_version );
 }
 
+/*
+ * Undo a partial create, i.e., detach the at interface from the driver (its reader would
+ * otherwise be handed the freed controller) before destroying the driver and the controller.
+ */
+static TsStatus_t ts_create_failed( TsControllerRef_t * controller, const char * reason ) {
+	mdbg( "%s\n", reason );
+
+	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) *controller;
+	ts_driver_reader( ( *controller )->_driver, NULL, NULL );
+	ts_driver_destroy( ( *controller )->_driver );
+	ts_platform_free( controller_monarch, sizeof( TsControllerMonarch_t ));
+	*controller = NULL;
+	return TsStatusErrorInternalServerError;
+}
+
 static TsStatus_t ts_create( TsControllerRef_t * controller ) {
 	ts_status_trace( "ts_controller_create: monarch\n" );
 
-	*controller = (TsControllerRef_t) &monarch;
-	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) ( *controller );
-	if( controller_monarch->being_used ) {
+	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) ts_platform_malloc( sizeof( TsControllerMonarch_t ));
+	if( controller_monarch == NULL ) {
 		*controller = NULL;
-		return TsStatusErrorNoResourceAvailable;
+		return TsStatusErrorOutOfMemory;
 	}
+	memset( controller_monarch, 0x00, sizeof( TsControllerMonarch_t ));
+	*controller = (TsControllerRef_t) controller_monarch;
 
 	controller_monarch->modem_started = false;
 	controller_monarch->reg_to_net = MODEM_NO_NET;
@@ -402,43 +430,42 @@ static TsStatus_t ts_create( TsControllerRef_t * controller ) {
 	controller_monarch->unread_tcp = 0;
 
 	TsDriverRef_t driver;
-	if( ts_driver_create( &driver ) != TsStatusOk )
+	if( ts_driver_create( &driver ) != TsStatusOk ) {
+		ts_platform_free( controller_monarch, sizeof( TsControllerMonarch_t ));
+		*controller = NULL;
 		return TsStatusErrorInternalServerError;
+	}
 	( *controller )->_driver = driver;
 
 	mdbg( "Begin initialization of modem\n" );
-	if( !at_init( driver ))
-		return TsStatusErrorInternalServerError;
+	if( !at_init( &controller_monarch->at, driver ))
+		return ts_create_failed( controller, "Failed to initialize the AT interface" );
 
-	at_reg_urcs( NUM_URCS, urc_list );
+	at_reg_urcs( &controller_monarch->at, NUM_URCS, urc_list, controller_monarch );
 
 	mdbg( "Reset the modem hardware\n" );
 	modem_hardware_reset( controller_monarch );
 
-	if( at_wcmd( &core_cmd_list[ EPS_URC_SET ] ) != AT_WCMD_OK )
-		return TsStatusErrorInternalServerError;
+	if( at_wcmd( &controller_monarch->at, &core_cmd_list[ EPS_URC_SET ] ) != AT_WCMD_OK )
+		return ts_create_failed( controller, "Failed to enable the registration URC" );
 
-	if( at_wcmd( &core_cmd_list[ EN_CELL_FUNC ] ) != AT_WCMD_OK )
-		return TsStatusErrorInternalServerError;
+	if( at_wcmd( &controller_monarch->at, &core_cmd_list[ EN_CELL_FUNC ] ) != AT_WCMD_OK )
+		return ts_create_failed( controller, "Failed to enable cellular functionality" );
 
 	mdbg( "Checking for network registration\n" );
 	if( !wait_for_net_reg( controller_monarch, NET_REG_TIMEOUT_MS ))
-		return TsStatusErrorInternalServerError;
+		return ts_create_failed( controller, "Failed to register to the network" );
 
-	if( at_wcmd( &core_cmd_list[ SIM_READY ] ) != AT_WCMD_OK )
-		return TsStatusErrorInternalServerError;
+	if( at_wcmd( &controller_monarch->at, &core_cmd_list[ SIM_READY ] ) != AT_WCMD_OK )
+		return ts_create_failed( controller, "Failed to find the SIM ready" );
 
 	mdbg( "Initializing TCP layer\n" );
-	if( !tcp_init()) {
-		mdbg( "Failed to initialize the TCP layer\n" );
-		return TsStatusErrorInternalServerError;
-	}
+	if( !tcp_init( controller_monarch ))
+		return ts_create_failed( controller, "Failed to initialize the TCP layer" );
 
 	mdbg( "Retrieve modem diagnostics information\n" );
-	if( !initialize_diag_table( controller_monarch )) {
-		mdbg( "Failed to populate diagnostics information\n" );
-		return TsStatusErrorInternalServerError;
-	}
+	if( !initialize_diag_table( controller_monarch ))
+		return ts_create_failed( controller, "Failed to populate diagnostics information" );
 
 	debug_diag( controller_monarch );
 
@@ -455,8 +482,9 @@ static TsStatus_t ts_destroy( TsControllerRef_t controller ) {
 	ts_platform_assert( controller != NULL );
 
 	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) controller;
-	controller_monarch->being_used = false;
+	ts_driver_reader( controller->_driver, NULL, NULL );
 	ts_driver_destroy( controller->_driver );
+	ts_platform_free( controller_monarch, sizeof( TsControllerMonarch_t ));
 	return TsStatusOk;
 }
 
@@ -465,7 +493,8 @@ static TsStatus_t ts_tick( TsControllerRef_t controller, uint32_t budget ) {
 	ts_platform_assert( ts_driver != NULL );
 	ts_platform_assert( controller != NULL );
 
-	at_intfc_service();
+	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) controller;
+	at_intfc_service( &controller_monarch->at );
 
 	return TsStatusOk;
 }
@@ -485,15 +514,20 @@ static TsStatus_t ts_connect( TsControllerRef_t controller, TsAddress_t address
 	if( controller_monarch->tcp_connected )
 		return TsStatusErrorNoResourceAvailable;
 
+	// the socket protocol, 0 for tcp and 1 for udp
+	int protocol = ts_address_is_datagram( address ) ? 1 : 0;
+
 	char cmd[MAX_TCP_HOST_PORT_NAME];
-	at_cmd_desc * tcp_conn = &tcp_cmd_list[ SOCK_DIAL ];
-	snprintf( cmd, sizeof( cmd ), tcp_conn->cmd_fmt, port, host );
-	tcp_conn->cmd = cmd;
-	if( at_wcmd( tcp_conn ) != AT_WCMD_OK )
+	at_cmd_desc tcp_conn = tcp_cmd_list[ SOCK_DIAL ];
+	snprintf( cmd, sizeof( cmd ), tcp_conn.cmd_fmt, protocol, port, host );
+	tcp_conn.cmd = cmd;
+	if( at_wcmd( &controller_monarch->at, &tcp_conn ) != AT_WCMD_OK )
 		return TsStatusErrorInternalServerError;
 
 	controller_monarch->tcp_connected = true;
 	controller_monarch->tcp_peer_close = false;
+	controller_monarch->rx_index = 0;
+	controller_monarch->rx_count = 0;
 
 	mdbg( "TCP connection established\n" );
 
@@ -512,18 +546,72 @@ static TsStatus_t ts_disconnect( TsControllerRef_t controller ) {
 	}
 
 	mdbg( "Closing TCP connection\n" );
-	if( at_wcmd( &tcp_cmd_list[ SOCK_CLOSE ] ) != AT_WCMD_OK ) {
+	if( at_wcmd( &controller_monarch->at, &tcp_cmd_list[ SOCK_CLOSE ] ) != AT_WCMD_OK ) {
 		mdbg( "Failed to close TCP connection\n" );
 		return TsStatusErrorInternalServerError;
 	}
 	controller_monarch->tcp_connected = false;
 	controller_monarch->tcp_peer_close = false;
 	controller_monarch->unread_tcp = 0;
+	controller_monarch->rx_index = 0;
+	controller_monarch->rx_count = 0;
 	return TsStatusOk;
 }
 
-#define MAX_TCP_DATA_LEN            1500
 #define MAX_TCP_RECV_CMD_LEN            32
+
+/*
+ * Completion of a socket receive into the prefetch buffer, see tcp_recv_start.
+ */
+static void tcp_recv_done( at_wcmd_res res, void * pvt_data ) {
+	TsControllerMonarchRef_t modem = pvt_data;
+	modem->rx_pending = false;
+	modem->rx_res = res;
+	modem->rx_index = 0;
+	modem->rx_count = 0;
+	if( res == AT_WCMD_OK && modem->rx_recv.bytes.sz > 0 ) {
+		modem->rx_count = modem->rx_recv.bytes.sz;
+		modem->unread_tcp -= modem->rx_count;
+	}
+}
+
+/*
+ * Queue a socket receive for (up to) all the unread bytes, into the prefetch buffer. The receive
+ * progresses as the AT interface is serviced, i.e., while the previous bytes are being consumed.
+ */
+static void tcp_recv_start( TsControllerMonarchRef_t modem ) {
+	if( modem->rx_pending || modem->rx_index < modem->rx_count || modem->unread_tcp == 0 || !modem->tcp_connected )
+		return;
+
+	size_t size = modem->unread_tcp;
+	if( size > sizeof( modem->rx_buf ))
+		size = sizeof( modem->rx_buf );
+
+	at_cmd_desc tcp_recv = tcp_cmd_list[ SOCK_RECV ];
+	snprintf( modem->rx_cmd, sizeof( modem->rx_cmd ), tcp_recv.cmd_fmt, size );
+	tcp_recv.cmd = modem->rx_cmd;
+	modem->rx_recv.modem = modem;
+	modem->rx_recv.bytes.sz = size;
+	modem->rx_recv.bytes.data = (char *) modem->rx_buf;
+	tcp_recv.resp[ 0 ].pvt_data = &modem->rx_recv;
+	modem->rx_pending = at_submit( &modem->at, &tcp_recv, tcp_recv_done, modem );
+}
+
+/*
+ * Service the AT interface until the socket receive in progress completes, or the budget is spent.
+ */
+static bool tcp_recv_wait( TsControllerMonarchRef_t modem, uint32_t budget ) {
+	uint64_t deadline = ts_platform_time() + budget;
+	while( true ) {
+		at_intfc_service( &modem->at );
+		if( !modem->rx_pending )
+			return true;
+		if( ts_platform_time() >= deadline )
+			return false;
+		at_wait_rx( &modem->at, IDLE_TIME_MS );
+	}
+}
+
 static TsStatus_t ts_read( TsControllerRef_t controller, const uint8_t * buffer, size_t * buffer_size, uint32_t budget ) {
 	ts_status_trace( "ts_controller_read\n" );
 	ts_platform_assert( ts_driver != NULL );
@@ -533,43 +621,81 @@ static TsStatus_t ts_read( TsControllerRef_t controller, const uint8_t * buffer,
 
 	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) controller;
 
+	// a receive in progress is completed first (within the budget), its bytes come before any other
+	if( controller_monarch->rx_pending ) {
+		if( !tcp_recv_wait( controller_monarch, budget )) {
+			*buffer_size = 0;
+			return TsStatusOkReadPending;
+		}
+		if( controller_monarch->rx_res != AT_WCMD_OK || controller_monarch->rx_count == 0 ) {
+			mdbg( "TCP read error\n" );
+			*buffer_size = 0;
+			return TsStatusErrorInternalServerError;
+		}
+	}
+
+	// serve prefetched bytes, and have the modem send the following ones meanwhile
+	if( controller_monarch->rx_index < controller_monarch->rx_count ) {
+		size_t size = controller_monarch->rx_count - controller_monarch->rx_index;
+		if( *buffer_size > size )
+			*buffer_size = size;
+		memcpy( (uint8_t *) buffer, controller_monarch->rx_buf + controller_monarch->rx_index, *buffer_size );
+		controller_monarch->rx_index += *buffer_size;
+		tcp_recv_start( controller_monarch );
+		return TsStatusOk;
+	}
+
+	// the receive URC may be waiting in the AT interface, i.e., received since it was last serviced
+	if( controller_monarch->unread_tcp == 0 )
+		at_intfc_service( &controller_monarch->at );
+
 	if( controller_monarch->unread_tcp == 0 ) {
+		*buffer_size = 0;
 		if( controller_monarch->tcp_connected && controller_monarch->reg_to_net )
 			return TsStatusOkReadPending;
 		mdbg( "Attempting to read when not connected to TCP\n" );
 		return TsStatusErrorConnectionReset;
 	}
 
-	if( *buffer_size > MAX_TCP_DATA_LEN )
-		*buffer_size = MAX_TCP_DATA_LEN;
-
-	if( *buffer_size > AT_BUF_SZ)
-		*buffer_size = AT_BUF_SZ;
-
-	if( *buffer_size > controller_monarch->unread_tcp )
-		*buffer_size = controller_monarch->unread_tcp;
+	// size the receive from the unread count rather than the request, i.e., small reads (e.g., a
+	// tls record header) are served from one prefetch, and large reads are streamed into the buffer
+	size_t size = controller_monarch->unread_tcp;
+	if( size > MAX_TCP_DATA_LEN )
+		size = MAX_TCP_DATA_LEN;
+	if( *buffer_size < size ) {
+		tcp_recv_start( controller_monarch );
+		if( controller_monarch->rx_pending )
+			return ts_read( controller, buffer, buffer_size, budget );
+		// the prefetch couldn't be queued, read what's asked for
+		size = *buffer_size;
+	}
+	*buffer_size = size;
 
 	char cmd[MAX_TCP_RECV_CMD_LEN];
-	at_cmd_desc * tcp_recv = &tcp_cmd_list[ SOCK_RECV ];
-	snprintf( cmd, sizeof( cmd ), tcp_recv->cmd_fmt, *buffer_size );
-	tcp_recv->cmd = cmd;
-	array_t bytes = { *buffer_size, (char *) buffer };
-	tcp_recv->resp[ 0 ].pvt_data = &bytes;
+	at_cmd_desc tcp_recv = tcp_cmd_list[ SOCK_RECV ];
+	snprintf( cmd, sizeof( cmd ), tcp_recv.cmd_fmt, *buffer_size );
+	tcp_recv.cmd = cmd;
+	tcp_recv_t recv = { controller_monarch, { *buffer_size, (char *) buffer } };
+	tcp_recv.resp[ 0 ].pvt_data = &recv;
 
-	if( at_wcmd( tcp_recv ) != AT_WCMD_OK ) {
+	if( at_wcmd( &controller_monarch->at, &tcp_recv ) != AT_WCMD_OK ) {
 		mdbg( "TCP read error\n" );
+		*buffer_size = 0;
 		return TsStatusErrorInternalServerError;
 	}
 
-	if( bytes.sz == 0 ) {
+	if( recv.bytes.sz == 0 ) {
 		mdbg( "TCP read error\n" );
+		*buffer_size = 0;
 		return TsStatusErrorInternalServerError;
 	}
 
+	*buffer_size = recv.bytes.sz;
+	controller_monarch->unread_tcp -= recv.bytes.sz;
+	tcp_recv_start( controller_monarch );
 	return TsStatusOk;
 }
 
-#define MAX_TCP_DATA_LEN            1500
 #define MAX_TCP_SEND_CMD_LEN            32
 static TsStatus_t ts_write( TsControllerRef_t controller, const uint8_t * buffer, size_t * buffer_size, uint32_t budget ) {
 	ts_status_trace( "ts_controller_write\n" );
@@ -592,18 +718,18 @@ static TsStatus_t ts_write( TsControllerRef_t controller, const uint8_t * buffer
 		*buffer_size = MAX_TCP_DATA_LEN;
 
 	char cmd[MAX_TCP_SEND_CMD_LEN];
-	at_cmd_desc * tcp_write = &tcp_cmd_list[ SOCK_SEND_CMD ];
-	snprintf( cmd, sizeof( cmd ), tcp_write->cmd_fmt, *buffer_size );
-	tcp_write->cmd = cmd;
-	if( at_wcmd( tcp_write ) != AT_WCMD_OK ) {
+	at_cmd_desc tcp_write = tcp_cmd_list[ SOCK_SEND_CMD ];
+	snprintf( cmd, sizeof( cmd ), tcp_write.cmd_fmt, *buffer_size );
+	tcp_write.cmd = cmd;
+	if( at_wcmd( &controller_monarch->at, &tcp_write ) != AT_WCMD_OK ) {
 		mdbg( "TCP write failed\n" );
 		return TsStatusErrorInternalServerError;
 	}
 
-	tcp_write = &tcp_cmd_list[ SOCK_SEND_DATA ];
-	tcp_write->cmd = (const char *) buffer;
-	tcp_write->cmd_len = *buffer_size;
-	if( at_wcmd( tcp_write ) != AT_WCMD_OK ) {
+	tcp_write = tcp_cmd_list[ SOCK_SEND_DATA ];
+	tcp_write.cmd = (const char *) buffer;
+	tcp_write.cmd_len = *buffer_size;
+	if( at_wcmd( &controller_monarch->at, &tcp_write ) != AT_WCMD_OK ) {
 		mdbg( "TCP write failed\n" );
 		return TsStatusErrorInternalServerError;
 	}
@@ -611,6 +737,37 @@ static TsStatus_t ts_write( TsControllerRef_t controller, const uint8_t * buffer
 	return TsStatusOk;
 }
 
+static TsStatus_t ts_wait( TsControllerRef_t controller, uint32_t budget ) {
+	ts_status_trace( "ts_controller_wait\n" );
+	ts_platform_assert( ts_driver != NULL );
+	ts_platform_assert( controller != NULL );
+
+	TsControllerMonarchRef_t controller_monarch = (TsControllerMonarchRef_t) controller;
+	uint64_t deadline = ts_platform_time() + budget;
+	bool service = true;
+	while( true ) {
+		// only scan for urcs (e.g., received bytes, peer close) when the driver delivered something,
+		// or to advance a queued command (e.g., a receive ahead of the next read)
+		if( at_rx_ready( &controller_monarch->at ) || service || at_busy( &controller_monarch->at ))
+			at_intfc_service( &controller_monarch->at );
+		service = false;
+
+		if( controller_monarch->unread_tcp > 0 || controller_monarch->rx_index < controller_monarch->rx_count ||
+			!controller_monarch->tcp_connected )
+			return TsStatusOk;
+
+		uint64_t now = ts_platform_time();
+		if( now >= deadline )
+			return TsStatusOkReadPending;
+
+		// sleep in short slices, the reader callback flags any arrival in between
+		uint64_t remaining = deadline - now;
+		if( remaining > MSEC2USEC( IDLE_TIME_MS ))
+			remaining = MSEC2USEC( IDLE_TIME_MS );
+		ts_platform_sleep( (uint32_t) remaining );
+	}
+}
+
 static TsStatus_t ts_get_id( TsControllerRef_t controller, char * id ) {
 	TsControllerMonarchRef_t modem = (TsControllerMonarchRef_t) controller;
 	strncpy( id, modem->imei, SIZEOF_IMEI );
@@ -1,6 +1,7 @@
 // Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
 #include "ts_platform.h"
 #include "ts_controller.h"
+#include "ts_address.h"
 
 static TsStatus_t ts_create( TsControllerRef_t * );
 static TsStatus_t ts_destroy( TsControllerRef_t );
@@ -85,6 +86,11 @@ static TsStatus_t ts_connect( TsControllerRef_t controller, TsAddress_t address
 	ts_platform_assert( ts_driver != NULL );
 	ts_platform_assert( controller != NULL );
 
+	// the socket drivers only dial tcp, i.e., datagrams are carried by the monarch controller
+	if( ts_address_is_datagram( address )) {
+		ts_status_alarm( "ts_controller_connect: datagram addresses are not supported, %s\n", address );
+		return TsStatusErrorNotImplemented;
+	}
 	return ts_driver_connect( controller->_driver, address );
 }
 
@@ -1,22 +1,49 @@
 // Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
-#if defined( TS_SECURITY_MBED )
+#if defined( TS_SECURITY_MBED ) || defined( TS_SECURITY_MBED_PSK ) || defined( TS_SECURITY_MBED_DTLS )
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "ts_platform.h"
 #include "ts_profile.h"
 #include "ts_security.h"
 #include "ts_controller.h"
+#include "ts_mutex.h"
+#if defined( TS_SECURITY_MBED_SESSION_FILE )
+#include "ts_file.h"
+#endif
 
 #include "mbedtls/config.h"
 #include "mbedtls/debug.h"
 #include "mbedtls/net.h"
 //#include "mbedtls/net_sockets.h"
 #include "mbedtls/ssl.h"
+#include "mbedtls/ssl_internal.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
 #include "mbedtls/certs.h"
+#include "mbedtls/platform.h"
+
+// session resumption, define TS_SECURITY_MBED_SESSION_FILE as a file name to persist the
+// session via ts_file (i.e., to resume it after a reboot). Tickets beyond the maximum aren't saved.
+#define TS_SECURITY_MBED_MAX_TICKET_SIZE 1024
+
+// pre-shared keys, the identity is sent in the clear to select the key on the server
+#define TS_SECURITY_MBED_MAX_PSK_IDENTITY_SIZE 128
+
+// dtls, the handshake retransmission timeout doubles from min to max (milliseconds), i.e.,
+// longer than the mbedtls default to allow for cellular round trips
+#define TS_SECURITY_MBED_DTLS_MIN_TIMEOUT 2000
+#define TS_SECURITY_MBED_DTLS_MAX_TIMEOUT 16000
+#define TS_SECURITY_MBED_DTLS_BADMAC_LIMIT 8
+
+// credential cache, certificates and keys are parsed once and shared by all security objects
+// (e.g., in gateway mode), those no longer referenced are kept until their entry is needed
+#define TS_SECURITY_MBED_MAX_CREDENTIALS 8
+
+// memory accounting, each block is prefixed by its size (padded to keep the block aligned)
+#define TS_SECURITY_MBED_MEMORY_HEADER ( 2 * sizeof( uint64_t ))
 
 /* TODO - setup config
 #if !defined(MBEDTLS_CONFIG_FILE)
@@ -51,13 +78,26 @@ static TsStatus_t ts_get_spec_id( TsSecurityRef_t, const uint8_t *, size_t );
 static TsStatus_t ts_get_spec_budget( TsSecurityRef_t, uint32_t* );
 
 static TsStatus_t ts_connect(TsSecurityRef_t, TsAddress_t);
+static TsStatus_t ts_connect_start(TsSecurityRef_t, TsAddress_t);
+static TsStatus_t ts_handshake(TsSecurityRef_t, uint32_t);
 static TsStatus_t ts_disconnect(TsSecurityRef_t);
 static TsStatus_t ts_read(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
 static TsStatus_t ts_write(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
+static TsStatus_t ts_set_resumption(TsSecurityRef_t, bool);
+static TsStatus_t ts_get_session_stats(TsSecurityRef_t, TsSecuritySessionStats_t *);
+static TsStatus_t ts_get_memory_stats(TsSecurityRef_t, TsSecurityMemoryStats_t *);
+static TsStatus_t ts_set_psk(TsSecurityRef_t, const uint8_t *, size_t);
+static TsStatus_t ts_set_psk_identity(TsSecurityRef_t, const uint8_t *, size_t);
+static TsStatus_t ts_get_credential_stats(TsSecurityRef_t, TsSecurityCredentialStats_t *);
+static TsStatus_t ts_create_psk(TsSecurityRef_t *);
+static TsStatus_t ts_create_dtls(TsSecurityRef_t *);
+static TsStatus_t ts_create_transport(TsSecurityRef_t *, int);
 
 static int mbedtls_tcp_send(void *, const unsigned char *, size_t);
 static int mbedtls_tcp_recv(void *, unsigned char *, size_t);
 static void mbedtls_debug(void *, int, const char *, int, const char *);
+static void mbedtls_timer_set(void *, uint32_t, uint32_t);
+static int mbedtls_timer_get(void *);
 // TODO - should replace with device id instead (e.g., mac or imei)
 const char * mbedtls_secret = "my-little-secret";
 
@@ -78,11 +118,119 @@ TsSecurityVtable_t ts_security_mbedtls = {
 	.get_spec_budget = ts_get_spec_budget,
 
 	.connect = ts_connect,
+	.connect_start = ts_connect_start,
+	.handshake = ts_handshake,
+	.disconnect = ts_disconnect,
+	.read = ts_read,
+	.write = ts_write,
+	.set_resumption = ts_set_resumption,
+	.get_session_stats = ts_get_session_stats,
+	.get_memory_stats = ts_get_memory_stats,
+	.set_psk = ts_set_psk,
+	.set_psk_identity = ts_set_psk_identity,
+	.get_credential_stats = ts_get_credential_stats,
+};
+
+// the pre-shared key variant, i.e., no certificates, no public-key operations and a smaller handshake
+TsSecurityVtable_t ts_security_mbedtls_psk = {
+	.create = ts_create_psk,
+	.destroy = ts_destroy,
+	.tick = ts_tick,
+
+	.set_server_cert_hostname = ts_set_server_cert_hostname,
+	.set_server_cert = ts_set_server_cert,
+	.set_client_cert = ts_set_client_cert,
+	.set_client_key = ts_set_client_key,
+
+	.get_spec_mtu = ts_get_spec_mtu,
+	.get_spec_id = ts_get_spec_id,
+	.get_spec_budget = ts_get_spec_budget,
+
+	.connect = ts_connect,
+	.connect_start = ts_connect_start,
+	.handshake = ts_handshake,
+	.disconnect = ts_disconnect,
+	.read = ts_read,
+	.write = ts_write,
+	.set_resumption = ts_set_resumption,
+	.get_session_stats = ts_get_session_stats,
+	.get_memory_stats = ts_get_memory_stats,
+	.set_psk = ts_set_psk,
+	.set_psk_identity = ts_set_psk_identity,
+	.get_credential_stats = ts_get_credential_stats,
+};
+
+// the datagram variant, i.e., dtls over udp, the connection address is given the "udp://" scheme
+TsSecurityVtable_t ts_security_mbedtls_dtls = {
+	.create = ts_create_dtls,
+	.destroy = ts_destroy,
+	.tick = ts_tick,
+
+	.set_server_cert_hostname = ts_set_server_cert_hostname,
+	.set_server_cert = ts_set_server_cert,
+	.set_client_cert = ts_set_client_cert,
+	.set_client_key = ts_set_client_key,
+
+	.get_spec_mtu = ts_get_spec_mtu,
+	.get_spec_id = ts_get_spec_id,
+	.get_spec_budget = ts_get_spec_budget,
+
+	.connect = ts_connect,
+	.connect_start = ts_connect_start,
+	.handshake = ts_handshake,
 	.disconnect = ts_disconnect,
 	.read = ts_read,
 	.write = ts_write,
+	.set_resumption = ts_set_resumption,
+	.get_session_stats = ts_get_session_stats,
+	.get_memory_stats = ts_get_memory_stats,
+	.set_psk = ts_set_psk,
+	.set_psk_identity = ts_set_psk_identity,
+	.get_credential_stats = ts_get_credential_stats,
+};
+
+// the cipher suites offered by the pre-shared key variant, ccm first (i.e., the smallest record overhead)
+static const int mbedtls_psk_ciphersuites[] = {
+	MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,
+	MBEDTLS_TLS_PSK_WITH_AES_128_CCM,
+	MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+	0
+};
+
+// the cipher suites offered by the certificate variants, i.e., never the pre-shared key suites, which are
+// compiled in (MBEDTLS_KEY_EXCHANGE_PSK_ENABLED) for the pre-shared key variant alone
+static const int mbedtls_certificate_ciphersuites[] = {
+	MBEDTLS_TLS_DHE_RSA_WITH_AES_128_GCM_SHA256,
+	0
 };
 
+// the memory used by mbedtls, shared by all security objects
+static TsSecurityMemoryStats_t mbedtls_memory = { 0 };
+
+// a cached credential, i.e., the der form and its parsed form
+typedef enum {
+	TsSecurityEmbedCredentialNone = 0,
+	TsSecurityEmbedCredentialServerCert,
+	TsSecurityEmbedCredentialClientCert,
+	TsSecurityEmbedCredentialClientKey,
+} TsSecurityEmbedCredentialType_t;
+
+typedef struct TsSecurityEmbedCredential {
+	TsSecurityEmbedCredentialType_t _type;		// none when unused
+	uint32_t _references;						// the security objects (or chained certificates) using it
+	uint32_t _heap;								// the bytes held, i.e., the der copy and the parsed form
+	struct TsSecurityEmbedCredential * _parent;	// the server certificates preceding this one in a chain (if any)
+	uint8_t * _der;
+	size_t _der_size;
+	mbedtls_x509_crt _crt;						// the certificate (chain), see _type
+	mbedtls_pk_context _pk;						// or else the key
+} TsSecurityEmbedCredential_t;
+
+// the credential cache, shared by all security objects, and guarded by the platform mutex (if any)
+static TsSecurityEmbedCredential_t mbedtls_credentials[ TS_SECURITY_MBED_MAX_CREDENTIALS ];
+static TsSecurityCredentialStats_t mbedtls_credential_stats = { 0 };
+static TsMutexRef_t mbedtls_credential_mutex = NULL;
+
 typedef struct TsSecurityEmbed *TsSecurityEmbedRef_t;
 typedef struct TsSecurityEmbed {
 
@@ -96,27 +244,494 @@ typedef struct TsSecurityEmbed {
 	mbedtls_ctr_drbg_context    _ctr_drbg;
 	mbedtls_ssl_context         _ssl;
 	mbedtls_ssl_config          _ssl_config;
-	mbedtls_x509_crt            _cacert;
-	mbedtls_x509_crt            _clcert;
-	mbedtls_pk_context          _clkey;
-	bool                        _clcert_is_set;
-	bool                        _clkey_is_set;
+	TsSecurityEmbedCredential_t * _cacert;		// shared (see ts_credential_get), NULL when not set
+	TsSecurityEmbedCredential_t * _clcert;
+	TsSecurityEmbedCredential_t * _clkey;
 	char *                      _cacert_hostname;
+	uint64_t                    _handshake_start;
+	uint32_t                    _handshake_bytes;	// sent and received since connect_start
+	uint64_t                    _io_deadline;		// the end of the current read, write or handshake budget
+
+	// datagram (dtls) attributes, i.e., each read and write is one datagram
+	bool                        _datagram;
+	uint64_t                    _timer_intermediate;	// the retransmission timer, zero when cancelled
+	uint64_t                    _timer_final;
+
+	// session resumption, the session of the last handshake is offered on the next connect
+	bool                        _resumption;
+	bool                        _session_is_set;
+	mbedtls_ssl_session         _session;
+	TsSecuritySessionStats_t    _session_stats;
+
+	// pre-shared key, configured once both the key and its identity are set
+	uint8_t                     _psk[MBEDTLS_PSK_MAX_LEN];
+	size_t                      _psk_size;
+	uint8_t                     _psk_identity[TS_SECURITY_MBED_MAX_PSK_IDENTITY_SIZE];
+	size_t                      _psk_identity_size;
 
 	// profile attributes
 	TsProfileRef_t              _profile;
 
 } TsSecurityEmbed_t;
 
+#if defined( TS_SECURITY_MBED_SESSION_FILE )
+typedef struct TsSecurityEmbedSessionRecord {
+	int32_t ciphersuite;
+	int32_t compression;
+	uint32_t id_len;
+	uint8_t id[32];
+	uint8_t master[48];
+	uint32_t verify_result;
+	uint32_t ticket_len;
+	uint32_t ticket_lifetime;
+	uint32_t encrypt_then_mac;
+	uint32_t mfl_code;
+} TsSecurityEmbedSessionRecord_t;
+#endif
+
+/**
+ * Save the current session to, or load it from, TS_SECURITY_MBED_SESSION_FILE (if defined).
+ * The record is followed by the session ticket (if any).
+ */
+static void ts_session_persist(TsSecurityEmbedRef_t mbed, bool save) {
+
+#if defined( TS_SECURITY_MBED_SESSION_FILE )
+	TsSecurityEmbedSessionRecord_t record;
+	mbedtls_ssl_session *session = &(mbed->_session);
+	uint8_t *ticket = NULL;
+	size_t ticket_len = 0;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	ticket = session->ticket;
+	ticket_len = session->ticket_len;
+#endif
+	if (save && (!(mbed->_session_is_set) || ticket_len > TS_SECURITY_MBED_MAX_TICKET_SIZE)) {
+		return;
+	}
+	ts_file_handle handle;
+	if (ts_file_open(&handle, TS_SECURITY_MBED_SESSION_FILE, save ? TS_FILE_OPEN_FOR_WRITE : TS_FILE_OPEN_FOR_READ) != TsStatusOk) {
+		ts_status_debug("ts_session_persist: cannot open, '%s'\n", TS_SECURITY_MBED_SESSION_FILE);
+		return;
+	}
+	if (save) {
+		memset(&record, 0x00, sizeof(record));
+		record.ciphersuite = session->ciphersuite;
+		record.compression = session->compression;
+		record.id_len = (uint32_t)session->id_len;
+		memcpy(record.id, session->id, sizeof(record.id));
+		memcpy(record.master, session->master, sizeof(record.master));
+		record.verify_result = session->verify_result;
+		record.ticket_len = (uint32_t)ticket_len;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		record.ticket_lifetime = session->ticket_lifetime;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+		record.encrypt_then_mac = (uint32_t)session->encrypt_then_mac;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+		record.mfl_code = session->mfl_code;
+#endif
+		ts_file_write(&handle, &record, sizeof(record));
+		if (ticket_len > 0) {
+			ts_file_write(&handle, ticket, (uint32_t)ticket_len);
+		}
+	} else {
+		uint32_t size = 0;
+		if (ts_file_read(&handle, &record, sizeof(record), &size) == TsStatusOk && size == sizeof(record)
+			&& record.id_len <= sizeof(record.id) && record.ticket_len <= TS_SECURITY_MBED_MAX_TICKET_SIZE) {
+			if (record.ticket_len > 0) {
+				ticket = (uint8_t *)mbedtls_calloc(1, record.ticket_len);
+				if (ticket == NULL || ts_file_read(&handle, ticket, record.ticket_len, &size) != TsStatusOk || size != record.ticket_len) {
+					mbedtls_free(ticket);
+					ts_file_close(&handle);
+					return;
+				}
+			}
+			mbedtls_ssl_session_free(session);
+			session->ciphersuite = record.ciphersuite;
+			session->compression = record.compression;
+			session->id_len = record.id_len;
+			memcpy(session->id, record.id, sizeof(record.id));
+			memcpy(session->master, record.master, sizeof(record.master));
+			session->verify_result = record.verify_result;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+			session->ticket = (record.ticket_len > 0) ? ticket : NULL;
+			session->ticket_len = record.ticket_len;
+			session->ticket_lifetime = record.ticket_lifetime;
+#else
+			mbedtls_free(ticket);
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+			session->encrypt_then_mac = (int)record.encrypt_then_mac;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+			session->mfl_code = (unsigned char)record.mfl_code;
+#endif
+			mbed->_session_is_set = true;
+		}
+	}
+	ts_file_close(&handle);
+#endif
+}
+
+/**
+ * Record a completed handshake, i.e., save its session for the next connect, and account for its cost.
+ * An abbreviated handshake keeps the master secret of the offered session.
+ */
+static void ts_session_complete(TsSecurityEmbedRef_t mbed) {
+
+	uint32_t time = (uint32_t)(ts_platform_time() - mbed->_handshake_start);
+	bool resumed = false;
+	if (mbed->_resumption) {
+		mbedtls_ssl_session session;
+		mbedtls_ssl_session_init(&session);
+		if (mbedtls_ssl_get_session(&(mbed->_ssl), &session) == 0) {
+			resumed = mbed->_session_is_set && memcmp(session.master, mbed->_session.master, sizeof(session.master)) == 0;
+			mbedtls_ssl_session_free(&(mbed->_session));
+			memcpy(&(mbed->_session), &session, sizeof(mbedtls_ssl_session));
+			mbed->_session_is_set = true;
+			if (!resumed) {
+				ts_session_persist(mbed, true);
+			}
+		} else {
+			mbedtls_ssl_session_free(&session);
+		}
+	}
+
+	TsSecuritySessionStats_t *stats = &(mbed->_session_stats);
+	stats->resumed = resumed;
+	stats->bytes = mbed->_handshake_bytes;
+	stats->time = time;
+	if (resumed) {
+		stats->resumptions = stats->resumptions + 1;
+		stats->resumption_bytes = stats->resumption_bytes + mbed->_handshake_bytes;
+		stats->resumption_time = stats->resumption_time + time;
+	} else {
+		stats->handshakes = stats->handshakes + 1;
+		stats->handshake_bytes = stats->handshake_bytes + mbed->_handshake_bytes;
+		stats->handshake_time = stats->handshake_time + time;
+	}
+	ts_status_debug("ts_security_handshake: %s handshake, %u bytes in %u usec\n", resumed ? "abbreviated" : "full", mbed->_handshake_bytes, time);
+
+	mbedtls_memory.handshake_peak = mbedtls_memory.peak;
+	mbedtls_memory.steady = mbedtls_memory.current;
+	ts_status_debug("ts_security_handshake: memory, %u bytes at peak, %u bytes steady\n", mbedtls_memory.handshake_peak, mbedtls_memory.steady);
+}
+
+/**
+ * Return the maximum fragment length code for the given mtu, i.e., the largest fragment that fits
+ * both the mtu and the (compile-time) record buffers. Asking the server for it keeps its records
+ * from overflowing the buffers when MBEDTLS_SSL_MAX_CONTENT_LEN is reduced (as it is).
+ */
+static unsigned char ts_fragment_code(uint32_t mtu, uint32_t *fragment) {
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+	if (mtu >= 4096 && MBEDTLS_SSL_MAX_CONTENT_LEN >= 4096) {
+		*fragment = 4096;
+		return MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+	} else if (mtu >= 2048 && MBEDTLS_SSL_MAX_CONTENT_LEN >= 2048) {
+		*fragment = 2048;
+		return MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+	} else if (mtu >= 1024 && MBEDTLS_SSL_MAX_CONTENT_LEN >= 1024) {
+		*fragment = 1024;
+		return MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+	}
+	*fragment = 512;
+	return MBEDTLS_SSL_MAX_FRAG_LEN_512;
+#else
+	*fragment = MBEDTLS_SSL_MAX_CONTENT_LEN;
+	return 0;
+#endif
+}
+
+static void * mbedtls_counting_calloc(size_t count, size_t size) {
+
+	if (size != 0 && count > (SIZE_MAX - TS_SECURITY_MBED_MEMORY_HEADER) / size) {
+		return NULL;
+	}
+	size_t block_size = count * size;
+	uint8_t *block = (uint8_t *)ts_platform_malloc(TS_SECURITY_MBED_MEMORY_HEADER + block_size);
+	if (block == NULL) {
+		return NULL;
+	}
+	memset(block, 0x00, TS_SECURITY_MBED_MEMORY_HEADER + block_size);
+	memcpy(block, &block_size, sizeof(size_t));
+	mbedtls_memory.current = mbedtls_memory.current + (uint32_t)block_size;
+	if (mbedtls_memory.current > mbedtls_memory.peak) {
+		mbedtls_memory.peak = mbedtls_memory.current;
+	}
+	return block + TS_SECURITY_MBED_MEMORY_HEADER;
+}
+
+static void mbedtls_counting_free(void *pointer) {
+
+	if (pointer == NULL) {
+		return;
+	}
+	uint8_t *block = (uint8_t *)pointer - TS_SECURITY_MBED_MEMORY_HEADER;
+	size_t block_size;
+	memcpy(&block_size, block, sizeof(size_t));
+	mbedtls_memory.current = mbedtls_memory.current - (uint32_t)block_size;
+	ts_platform_free(block, TS_SECURITY_MBED_MEMORY_HEADER + block_size);
+}
+
+/**
+ * Install the accounting allocator, once for the process and before the first mbedtls allocation,
+ * i.e., every block freed by mbedtls_counting_free must have been allocated by mbedtls_counting_calloc.
+ */
+static void mbedtls_counting_init() {
+
+	static bool installed = false;
+	if (!installed) {
+		mbedtls_memory.record_buffers = 2 * MBEDTLS_SSL_BUFFER_LEN;
+		mbedtls_platform_set_calloc_free(mbedtls_counting_calloc, mbedtls_counting_free);
+		installed = true;
+	}
+}
+
+/**
+ * Return the time left (in microseconds) of the current read, write or handshake budget.
+ */
+static uint32_t ts_io_remaining(TsSecurityEmbedRef_t mbed) {
+
+	uint64_t now = ts_platform_time();
+	return (now >= mbed->_io_deadline) ? 0 : (uint32_t)(mbed->_io_deadline - now);
+}
+
+/**
+ * Sleep until the controller has received bytes, rather than spinning on read. The wait ends
+ * with the current budget, or earlier when the dtls retransmission timer is due. Returns true
+ * when the next read is worth trying, i.e., false when there's no wait (or nothing arrived).
+ */
+static bool ts_io_wait(TsSecurityRef_t security) {
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	if (ts_controller_wait == NULL) {
+		return false;
+	}
+	uint32_t budget = ts_io_remaining(mbed);
+	if (mbed->_timer_final != 0) {
+		uint64_t now = ts_platform_time();
+		uint64_t timer = (now >= mbed->_timer_final) ? 0 : mbed->_timer_final - now;
+		if (timer < budget) {
+			budget = (uint32_t) timer;
+		}
+	}
+	if (budget == 0) {
+		return false;
+	}
+	return ts_controller_wait(security->_controller, budget) == TsStatusOk;
+}
+
+/**
+ * Forget the saved session, e.g., a handshake offering it failed.
+ */
+static void ts_session_forget(TsSecurityEmbedRef_t mbed) {
+
+	if (mbed->_session_is_set) {
+		mbedtls_ssl_session_free(&(mbed->_session));
+		mbed->_session_is_set = false;
+	}
+}
+
+/**
+ * Create the credential cache mutex, once for the process, i.e., the cache is unguarded
+ * when the platform provides no mutex (single threaded).
+ */
+static TsStatus_t ts_credential_init() {
+
+	static bool initialized = false;
+	if (!initialized) {
+		if (ts_mutex != NULL) {
+			TsStatus_t status = ts_mutex_create(&mbedtls_credential_mutex);
+			if (status != TsStatusOk) {
+				ts_status_alarm("ts_credential_init: failed to create mutex, %s\n", ts_status_string(status));
+				return status;
+			}
+		}
+		initialized = true;
+	}
+	return TsStatusOk;
+}
+
+static void ts_credential_lock() {
+
+	if (mbedtls_credential_mutex != NULL) {
+		ts_mutex_lock(mbedtls_credential_mutex);
+	}
+}
+
+static void ts_credential_unlock() {
+
+	if (mbedtls_credential_mutex != NULL) {
+		ts_mutex_unlock(mbedtls_credential_mutex);
+	}
+}
+
+/**
+ * Free the given (unreferenced) cache entry, releasing its parent, the caller holds the lock.
+ */
+static void ts_credential_free(TsSecurityEmbedCredential_t *credential) {
+
+	if (credential->_parent != NULL) {
+		credential->_parent->_references = credential->_parent->_references - 1;
+	}
+	if (credential->_type == TsSecurityEmbedCredentialClientKey) {
+		mbedtls_pk_free(&(credential->_pk));
+	} else {
+		mbedtls_x509_crt_free(&(credential->_crt));
+	}
+	ts_platform_free(credential->_der, credential->_der_size);
+
+	mbedtls_credential_stats.credentials = mbedtls_credential_stats.credentials - 1;
+	mbedtls_credential_stats.heap = mbedtls_credential_stats.heap - credential->_heap;
+	memset(credential, 0x00, sizeof(TsSecurityEmbedCredential_t));
+}
+
+/**
+ * Release a credential returned by ts_credential_get. It stays cached (i.e., a later get is a hit)
+ * until its entry is needed for another credential.
+ */
+static void ts_credential_release(TsSecurityEmbedCredential_t *credential) {
+
+	if (credential == NULL) {
+		return;
+	}
+	ts_credential_lock();
+	ts_platform_assert(credential->_references > 0);
+	credential->_references = credential->_references - 1;
+	ts_credential_unlock();
+}
+
+/**
+ * Parse the given credential (and the chain preceding it, if any) into the cache entry.
+ */
+static int ts_credential_parse(TsSecurityEmbedCredential_t *credential, TsSecurityEmbedCredential_t *chain) {
+
+	if (chain->_parent != NULL) {
+		int error = ts_credential_parse(credential, chain->_parent);
+		if (error != 0) {
+			return error;
+		}
+	}
+	return mbedtls_x509_crt_parse_der(&(credential->_crt), chain->_der, chain->_der_size);
+}
+
+/**
+ * Return the cached credential of the given type and der form, parsing it when it wasn't
+ * set before (by any security object). A server certificate is cached with the certificates
+ * set before it (its parent), i.e., as the whole chain. The caller holds a reference to the
+ * credential returned, see ts_credential_release.
+ */
+static TsStatus_t ts_credential_get(TsSecurityEmbedCredentialType_t type, TsSecurityEmbedCredential_t *parent,
+	const uint8_t *der, size_t der_size, TsSecurityEmbedCredential_t **credential) {
+
+	ts_platform_assert(der != NULL);
+	ts_platform_assert(credential != NULL);
+
+	ts_credential_lock();
+
+	// find the credential parsed before, or else an unused entry, or else one no longer referenced
+	TsSecurityEmbedCredential_t *unused = NULL;
+	TsSecurityEmbedCredential_t *evictable = NULL;
+	for (int index = 0; index < TS_SECURITY_MBED_MAX_CREDENTIALS; index++) {
+		TsSecurityEmbedCredential_t *candidate = &(mbedtls_credentials[index]);
+		if (candidate->_type == type && candidate->_parent == parent && candidate->_der_size == der_size
+			&& memcmp(candidate->_der, der, der_size) == 0) {
+			candidate->_references = candidate->_references + 1;
+			mbedtls_credential_stats.hits = mbedtls_credential_stats.hits + 1;
+			*credential = candidate;
+			ts_credential_unlock();
+			return TsStatusOk;
+		}
+		if (candidate->_type == TsSecurityEmbedCredentialNone && unused == NULL) {
+			unused = candidate;
+		}
+		if (candidate->_type != TsSecurityEmbedCredentialNone && candidate->_references == 0 && evictable == NULL) {
+			evictable = candidate;
+		}
+	}
+	if (unused == NULL && evictable != NULL) {
+		ts_credential_free(evictable);
+		mbedtls_credential_stats.evictions = mbedtls_credential_stats.evictions + 1;
+		unused = evictable;
+	}
+	if (unused == NULL) {
+		ts_status_debug("ts_credential_get: failed, no more credentials available\n");
+		ts_credential_unlock();
+		return TsStatusErrorNoResourceAvailable;
+	}
+
+	// keep the der form, the parsed form refers to it
+	uint64_t timestamp = ts_platform_time();
+	uint32_t current = mbedtls_memory.current;
+	unused->_der = (uint8_t *) ts_platform_malloc(der_size);
+	if (unused->_der == NULL) {
+		ts_status_debug("ts_credential_get: failed, out of memory\n");
+		ts_credential_unlock();
+		return TsStatusErrorOutOfMemory;
+	}
+	memcpy(unused->_der, der, der_size);
+	unused->_der_size = der_size;
+	unused->_parent = parent;
+
+	int error;
+	if (type == TsSecurityEmbedCredentialClientKey) {
+		mbedtls_pk_init(&(unused->_pk));
+		error = mbedtls_pk_parse_key(&(unused->_pk), unused->_der, der_size, NULL, 0);
+		if (error != 0) {
+			mbedtls_pk_free(&(unused->_pk));
+		}
+	} else {
+		mbedtls_x509_crt_init(&(unused->_crt));
+		error = ts_credential_parse(unused, unused);
+		if (error != 0) {
+			mbedtls_x509_crt_free(&(unused->_crt));
+		}
+	}
+	if (error != 0) {
+		ts_status_debug("ts_credential_get: parse failed, %d\n", error);
+		ts_platform_free(unused->_der, der_size);
+		memset(unused, 0x00, sizeof(TsSecurityEmbedCredential_t));
+		ts_credential_unlock();
+		return TsStatusErrorPreconditionFailed;
+	}
+	unused->_type = type;
+	unused->_references = 1;
+	unused->_heap = (uint32_t)der_size + (mbedtls_memory.current - current);
+	if (parent != NULL) {
+		parent->_references = parent->_references + 1;
+	}
+
+	mbedtls_credential_stats.credentials = mbedtls_credential_stats.credentials + 1;
+	mbedtls_credential_stats.parses = mbedtls_credential_stats.parses + 1;
+	mbedtls_credential_stats.parse_time += ts_platform_time() - timestamp;
+	mbedtls_credential_stats.heap = mbedtls_credential_stats.heap + unused->_heap;
+
+	*credential = unused;
+	ts_credential_unlock();
+	return TsStatusOk;
+}
+
 static TsStatus_t ts_create(TsSecurityRef_t *security) {
-	
+
 	ts_status_trace("ts_security_create: mbed\n");
+	return ts_create_transport(security, MBEDTLS_SSL_TRANSPORT_STREAM);
+}
+
+static TsStatus_t ts_create_transport(TsSecurityRef_t *security, int transport) {
+
 	ts_platform_assert(ts_controller != NULL);
 	ts_platform_assert(security != NULL);
 
+	// the credential cache is shared, i.e., guard it before the first security object uses it
+	TsStatus_t status = ts_credential_init();
+	if( status != TsStatusOk ) {
+		return status;
+	}
+
 	// first, allocate and initialize controller memory
 	TsControllerRef_t controller;
-	TsStatus_t status = ts_controller_create(&controller);
+	status = ts_controller_create(&controller);
 	if( status != TsStatusOk ) {
 		return status;
 	}
@@ -127,15 +742,28 @@ static TsStatus_t ts_create(TsSecurityRef_t *security) {
 
 	mbed->_security._controller = controller;
 	mbed->_security._profile = NULL;
-	mbed->_clcert_is_set = false;
-	mbed->_clkey_is_set = false;
+	mbed->_cacert = NULL;
+	mbed->_clcert = NULL;
+	mbed->_clkey = NULL;
 	mbed->_cacert_hostname = SSL_HOST;
-
+	mbed->_handshake_start = 0;
+	mbed->_handshake_bytes = 0;
+	mbed->_io_deadline = 0;
+	mbed->_datagram = (transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM);
+	mbed->_timer_intermediate = 0;
+	mbed->_timer_final = 0;
+	mbed->_resumption = true;
+	mbed->_session_is_set = false;
+	memset(&(mbed->_session_stats), 0x00, sizeof(TsSecuritySessionStats_t));
+	mbed->_psk_size = 0;
+	mbed->_psk_identity_size = 0;
+
+	// account for mbedtls memory, note that this must precede any mbedtls allocation
+	mbedtls_counting_init();
+
+	mbedtls_ssl_session_init(&(mbed->_session));
 	mbedtls_ssl_init(&(mbed->_ssl));
 	mbedtls_ssl_config_init(&(mbed->_ssl_config));
-	mbedtls_x509_crt_init(&(mbed->_cacert));
-	mbedtls_x509_crt_init(&(mbed->_clcert));
-	mbedtls_pk_init(&(mbed->_clkey));
 	mbedtls_ctr_drbg_init(&(mbed->_ctr_drbg));
 	mbedtls_entropy_init(&(mbed->_entropy));
 
@@ -157,10 +785,9 @@ static TsStatus_t ts_create(TsSecurityRef_t *security) {
 
 	// initialize ssl-config
 	{
-		// TODO - allow DTLS on config
 		int error = mbedtls_ssl_config_defaults(&(mbed->_ssl_config),
 			MBEDTLS_SSL_IS_CLIENT,
-			MBEDTLS_SSL_TRANSPORT_STREAM,
+			transport,
 			MBEDTLS_SSL_PRESET_DEFAULT );
 		if (error != 0) {
 			ts_status_debug("ts_security_create: mbedtls_ssl_config_defaults failed, %d\n", error );
@@ -171,6 +798,9 @@ static TsStatus_t ts_create(TsSecurityRef_t *security) {
 		// TODO - the hostname to match the one provided on the returned server certificate
 		// TODO - this setting (or simular) should turn that validation off as well, if needed.
 		//mbed->_ssl_config.authmode = MBEDTLS_SSL_VERIFY_NONE;
+
+		// the pre-shared key variant replaces these with its own (see ts_create_psk)
+		mbedtls_ssl_conf_ciphersuites(&(mbed->_ssl_config), mbedtls_certificate_ciphersuites);
 	}
 
 	// initialize ssl-config debugging
@@ -189,10 +819,49 @@ static TsStatus_t ts_create(TsSecurityRef_t *security) {
 	// default to no verification (setting the cacert will enable it again)
 	mbedtls_ssl_conf_authmode(&(mbed->_ssl_config), MBEDTLS_SSL_VERIFY_NONE);
 
+	// resume the session saved before a reboot (if any)
+	ts_session_persist(mbed, false);
+
 	// return success
 	return TsStatusOk;
 }
 
+static TsStatus_t ts_create_psk(TsSecurityRef_t *security) {
+
+	ts_status_trace("ts_security_create: mbed psk\n");
+	ts_platform_assert(security != NULL);
+
+	TsStatus_t status = ts_create(security);
+	if (status != TsStatusOk) {
+		return status;
+	}
+
+	// offer only the pre-shared key suites, i.e., the server never sends its certificate chain
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (*security);
+	mbedtls_ssl_conf_ciphersuites(&(mbed->_ssl_config), mbedtls_psk_ciphersuites);
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_create_dtls(TsSecurityRef_t *security) {
+
+	ts_status_trace("ts_security_create: mbed dtls\n");
+	ts_platform_assert(security != NULL);
+
+	TsStatus_t status = ts_create_transport(security, MBEDTLS_SSL_TRANSPORT_DATAGRAM);
+	if (status != TsStatusOk) {
+		return status;
+	}
+
+	// lost handshake datagrams are retransmitted (see mbedtls_timer_set), and records
+	// failing authentication are dropped up to a limit (e.g., spoofed datagrams)
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (*security);
+	mbedtls_ssl_conf_handshake_timeout(&(mbed->_ssl_config), TS_SECURITY_MBED_DTLS_MIN_TIMEOUT, TS_SECURITY_MBED_DTLS_MAX_TIMEOUT);
+	mbedtls_ssl_conf_dtls_badmac_limit(&(mbed->_ssl_config), TS_SECURITY_MBED_DTLS_BADMAC_LIMIT);
+
+	return TsStatusOk;
+}
+
 static TsStatus_t ts_destroy(TsSecurityRef_t security) {
 
 	ts_status_trace("ts_security_destroy\n");
@@ -208,13 +877,15 @@ static TsStatus_t ts_destroy(TsSecurityRef_t security) {
 
 	// then, free this memory
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	mbedtls_ssl_session_free(&(mbed->_session));
 	mbedtls_ssl_free(&(mbed->_ssl));
 	mbedtls_ssl_config_free(&(mbed->_ssl_config));
-	mbedtls_x509_crt_free(&(mbed->_cacert));
-	mbedtls_x509_crt_free(&(mbed->_clcert));
-	mbedtls_pk_free(&(mbed->_clkey));
 	mbedtls_ctr_drbg_free(&(mbed->_ctr_drbg));
 	mbedtls_entropy_free(&(mbed->_entropy));
+	memset(mbed->_psk, 0x00, sizeof(mbed->_psk));
+	ts_credential_release(mbed->_cacert);
+	ts_credential_release(mbed->_clcert);
+	ts_credential_release(mbed->_clkey);
 
 	ts_platform_free(mbed, sizeof(TsSecurityEmbed_t));
 
@@ -249,12 +920,18 @@ static TsStatus_t ts_set_server_cert(TsSecurityRef_t security, const uint8_t *ca
 	ts_platform_assert(security != NULL);
 	ts_platform_assert(security->_controller != NULL);
 
+	// each certificate extends the chain of those set before it
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
-	int status = mbedtls_x509_crt_parse_der(&(mbed->_cacert), (const unsigned char *) cacert, cacert_size);
-	if (status != 0) {
-		return TsStatusErrorPreconditionFailed;
+	TsSecurityEmbedCredential_t * credential;
+	TsStatus_t status = ts_credential_get(TsSecurityEmbedCredentialServerCert, mbed->_cacert, cacert, cacert_size, &credential);
+	if (status != TsStatusOk) {
+		return status;
 	}
-	mbedtls_ssl_conf_ca_chain(&(mbed->_ssl_config), &(mbed->_cacert), NULL);
+
+	// the new chain holds the certificates before it, i.e., they remain cached while it does
+	ts_credential_release(mbed->_cacert);
+	mbed->_cacert = credential;
+	mbedtls_ssl_conf_ca_chain(&(mbed->_ssl_config), &(credential->_crt), NULL);
 	mbedtls_ssl_conf_authmode(&(mbed->_ssl_config), MBEDTLS_SSL_VERIFY_REQUIRED);
 
 	return TsStatusOk;
@@ -266,19 +943,25 @@ static TsStatus_t ts_set_client_cert(TsSecurityRef_t security, const uint8_t *cl
 	ts_platform_assert(security != NULL);
 	ts_platform_assert(security->_controller != NULL);
 
+	// a certificate replaced before the key was set was never configured, otherwise the ssl
+	// config still refers to it (mbedtls cannot remove it), i.e., it keeps its reference
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
-	if( mbedtls_x509_crt_parse_der(&(mbed->_clcert), (const unsigned char *) clcert, clcert_size) != 0) {
-		return TsStatusErrorPreconditionFailed;
+	TsSecurityEmbedCredential_t * replaced = mbed->_clcert;
+	TsStatus_t status = ts_credential_get(TsSecurityEmbedCredentialClientCert, NULL, clcert, clcert_size, &(mbed->_clcert));
+	if( status != TsStatusOk ) {
+		return status;
+	}
+	if( mbed->_clkey == NULL ) {
+		ts_credential_release(replaced);
 	}
 
-	mbed->_clcert_is_set = true;
-	if( mbed->_clkey_is_set ) {
-		if( mbedtls_ssl_conf_own_cert(&(mbed->_ssl_config), &(mbed->_clcert), &(mbed->_clkey) ) != 0) {
+	if( mbed->_clkey != NULL ) {
+		if( mbedtls_ssl_conf_own_cert(&(mbed->_ssl_config), &(mbed->_clcert->_crt), &(mbed->_clkey->_pk) ) != 0) {
 			return TsStatusErrorPreconditionFailed;
 		}
 	}
 
-	return TsStatusErrorNotImplemented;
+	return TsStatusOk;
 }
 
 static TsStatus_t ts_set_client_key(TsSecurityRef_t security, const uint8_t *clkey, size_t key_size) {
@@ -287,19 +970,24 @@ static TsStatus_t ts_set_client_key(TsSecurityRef_t security, const uint8_t *clk
 	ts_platform_assert(security != NULL);
 	ts_platform_assert(security->_controller != NULL);
 
+	// as above, a key replaced before the certificate was set was never configured
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
-	if( mbedtls_pk_parse_key(&(mbed->_clkey), clkey, key_size, NULL, 0) != 0) {
-		return TsStatusErrorPreconditionFailed;
+	TsSecurityEmbedCredential_t * replaced = mbed->_clkey;
+	TsStatus_t status = ts_credential_get(TsSecurityEmbedCredentialClientKey, NULL, clkey, key_size, &(mbed->_clkey));
+	if( status != TsStatusOk ) {
+		return status;
+	}
+	if( mbed->_clcert == NULL ) {
+		ts_credential_release(replaced);
 	}
 
-	mbed->_clkey_is_set = true;
-	if( mbed->_clcert_is_set ) {
-		if( mbedtls_ssl_conf_own_cert(&(mbed->_ssl_config), &(mbed->_clcert), &(mbed->_clkey) ) != 0) {
+	if( mbed->_clcert != NULL ) {
+		if( mbedtls_ssl_conf_own_cert(&(mbed->_ssl_config), &(mbed->_clcert->_crt), &(mbed->_clkey->_pk) ) != 0) {
 			return TsStatusErrorPreconditionFailed;
 		}
 	}
 
-	return TsStatusErrorNotImplemented;
+	return TsStatusOk;
 }
 
 
@@ -355,6 +1043,32 @@ static TsStatus_t ts_connect(TsSecurityRef_t security, TsAddress_t address) {
 	ts_platform_assert(ts_controller != NULL);
 	ts_platform_assert(security->_controller != NULL);
 
+	// negotiate until complete, handshake will give up after SSL_HANDSHAKE_TIMEOUT
+	TsStatus_t status = ts_connect_start(security, address);
+	while (status == TsStatusOkTrying) {
+		status = ts_handshake(security, SSL_HANDSHAKE_TIMEOUT);
+	}
+
+	/* TODO - verify server x.509?
+	if( ( flags = mbedtls_ssl_get_verify_result( &ssl ) ) != 0 )
+	{
+		char vrfy_buf[512];
+		mbedtls_x509_crt_verify_info( vrfy_buf, sizeof( vrfy_buf ), "  ! ", flags );
+		ts_status_debug( "failed cert verification, %s\n", vrfy_buf );
+		status = TsStatusErrorPreconditionFailed;
+		ts_controller_disconnect(security);
+	}
+	*/
+
+	return status;
+}
+
+static TsStatus_t ts_connect_start(TsSecurityRef_t security, TsAddress_t address) {
+
+	ts_status_trace("ts_security_connect_start\n");
+	ts_platform_assert(ts_controller != NULL);
+	ts_platform_assert(security->_controller != NULL);
+
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
 	mbedtls_ssl_context *ssl = &(mbed->_ssl);
 	mbedtls_ssl_config *ssl_config = &(mbed->_ssl_config);
@@ -363,13 +1077,24 @@ static TsStatus_t ts_connect(TsSecurityRef_t security, TsAddress_t address) {
 	if (ts_address_parse(address, host, port) != TsStatusOk) {
 		return TsStatusErrorPreconditionFailed;
 	}
-	// TODO - allow differentiate from TCP and UDP
+	// dtls runs over udp whether or not the address says so
+	char datagram_address[TS_ADDRESS_MAX_SCHEME_SIZE + TS_ADDRESS_MAX_HOST_SIZE + TS_ADDRESS_MAX_PORT_SIZE + 1];
+	if (mbed->_datagram && !ts_address_is_datagram(address)) {
+		snprintf(datagram_address, sizeof(datagram_address), "%s%s:%s", TS_ADDRESS_DATAGRAM_SCHEME, host, port);
+		address = datagram_address;
+	}
 	// TODO - allow non-block setup
 	TsStatus_t status = ts_controller_connect(security->_controller, address);
 	if (status != TsStatusOk) {
 		return status;
 	}
-	if (mbedtls_ssl_setup(ssl, ssl_config) != 0) {
+	// ask the server for records that fit the connection mtu (and the record buffers)
+	uint32_t mtu = security->_controller->_driver->_spec_mtu;
+	mbedtls_ssl_conf_max_frag_len(ssl_config, ts_fragment_code(mtu, &(mbedtls_memory.fragment)));
+
+	// the context is set up once, and reset for each following connection
+	int error = (ssl->conf == NULL) ? mbedtls_ssl_setup(ssl, ssl_config) : mbedtls_ssl_session_reset(ssl);
+	if (error != 0) {
 		ts_controller_disconnect(security->_controller);
 		return TsStatusErrorPreconditionFailed;
 	}
@@ -378,54 +1103,66 @@ static TsStatus_t ts_connect(TsSecurityRef_t security, TsAddress_t address) {
 		return TsStatusErrorPreconditionFailed;
 	}
 	mbedtls_ssl_set_bio(ssl, security, mbedtls_tcp_send, mbedtls_tcp_recv, NULL);
+	if (mbed->_datagram) {
+		mbed->_timer_final = 0;
+		mbedtls_ssl_set_timer_cb(ssl, mbed, mbedtls_timer_set, mbedtls_timer_get);
+	}
+
+	// offer the saved session (if any), the server decides whether it's resumed
+	if (mbed->_resumption && mbed->_session_is_set && mbedtls_ssl_set_session(ssl, &(mbed->_session)) != 0) {
+		ts_status_debug("ts_security_connect_start: cannot offer saved session, ignoring\n");
+	}
+
+	// the handshake is advanced by ts_handshake
+	mbed->_handshake_start = ts_platform_time();
+	mbed->_handshake_bytes = 0;
+	mbedtls_memory.peak = mbedtls_memory.current;
+	return TsStatusOkTrying;
+}
+
+static TsStatus_t ts_handshake(TsSecurityRef_t security, uint32_t budget) {
+
+	ts_status_trace("ts_security_handshake\n");
+	ts_platform_assert(ts_controller != NULL);
+	ts_platform_assert(security != NULL);
+	ts_platform_assert(security->_controller != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	mbedtls_ssl_context *ssl = &(mbed->_ssl);
 
-	// TODO - should be handled in tick?
-	status = TsStatusOk;
 	uint64_t timestamp = ts_platform_time();
-	bool handshaking = true;
+	mbed->_io_deadline = timestamp + budget;
 	do  {
 
 		int error = mbedtls_ssl_handshake(ssl);
 		/* XXX: Modem's (controller's) tick needs to be advanced. */
 		ts_controller_tick(security->_controller, 0);
 		switch (error) {
+		case 0:
+
+			ts_session_complete(mbed);
+			return TsStatusOk;
+
 		case MBEDTLS_ERR_SSL_WANT_READ:
 		case MBEDTLS_ERR_SSL_WANT_WRITE:
 
 			// check timeout
-			if (ts_platform_time() - timestamp > SSL_HANDSHAKE_TIMEOUT) {
-				status = TsStatusErrorExceedTimeBudget;
+			if (ts_platform_time() - mbed->_handshake_start > SSL_HANDSHAKE_TIMEOUT) {
 				ts_controller_disconnect(security->_controller);
-				handshaking = false;
+				return TsStatusErrorExceedTimeBudget;
 			}
 			break;
 
 		default:
 
-			ts_status_debug("ts_security_connect: error, '0x%04x'\n", -1 * error);
-			status = TsStatusErrorPreconditionFailed;
+			ts_status_debug("ts_security_handshake: error, '0x%04x'\n", -1 * error);
+			ts_session_forget(mbed);
 			ts_controller_disconnect(security->_controller);
-			// fallthrough
-
-		case 0:
-
-			handshaking = false;
-			break;
+			return TsStatusErrorPreconditionFailed;
 		}
-	} while( handshaking );
+	} while (ts_platform_time() - timestamp < budget);
 
-	/* TODO - verify server x.509?
-	if( ( flags = mbedtls_ssl_get_verify_result( &ssl ) ) != 0 )
-	{
-		char vrfy_buf[512];
-		mbedtls_x509_crt_verify_info( vrfy_buf, sizeof( vrfy_buf ), "  ! ", flags );
-		ts_status_debug( "failed cert verification, %s\n", vrfy_buf );
-		status = TsStatusErrorPreconditionFailed;
-		ts_controller_disconnect(security);
-	}
-	*/
-
-	return status;
+	return TsStatusOkTrying;
 }
 
 static TsStatus_t ts_disconnect(TsSecurityRef_t security) {
@@ -452,9 +1189,10 @@ static TsStatus_t ts_read(TsSecurityRef_t security, const uint8_t *buffer, size_
 
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
 	mbedtls_ssl_context *ssl = &(mbed->_ssl);
-	if( budget != SSL_READ_BUDGET ) {
-		ts_status_trace( "ts_security_read: mbedtls timer budget cannot be dynamic, use SSL_READ_BUDGET instead.\n");
-	}
+
+	// the driver i/o (see mbedtls_tcp_recv) gives up at the end of the budget, and mbedtls
+	// keeps a partially received record until the next call
+	mbed->_io_deadline = ts_platform_time() + budget;
 
 	TsStatus_t status = TsStatusOk;
 	bool reading = true;
@@ -533,7 +1271,10 @@ static TsStatus_t ts_read(TsSecurityRef_t security, const uint8_t *buffer, size_
 		}
 
 		index = index + size;
-		if (index >= *buffer_size) {
+		if (index >= *buffer_size || ts_io_remaining(mbed) == 0) {
+			reading = false;
+		} else if (mbed->_datagram && index > 0) {
+			// keep datagrams apart, i.e., return one per read
 			reading = false;
 		}
 	} while( reading );
@@ -553,9 +1294,10 @@ static TsStatus_t ts_write(TsSecurityRef_t security, const uint8_t *buffer, size
 
 	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
 	mbedtls_ssl_context *ssl = &(mbed->_ssl);
-	if( budget != SSL_WRITE_BUDGET ) {
-		ts_status_trace( "ts_security_write: mbedtls timer budget cannot be dynamic, use SSL_WRITE_BUDGET instead.\n");
-	}
+
+	// the driver i/o (see mbedtls_tcp_send) gives up at the end of the budget, and mbedtls
+	// keeps a partially sent record, i.e., the caller must retry with the remaining data
+	mbed->_io_deadline = ts_platform_time() + budget;
 
 	/**
 	 * \brief          Try to write exactly 'len' application data bytes
@@ -628,15 +1370,119 @@ static TsStatus_t ts_write(TsSecurityRef_t security, const uint8_t *buffer, size
 		}
 
 		index = index + size;
-		if( index >= *buffer_size ) {
+		if( index >= *buffer_size || ts_io_remaining(mbed) == 0 ) {
 			writing = false;
 		}
 	} while( writing );
 
+	if( status == TsStatusOk && index == 0 && *buffer_size > 0 ) {
+		status = TsStatusOkWritePending;
+	}
 	*buffer_size = (size_t)index;
 	return status;
 }
 
+static TsStatus_t ts_set_resumption(TsSecurityRef_t security, bool enable) {
+
+	ts_status_trace("ts_security_set_resumption\n");
+	ts_platform_assert(security != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	mbed->_resumption = enable;
+	if (!enable) {
+		ts_session_forget(mbed);
+	}
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	mbedtls_ssl_conf_session_tickets(&(mbed->_ssl_config), enable ? MBEDTLS_SSL_SESSION_TICKETS_ENABLED : MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+#endif
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_get_session_stats(TsSecurityRef_t security, TsSecuritySessionStats_t *stats) {
+
+	ts_status_trace("ts_security_get_session_stats\n");
+	ts_platform_assert(security != NULL);
+	ts_platform_assert(stats != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	memcpy(stats, &(mbed->_session_stats), sizeof(TsSecuritySessionStats_t));
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_get_memory_stats(TsSecurityRef_t security, TsSecurityMemoryStats_t *stats) {
+
+	ts_status_trace("ts_security_get_memory_stats\n");
+	ts_platform_assert(security != NULL);
+	ts_platform_assert(stats != NULL);
+
+	memcpy(stats, &mbedtls_memory, sizeof(TsSecurityMemoryStats_t));
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_get_credential_stats(TsSecurityRef_t security, TsSecurityCredentialStats_t *stats) {
+
+	ts_status_trace("ts_security_get_credential_stats\n");
+	ts_platform_assert(security != NULL);
+	ts_platform_assert(stats != NULL);
+
+	ts_credential_lock();
+	memcpy(stats, &mbedtls_credential_stats, sizeof(TsSecurityCredentialStats_t));
+	ts_credential_unlock();
+
+	return TsStatusOk;
+}
+
+/**
+ * Configure the pre-shared key once both the key and its identity are known.
+ */
+static TsStatus_t ts_psk_configure(TsSecurityEmbedRef_t mbed) {
+
+	if (mbed->_psk_size == 0 || mbed->_psk_identity_size == 0) {
+		return TsStatusOk;
+	}
+	int error = mbedtls_ssl_conf_psk(&(mbed->_ssl_config), mbed->_psk, mbed->_psk_size, mbed->_psk_identity, mbed->_psk_identity_size);
+	if (error != 0) {
+		ts_status_debug("ts_security_set_psk: mbedtls_ssl_conf_psk failed, %d\n", error);
+		return TsStatusErrorPreconditionFailed;
+	}
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_set_psk(TsSecurityRef_t security, const uint8_t *psk, size_t psk_size) {
+
+	ts_status_trace("ts_security_set_psk\n");
+	ts_platform_assert(security != NULL);
+	ts_platform_assert(psk != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	if (psk_size == 0 || psk_size > MBEDTLS_PSK_MAX_LEN) {
+		return TsStatusErrorIndexOutOfRange;
+	}
+	memcpy(mbed->_psk, psk, psk_size);
+	mbed->_psk_size = psk_size;
+
+	return ts_psk_configure(mbed);
+}
+
+static TsStatus_t ts_set_psk_identity(TsSecurityRef_t security, const uint8_t *identity, size_t identity_size) {
+
+	ts_status_trace("ts_security_set_psk_identity\n");
+	ts_platform_assert(security != NULL);
+	ts_platform_assert(identity != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t) (security);
+	if (identity_size == 0 || identity_size > TS_SECURITY_MBED_MAX_PSK_IDENTITY_SIZE) {
+		return TsStatusErrorIndexOutOfRange;
+	}
+	memcpy(mbed->_psk_identity, identity, identity_size);
+	mbed->_psk_identity_size = identity_size;
+
+	return ts_psk_configure(mbed);
+}
+
 /**
  * \brief          Set the debug callback
  *
@@ -683,12 +1529,12 @@ static int mbedtls_tcp_recv(void *context, unsigned char *buffer, size_t buffer_
 
 	int index = 0;
 	bool reading = true;
-	uint64_t timestamp = ts_platform_time();
 	TsSecurityRef_t security = (TsSecurityRef_t)(context);
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t)(context);
 	do {
 
 		size_t xbuffer_size = buffer_size - index;
-		TsStatus_t status = ts_controller_read(security->_controller, (uint8_t *) (buffer + index), &xbuffer_size, SSL_READ_BUDGET);
+		TsStatus_t status = ts_controller_read(security->_controller, (uint8_t *) (buffer + index), &xbuffer_size, ts_io_remaining(mbed));
 		switch( status ) {
 		default:
 			ts_status_debug( "mbedtls_tcp_recv: %s\n", ts_status_string(status) );
@@ -700,8 +1546,13 @@ static int mbedtls_tcp_recv(void *context, unsigned char *buffer, size_t buffer_
 
 		case TsStatusOkReadPending:
 			if( index == 0 ) {
+				// sleep until bytes arrive (or the budget ends), instead of having the caller spin
+				if( ts_io_wait(security) ) {
+					continue;
+				}
 				return MBEDTLS_ERR_SSL_WANT_READ;
 			} else {
+				mbed->_handshake_bytes += (uint32_t)index;
 				return index;
 			}
 			// fallthrough
@@ -711,14 +1562,15 @@ static int mbedtls_tcp_recv(void *context, unsigned char *buffer, size_t buffer_
 		}
 
 		index = index + (int)xbuffer_size;
-		if( index >= buffer_size || xbuffer_size == 0 ) {
+		if( index >= buffer_size || xbuffer_size == 0 || mbed->_datagram ) {
 			reading = false;
-		} else if ( ts_platform_time() - timestamp > 60e6 ) {
-			ts_status_alarm( "mbedtls_tcp_read: timeout occurred\n" );
+		} else if ( ts_io_remaining(mbed) == 0 ) {
+			ts_status_debug( "mbedtls_tcp_recv: budget exhausted, returning control to caller,...\n" );
 			reading = false;
 		}
 
 	} while( reading );
+	mbed->_handshake_bytes += (uint32_t)index;
 	return index;
 }
 
@@ -748,12 +1600,12 @@ static int mbedtls_tcp_send(void *context, const unsigned char *buffer, size_t b
 
 	int index = 0;
 	bool writing = true;
-	uint64_t timestamp = ts_platform_time();
 	TsSecurityRef_t security = (TsSecurityRef_t)(context);
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t)(context);
 	do {
 
 		size_t xbuffer_size = buffer_size - index;
-		TsStatus_t status = ts_controller_write(security->_controller, (uint8_t *) (buffer + index), &xbuffer_size, SSL_WRITE_BUDGET);
+		TsStatus_t status = ts_controller_write(security->_controller, (uint8_t *) (buffer + index), &xbuffer_size, ts_io_remaining(mbed));
 		switch( status ) {
 		default:
 			ts_status_debug( "mbedtls_tcp_send: %s\n", ts_status_string(status) );
@@ -767,6 +1619,7 @@ static int mbedtls_tcp_send(void *context, const unsigned char *buffer, size_t b
 			if( index == 0 ) {
 				return MBEDTLS_ERR_SSL_WANT_WRITE;
 			} else {
+				mbed->_handshake_bytes += (uint32_t)index;
 				return index;
 			}
 
@@ -780,15 +1633,68 @@ static int mbedtls_tcp_send(void *context, const unsigned char *buffer, size_t b
 		} else if ( xbuffer_size == 0 ) {
 			ts_status_alarm( "mbedtls_tcp_send: zero sized write\n" );
 			writing = false;
-		} else if ( ts_platform_time() - timestamp > 60e6 ) {
-			ts_status_alarm( "mbedtls_tcp_send: timeout occurred\n" );
+		} else if ( ts_io_remaining(mbed) == 0 ) {
+			ts_status_debug( "mbedtls_tcp_send: budget exhausted, returning control to caller,...\n" );
 			writing = false;
 		}
 
 	} while( writing );
+	mbed->_handshake_bytes += (uint32_t)index;
 	return index;
 }
 
+/**
+ * \brief          Callback type: set a pair of timers/delays to watch
+ *
+ * \param ctx      Context pointer
+ * \param int_ms   Intermediate delay in milliseconds
+ * \param fin_ms   Final delay in milliseconds
+ *                 0 cancels the current timer.
+ */
+static void mbedtls_timer_set(void *context, uint32_t intermediate_ms, uint32_t final_ms) {
+
+	ts_status_trace( "mbedtls_timer_set\n");
+	ts_platform_assert(context != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t)(context);
+	if( final_ms == 0 ) {
+		mbed->_timer_intermediate = 0;
+		mbed->_timer_final = 0;
+		return;
+	}
+	uint64_t now = ts_platform_time();
+	mbed->_timer_intermediate = now + (uint64_t)intermediate_ms * TS_TIME_MSEC_TO_USEC;
+	mbed->_timer_final = now + (uint64_t)final_ms * TS_TIME_MSEC_TO_USEC;
+}
+
+/**
+ * \brief          Callback type: get status of timers/delays
+ *
+ * \param ctx      Context pointer
+ *
+ * \return         -1 if cancelled (fin_ms == 0),
+ *                  0 if none of the delays have passed,
+ *                  1 if only the intermediate delay has passed,
+ *                  2 if the final delay has passed.
+ */
+static int mbedtls_timer_get(void *context) {
+
+	ts_platform_assert(context != NULL);
+
+	TsSecurityEmbedRef_t mbed = (TsSecurityEmbedRef_t)(context);
+	if( mbed->_timer_final == 0 ) {
+		return -1;
+	}
+	uint64_t now = ts_platform_time();
+	if( now >= mbed->_timer_final ) {
+		return 2;
+	}
+	if( now >= mbed->_timer_intermediate ) {
+		return 1;
+	}
+	return 0;
+}
+
 /**
  * \brief           Entropy poll callback for a hardware source
  *
@@ -815,4 +1721,4 @@ int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t
 	*olen = len;
 	return 0;
 }
-#endif // TS_SECURITY_MBED
+#endif // TS_SECURITY_MBED || TS_SECURITY_MBED_PSK || TS_SECURITY_MBED_DTLS
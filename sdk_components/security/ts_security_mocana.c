@@ -26,6 +26,7 @@ static TsStatus_t ts_get_spec_id( TsSecurityRef_t, const uint8_t *, size_t );
 static TsStatus_t ts_get_spec_budget( TsSecurityRef_t, uint32_t* );
 
 static TsStatus_t ts_connect(TsSecurityRef_t, TsAddress_t);
+static TsStatus_t ts_handshake(TsSecurityRef_t, uint32_t);
 static TsStatus_t ts_disconnect(TsSecurityRef_t);
 static TsStatus_t ts_read(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
 static TsStatus_t ts_write(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
@@ -44,7 +45,11 @@ TsSecurityVtable_t ts_security_mocana = {
 	.get_spec_id = ts_get_spec_id,
 	.get_spec_budget = ts_get_spec_budget,
 
+	// incremental dial is not supported, i.e., without connect_start the connection layer uses
+	// the blocking connect, and handshake is never left anything to advance
 	.connect = ts_connect,
+	.connect_start = NULL,
+	.handshake = ts_handshake,
 	.disconnect = ts_disconnect,
 	.read = ts_read,
 	.write = ts_write,
@@ -332,6 +337,16 @@ static TsStatus_t ts_connect(TsSecurityRef_t security, TsAddress_t address) {
 	return TsStatusOk;
 }
 
+static TsStatus_t ts_handshake(TsSecurityRef_t security, uint32_t budget) {
+
+	ts_status_trace("ts_security_handshake\n");
+	ts_platform_assert(security != NULL);
+
+	// SSL_negotiateConnection is blocking, i.e., the handshake cannot be divided across ticks
+	ts_status_debug("ts_security_handshake: not supported, mocana completes the handshake in connect\n");
+	return TsStatusErrorNotImplemented;
+}
+
 static TsStatus_t ts_disconnect(TsSecurityRef_t security) {
 
 	ts_status_trace("ts_security_disconnect\n");
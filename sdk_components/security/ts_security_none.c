@@ -17,6 +17,7 @@ static TsStatus_t ts_get_spec_id( TsSecurityRef_t, const uint8_t *, size_t );
 static TsStatus_t ts_get_spec_budget( TsSecurityRef_t, uint32_t* );
 
 static TsStatus_t ts_connect(TsSecurityRef_t, TsAddress_t);
+static TsStatus_t ts_handshake(TsSecurityRef_t, uint32_t);
 static TsStatus_t ts_disconnect(TsSecurityRef_t);
 static TsStatus_t ts_read(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
 static TsStatus_t ts_write(TsSecurityRef_t, const uint8_t *, size_t *, uint32_t);
@@ -36,6 +37,8 @@ TsSecurityVtable_t ts_security_none = {
 	.get_spec_budget = ts_get_spec_budget,
 
 	.connect = ts_connect,
+	.connect_start = ts_connect,
+	.handshake = ts_handshake,
 	.disconnect = ts_disconnect,
 	.read = ts_read,
 	.write = ts_write,
@@ -170,6 +173,14 @@ static TsStatus_t ts_connect(TsSecurityRef_t security, TsAddress_t address) {
 	return ts_controller_connect(security->_controller, address);
 }
 
+static TsStatus_t ts_handshake(TsSecurityRef_t security, uint32_t budget) {
+	ts_status_trace("ts_security_handshake\n");
+	ts_platform_assert(security != NULL);
+
+	// there is no negotiation, the connection is complete once connected
+	return TsStatusOk;
+}
+
 static TsStatus_t ts_disconnect(TsSecurityRef_t security) {
 	ts_status_trace("ts_security_disconnect\n");
 	ts_platform_assert(ts_controller != NULL);
@@ -15,6 +15,7 @@ static TsStatus_t ts_destroy( TsServiceRef_t );
 static TsStatus_t ts_tick( TsServiceRef_t, uint32_t );
 
 static TsStatus_t ts_enqueue( TsServiceRef_t, TsMessageRef_t );
+static TsStatus_t ts_enqueue_qos( TsServiceRef_t, TsMessageRef_t, TsTransportQos_t );
 static TsStatus_t ts_enqueue_typed( TsServiceRef_t service, char* type, TsMessageRef_t data);
 static TsStatus_t ts_dequeue( TsServiceRef_t, TsServiceAction_t, TsServiceHandler_t );
 
@@ -25,20 +26,23 @@ TsServiceVtable_t ts_service_ts_cbor = {
 	.destroy = ts_destroy,
 	.tick = ts_tick,
 	.enqueue = ts_enqueue,
+	.enqueueqos = ts_enqueue_qos,
 	.enqueuetyped = ts_enqueue_typed,
 	.dequeue = ts_dequeue,
 };
 
-// Callback used by ts_firewall and ts_log to issue alert messages over the connection.
+#ifdef TS_ODS_ENABLED
+// Callback used by ts_log, ts_firewall and ts_scepconfig to issue log reports and alert messages
+// over the connection of the owning service, i.e., the context given when they were created.
 
-static TsServiceRef_t _messageSendingService;
-static TsStatus_t _send_message_callback( TsMessageRef_t message, char *kind ) {
-	if (_messageSendingService != NULL && message != NULL) {
-		return ts_enqueue_typed( _messageSendingService, kind, message );
+static TsStatus_t _send_message_callback( void * context, TsMessageRef_t message, char *kind ) {
+	if (context != NULL && message != NULL) {
+		return ts_enqueue_typed( (TsServiceRef_t)context, kind, message );
 	} else {
 		return TsStatusErrorPreconditionFailed;
 	}
 }
+#endif
 
 static TsStatus_t ts_create( TsServiceRef_t * service ) {
 
@@ -46,18 +50,16 @@ static TsStatus_t ts_create( TsServiceRef_t * service ) {
 	ts_platform_assert( service != NULL );
 	ts_platform_assert( *service != NULL );
 
-	_messageSendingService = *service;
-
 #ifdef TS_ODS_ENABLED
 	// create logconfig
-	TsStatus_t status = ts_logconfig_create(&((*service)->_logconfig) , _send_message_callback);
+	TsStatus_t status = ts_logconfig_create(&((*service)->_logconfig) , _send_message_callback, *service);
 	if ( status != TsStatusOk ) {
 		ts_status_alarm( "ts_service_create: failed to create log config, '%s'\n", ts_status_string(status));
 	}
 
 #ifdef TS_SCEP_ENABLED
 	// create scepconfig
-	status = ts_scepconfig_create(&((*service)->_scepconfig) , _send_message_callback);
+	status = ts_scepconfig_create(&((*service)->_scepconfig) , _send_message_callback, *service);
 	if ( status != TsStatusOk ) {
 		ts_status_alarm( "ts_service_create: failed to create scep config, '%s'\n", ts_status_string(status));
 	}
@@ -65,7 +67,7 @@ static TsStatus_t ts_create( TsServiceRef_t * service ) {
 
 	// create firewall if supported
 	if( ts_firewall != NULL ) {
-		TsStatus_t status = ts_firewall_create( &((*service)->_firewall) , _send_message_callback);
+		TsStatus_t status = ts_firewall_create( &((*service)->_firewall) , _send_message_callback, *service);
 		if( status != TsStatusOk ) {
 			ts_status_alarm( "ts_service_create: failed to create installed firewall, '%s'\n", ts_status_string(status));
 		}
@@ -90,6 +92,13 @@ static TsStatus_t ts_destroy( TsServiceRef_t service ) {
 	if ( service->_logconfig != NULL ) {
 		ts_logconfig_destroy( service->_logconfig );
 	}
+
+#if defined(TS_ODS_ENABLED) && defined(TS_SCEP_ENABLED)
+	// destroy scep config, if already created
+	if ( service->_scepconfig != NULL ) {
+		ts_scepconfig_destroy( service->_scepconfig );
+	}
+#endif
 	return TsStatusOk;
 }
 
@@ -104,6 +113,19 @@ static TsStatus_t ts_tick( TsServiceRef_t service, uint32_t budget ) {
 
 #define MIN_MTU 512
 
+static void ts_encode_envelope( uint8_t envelope[ 4 ], const uint8_t * body, size_t body_size, TsTransportSegment_t segments[ 2 ] ) {
+
+	envelope[ 0 ] = TsServiceEnvelopeVersionOne;
+	envelope[ 1 ] = TsServiceEnvelopeServiceIdTsCbor;
+	envelope[ 2 ] = (uint8_t)(body_size >> 8);
+	envelope[ 3 ] = (uint8_t)(body_size & 0xff);
+
+	segments[ 0 ].buffer = envelope;
+	segments[ 0 ].buffer_size = 4;
+	segments[ 1 ].buffer = body;
+	segments[ 1 ].buffer_size = body_size;
+}
+
 static TsStatus_t ts_encode_and_send_message(TsServiceRef_t service, const uint8_t id[ TS_DRIVER_MAX_ID_SIZE ], TsMessageRef_t message) {
 		// encode copy to send buffer
 		// i.e., encode and send unsolicited message
@@ -119,14 +141,12 @@ static TsStatus_t ts_encode_and_send_message(TsServiceRef_t service, const uint8
 		}
 
 		size_t buffer_size = mtu - 4;
-		ts_message_encode(message, TsEncoderTsCbor, buffer + 4, &buffer_size);
+		ts_message_encode(message, TsEncoderTsCbor, buffer, &buffer_size);
 
-		// encode envelope
-		buffer[ 0 ] = TsServiceEnvelopeVersionOne;
-		buffer[ 1 ] = TsServiceEnvelopeServiceIdTsCbor;
-		buffer[ 2 ] = (uint8_t)(buffer_size >> 8);
-		buffer[ 3 ] = (uint8_t)(buffer_size & 0xff);
-		buffer_size = buffer_size + 4;
+		// encode envelope, sent as a separate segment ahead of the body
+		uint8_t envelope[ 4 ];
+		TsTransportSegment_t segments[ 2 ];
+		ts_encode_envelope( envelope, buffer, buffer_size, segments );
 
 		// send data
 		size_t topic_size = 256;
@@ -134,12 +154,12 @@ static TsStatus_t ts_encode_and_send_message(TsServiceRef_t service, const uint8
 		snprintf( topic, topic_size, "ThingSpace/%s/ElementToProvider", id );
 
 		// TODO - check return codes - may have disconnected.
-		ts_transport_speak( service->_transport, (TsPath_t)topic, buffer, buffer_size );
+		TsStatus_t status = ts_service_speak_vector( service, (TsPath_t)topic, segments, 2, TsTransportQos1 );
 
 		// clean-up and return
 
 		ts_platform_free( buffer, mtu );
-		return TsStatusOk;
+		return status;
 }
 
 static TsStatus_t ts_enqueue_typed( TsServiceRef_t service, char* type, TsMessageRef_t data) {
@@ -182,6 +202,12 @@ static TsStatus_t ts_enqueue_typed( TsServiceRef_t service, char* type, TsMessag
 static TsStatus_t ts_enqueue( TsServiceRef_t service, TsMessageRef_t sensor ) {
 
 	ts_status_trace("ts_service_enqueue\n");
+	return ts_enqueue_qos( service, sensor, TsTransportQos1 );
+}
+
+static TsStatus_t ts_enqueue_qos( TsServiceRef_t service, TsMessageRef_t sensor, TsTransportQos_t qos ) {
+
+	ts_status_trace("ts_service_enqueue_qos\n");
 
 	// get device-id from controller (via connection)
 	const uint8_t id[ TS_DRIVER_MAX_ID_SIZE ];
@@ -208,14 +234,12 @@ static TsStatus_t ts_enqueue( TsServiceRef_t service, TsMessageRef_t sensor ) {
 	}
 
 	size_t buffer_size = (size_t)(mtu - 4);
-	ts_message_encode(message, TsEncoderTsCbor, buffer + 4, &buffer_size);
-
-	// encode envelope
-	buffer[ 0 ] = TsServiceEnvelopeVersionOne;
-	buffer[ 1 ] = TsServiceEnvelopeServiceIdTsCbor;
-	buffer[ 2 ] = (uint8_t)(buffer_size >> 8);
-	buffer[ 3 ] = (uint8_t)(buffer_size & 0xff);
-	buffer_size = buffer_size + 4;
+	ts_message_encode(message, TsEncoderTsCbor, buffer, &buffer_size);
+
+	// encode envelope, sent as a separate segment ahead of the body
+	uint8_t envelope[ 4 ];
+	TsTransportSegment_t segments[ 2 ];
+	ts_encode_envelope( envelope, buffer, buffer_size, segments );
 	
 	// send data
 	size_t topic_size = 256;
@@ -223,13 +247,13 @@ static TsStatus_t ts_enqueue( TsServiceRef_t service, TsMessageRef_t sensor ) {
 	snprintf( topic, topic_size, "ThingSpace/%s/ElementToProvider", id );
 
 	// TODO - check return codes - may have disconnected.
-	ts_transport_speak( service->_transport, (TsPath_t)topic, buffer, buffer_size );
+	TsStatus_t status = ts_service_speak_vector( service, (TsPath_t)topic, segments, 2, qos );
 
 	// clean-up and return
 	ts_platform_free( buffer, mtu );
 	ts_message_destroy( message );
 
-	return TsStatusOk;
+	return status;
 }
 
 // TODO - add precondition checks
@@ -480,7 +504,7 @@ static TsStatus_t handler( TsTransportRef_t transport, void * state, TsPath_t pa
 				// ODS suspend messages, note that the message will be modified 'in-place'
 				// and must be returned with the correct status
 
-				status = ts_suspend_handle( message );
+				status = ts_suspend_handle( service->_firewall, service->_logconfig, message );
 			}
 #endif
 			else if( ( strcmp( kind, "ts.device" ) == 0 ) || ( strcmp( kind, "ts.element" ) == 0 ) ) {
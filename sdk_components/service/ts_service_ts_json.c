@@ -8,6 +8,7 @@ static TsStatus_t ts_destroy( TsServiceRef_t );
 static TsStatus_t ts_tick( TsServiceRef_t, uint32_t );
 
 static TsStatus_t ts_enqueue( TsServiceRef_t, TsMessageRef_t );
+static TsStatus_t ts_enqueue_qos( TsServiceRef_t, TsMessageRef_t, TsTransportQos_t );
 static TsStatus_t ts_dequeue( TsServiceRef_t, TsServiceAction_t, TsServiceHandler_t );
 
 static TsStatus_t handler( TsTransportRef_t, void *, TsPath_t, const uint8_t *, size_t );
@@ -17,6 +18,7 @@ TsServiceVtable_t ts_service_ts_json = {
 	.destroy = ts_destroy,
 	.tick = ts_tick,
 	.enqueue = ts_enqueue,
+	.enqueueqos = ts_enqueue_qos,
 	.dequeue = ts_dequeue,
 };
 
@@ -54,6 +56,12 @@ static TsStatus_t ts_tick( TsServiceRef_t service, uint32_t budget ) {
 static TsStatus_t ts_enqueue( TsServiceRef_t service, TsMessageRef_t sensor ) {
 
 	ts_status_trace("ts_service_enqueue\n");
+	return ts_enqueue_qos( service, sensor, TsTransportQos1 );
+}
+
+static TsStatus_t ts_enqueue_qos( TsServiceRef_t service, TsMessageRef_t sensor, TsTransportQos_t qos ) {
+
+	ts_status_trace("ts_service_enqueue_qos\n");
 
 	// TODO - remove hardcoded values
 	const char * unit_name = "unit-name";
@@ -110,12 +118,12 @@ static TsStatus_t ts_enqueue( TsServiceRef_t service, TsMessageRef_t sensor ) {
 	char topic[ 256 ];
 	snprintf( topic, topic_size, "ThingspaceSDK/%s/UNITOnBoard", id );
 	ts_status_debug( "ts_service_enqueue: sending (%.*s) on (%s)\n", buffer_size, buffer, topic );
-	ts_transport_speak( service->_transport, (TsPath_t)topic, buffer, buffer_size );
+	TsStatus_t status = ts_service_speak( service, (TsPath_t)topic, buffer, buffer_size, qos );
 
 	// clean-up and return
-	ts_platform_free( buffer, buffer_size );
+	ts_platform_free( buffer, mtu );
 	ts_message_destroy( message );
-	return TsStatusOk;
+	return status;
 }
 
 // TODO - add precondition checks
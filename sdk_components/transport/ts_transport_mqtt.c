@@ -1,9 +1,14 @@
 // Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <stddef.h>
+
 #include "ts_platform.h"
 #include "ts_status.h"
 #include "ts_connection.h"
 #include "ts_transport.h"
 #include "ts_transport_mqtt.h"
+#if defined( TS_TRANSPORT_MQTT_KEEPALIVE_FILE )
+#include "ts_file.h"
+#endif
 
 /* The following #define was added for the sake of removing
  * the duplicate symbol, MQTTIsConnected (inline) generated
@@ -21,9 +26,19 @@ static TsStatus_t ts_tick( TsTransportRef_t, uint32_t );
 static TsStatus_t ts_get_connection( TsTransportRef_t, TsConnectionRef_t * );
 
 static TsStatus_t ts_dial( TsTransportRef_t, TsAddress_t );
+static TsStatus_t ts_dial_start( TsTransportRef_t, TsAddress_t );
 static TsStatus_t ts_hangup( TsTransportRef_t );
 static TsStatus_t ts_listen( TsTransportRef_t, TsAddress_t, TsPath_t, TsTransportHandler_t, void * );
 static TsStatus_t ts_speak( TsTransportRef_t, TsPath_t, const uint8_t *, size_t );
+static TsStatus_t ts_speak_qos( TsTransportRef_t, TsPath_t, const uint8_t *, size_t, TsTransportQos_t );
+static TsStatus_t ts_speak_vector( TsTransportRef_t, TsPath_t, const TsTransportSegment_t *, size_t, TsTransportQos_t );
+static TsStatus_t ts_set_window( TsTransportRef_t, size_t, uint32_t );
+static TsStatus_t ts_set_ack_handler( TsTransportRef_t, TsTransportAckHandler_t, void * );
+static TsStatus_t ts_set_reconnect( TsTransportRef_t, uint32_t, uint32_t );
+static TsStatus_t ts_get_reconnect_stats( TsTransportRef_t, TsTransportReconnectStats_t * );
+static TsStatus_t ts_set_keepalive( TsTransportRef_t, uint32_t, uint32_t );
+static TsStatus_t ts_get_keepalive_stats( TsTransportRef_t, TsTransportKeepAliveStats_t * );
+static TsStatus_t ts_set_coalescing( TsTransportRef_t, bool );
 
 TsTransportVtable_t ts_transport_mqtt = {
 
@@ -34,27 +49,60 @@ TsTransportVtable_t ts_transport_mqtt = {
 	.get_connection = ts_get_connection,
 
 	.dial = ts_dial,
+	.dial_start = ts_dial_start,
 	.hangup = ts_hangup,
 	.listen = ts_listen,
 	.speak = ts_speak,
+	.speak_qos = ts_speak_qos,
+	.speak_vector = ts_speak_vector,
+	.set_window = ts_set_window,
+	.set_ack_handler = ts_set_ack_handler,
+	.set_reconnect = ts_set_reconnect,
+	.get_reconnect_stats = ts_get_reconnect_stats,
+	.set_keepalive = ts_set_keepalive,
+	.get_keepalive_stats = ts_get_keepalive_stats,
+	.set_coalescing = ts_set_coalescing,
 
 };
 
 static int paho_mqtt_read( Network *, unsigned char *, int, int );
 static int paho_mqtt_write( Network *, unsigned char *, int, int );
+static int paho_mqtt_send( Network *, unsigned char *, int, uint32_t );
+static int paho_mqtt_flush( Network *, uint32_t );
 static void paho_mqtt_disconnect( Network * );
 static void paho_mqtt_callback( MessageData * );
+static void paho_mqtt_ack( MQTTClient *, unsigned short );
+static void paho_mqtt_suback( MQTTClient *, unsigned short, int );
+static void paho_mqtt_ping( MQTTClient *, int );
 
 static MQTTPacket_connectData default_connection = MQTTPacket_connectData_initializer;
 
-typedef struct TsTransportMqttHandler {
-	TsTransportHandler_t handler;
-	TsTransportRef_t transport;
-	void * data;
-} TsTransportMqttHandler_t;
-
-// TODO - there is only one handler - which forces only one listener and one transport of this type
-static TsTransportMqttHandler_t _default_handler = { NULL, NULL, NULL };
+// a subscription, i.e., a topic filter (possibly with '+' and '#' wildcards) and its handler
+typedef struct TsTransportMqttSubscription {
+	char _filter[ TS_TRANSPORT_MQTT_MAX_FILTER_SIZE ];
+	TsTransportHandler_t _handler;
+	void * _data;
+	unsigned short _id;				// the subscribe awaiting its suback, zero when none
+	uint64_t _sent;					// the last time the subscribe was sent (microseconds)
+	uint32_t _retries;
+} TsTransportMqttSubscription_t;
+
+// the dial progress, see ts_dial_start and ts_dial_advance
+typedef enum {
+	TsTransportMqttDialIdle = 0,		// not dialing, i.e., connected or disconnected
+	TsTransportMqttDialHandshake,		// the connection security handshake is in progress
+	TsTransportMqttDialConnack,			// the mqtt connect was sent, awaiting the connack
+} TsTransportMqttDial_t;
+
+// an unacknowledged qos1 publish, held for retransmission
+typedef struct TsTransportMqttInflight {
+	char * _path;
+	uint8_t * _payload;
+	size_t _payload_size;
+	unsigned short _id;
+	uint64_t _sent;					// the last time the message was sent (microseconds)
+	uint32_t _retries;
+} TsTransportMqttInflight_t;
 
 typedef struct TsTransportMqtt * TsTransportMqttRef_t;
 typedef struct TsTransportMqtt {
@@ -73,11 +121,346 @@ typedef struct TsTransportMqtt {
 	uint32_t _read_write_buffer_size;
 	char _id[TS_DRIVER_MAX_ID_SIZE];
 
-	// mqtt spec parameters
+	// non-blocking dial
+	TsTransportMqttDial_t _dial;
+	uint64_t _dial_timestamp;
+
+	// automatic reconnect, the address is empty when not dialed (or hung up)
+	char _address[ TS_TRANSPORT_MQTT_MAX_ADDRESS_SIZE ];
+	uint32_t _reconnect_min;		// zero when disabled
+	uint32_t _reconnect_max;
+	uint32_t _reconnect_failures;	// consecutive failed attempts
+	uint64_t _reconnect_at;			// the time of the next attempt
+	uint64_t _outage_start;			// zero when not reconnecting
+	TsTransportReconnectStats_t _reconnect_stats;
+
+	// keep-alive, adaptive when the maximum is greater than the interval
+	uint32_t _keepalive_max;		// seconds
+	uint64_t _ping_sent;			// the time the outstanding ping was sent, zero when none
+	uint64_t _rtt_total;
+	TsTransportKeepAliveStats_t _keepalive_stats;
+
+	// subscriptions, routed by topic filter
+	TsTransportMqttSubscription_t _subscriptions[ TS_TRANSPORT_MQTT_MAX_HANDLERS ];
+
+	// publish window, unused entries have a NULL path
+	TsTransportMqttInflight_t _inflight[ TS_TRANSPORT_MQTT_MAX_INFLIGHT ];
+	size_t _inflight_count;
+	size_t _window;
+	uint32_t _retransmit_timeout;
+	TsTransportAckHandler_t _ack_handler;
+	void * _ack_data;
+
+	// mqtt spec parameters, the qos is the default for subscriptions and speak
 	enum QoS _spec_qos;
 
 } TsTransportMqtt_t;
 
+static TsStatus_t ts_dial_connect( TsTransportMqttRef_t );
+
+static void ts_inflight_release( TsTransportMqttRef_t mqtt, TsTransportMqttInflight_t * entry ) {
+
+	ts_platform_free( entry->_path, strlen( entry->_path ) + 1 );
+	ts_platform_free( entry->_payload, entry->_payload_size > 0 ? entry->_payload_size : 1 );
+	memset( entry, 0x00, sizeof( TsTransportMqttInflight_t ));
+	mqtt->_inflight_count = mqtt->_inflight_count - 1;
+}
+
+static TsStatus_t ts_inflight_send( TsTransportMqttRef_t mqtt, TsTransportMqttInflight_t * entry, bool dup ) {
+
+	// the held payload is written as it is, i.e., it isn't copied to the write buffer
+	MQTTVector segment;
+	segment.data = entry->_payload;
+	segment.len = entry->_payload_size;
+
+	MQTTMessage message;
+	message.dup = dup ? 1 : 0;
+	message.id = entry->_id;
+	message.payload = NULL;
+	message.payloadlen = 0;
+	message.qos = QOS1;
+	message.retained = 0;
+	mqtt->_network._last_status = TsStatusOk;
+	int code = MQTTPublishVectorAsync( &( mqtt->_client ), (const char *) entry->_path, &message, &segment, 1 );
+	if( code != 0 ) {
+		ts_status_debug( "ts_inflight_send: failed due to mqtt error, %d\n", code );
+		return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+	}
+	entry->_id = message.id;
+	entry->_sent = ts_platform_time();
+	return TsStatusOk;
+}
+
+static void ts_inflight_retransmit( TsTransportMqttRef_t mqtt, bool all ) {
+
+	uint64_t timestamp = ts_platform_time();
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_INFLIGHT && mqtt->_client.isconnected; index++ ) {
+
+		TsTransportMqttInflight_t * entry = &( mqtt->_inflight[ index ] );
+		if( entry->_path == NULL || ( !all && timestamp - entry->_sent < mqtt->_retransmit_timeout )) {
+			continue;
+		}
+
+		// give up on messages that were never acknowledged
+		if( !all && entry->_retries >= TS_TRANSPORT_MQTT_MAX_RETRIES ) {
+			ts_status_alarm( "ts_inflight_retransmit: message %d to '%s' not acknowledged, dropping\n", entry->_id, entry->_path );
+			if( mqtt->_ack_handler != NULL ) {
+				mqtt->_ack_handler( (TsTransportRef_t) mqtt, mqtt->_ack_data, (TsPath_t) entry->_path, TsStatusErrorExceedTimeBudget );
+			}
+			ts_inflight_release( mqtt, entry );
+			continue;
+		}
+
+		ts_status_debug( "ts_inflight_retransmit: resending message %d to '%s'\n", entry->_id, entry->_path );
+		if( !all ) {
+			entry->_retries = entry->_retries + 1;
+		}
+		ts_inflight_send( mqtt, entry, entry->_id != 0 );
+	}
+}
+
+/**
+ * Send the subscribe without waiting for its suback (see paho_mqtt_suback), i.e., messages fall
+ * through to the default handler and are routed by the subscription table. A subscribe that fails
+ * to send stays pending, and is tried again by ts_subscribe_retransmit (or the next dial).
+ */
+static TsStatus_t ts_subscribe( TsTransportMqttRef_t mqtt, TsTransportMqttSubscription_t * subscription ) {
+
+	ts_status_debug( "ts_subscribe: listening to, '%s'\n", subscription->_filter );
+	mqtt->_network._last_status = TsStatusOk;
+	subscription->_sent = ts_platform_time();
+	int code = MQTTSubscribeAsync( &( mqtt->_client ), subscription->_filter, mqtt->_spec_qos, &( subscription->_id ));
+	if( code < 0 ) {
+		ts_status_debug( "ts_subscribe: failed due to mqtt error, %d\n", code );
+		return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+	}
+	return TsStatusOk;
+}
+
+/**
+ * Resend the subscribes whose suback is overdue, and give up on those never acknowledged.
+ */
+static void ts_subscribe_retransmit( TsTransportMqttRef_t mqtt ) {
+
+	uint64_t timestamp = ts_platform_time();
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_HANDLERS && mqtt->_client.isconnected; index++ ) {
+
+		TsTransportMqttSubscription_t * subscription = &( mqtt->_subscriptions[ index ] );
+		if( subscription->_handler == NULL || subscription->_id == 0 || timestamp - subscription->_sent < mqtt->_retransmit_timeout ) {
+			continue;
+		}
+		if( subscription->_retries >= TS_TRANSPORT_MQTT_MAX_RETRIES ) {
+			ts_status_alarm( "ts_subscribe_retransmit: subscribe to '%s' not acknowledged, dropping\n", subscription->_filter );
+			memset( subscription, 0x00, sizeof( TsTransportMqttSubscription_t ));
+			continue;
+		}
+		ts_status_debug( "ts_subscribe_retransmit: resending subscribe to '%s'\n", subscription->_filter );
+		subscription->_retries = subscription->_retries + 1;
+		ts_subscribe( mqtt, subscription );
+	}
+}
+
+/**
+ * Advance the dial begun by ts_dial_start, i.e., the security handshake, then the mqtt connect and
+ * its connack, within the given budget. Once connected, subscriptions made while dialing are sent
+ * and unacknowledged messages are retransmitted.
+ */
+static TsStatus_t ts_dial_advance( TsTransportMqttRef_t mqtt, uint32_t budget ) {
+
+	uint64_t timestamp = ts_platform_time();
+	TsStatus_t status;
+	int code;
+
+	switch( mqtt->_dial ) {
+	default:
+	case TsTransportMqttDialIdle:
+		return mqtt->_client.isconnected ? TsStatusOk : TsStatusErrorConnectionReset;
+
+	case TsTransportMqttDialHandshake:
+		status = ts_connection_handshake( mqtt->_transport._connection, budget );
+		if( status == TsStatusOkTrying ) {
+			return TsStatusOkTrying;
+		}
+		if( status != TsStatusOk ) {
+			ts_status_debug( "ts_transport_dial: TLS handshake failed\n" );
+			mqtt->_dial = TsTransportMqttDialIdle;
+			return status;
+		}
+		ts_status_debug( "ts_transport_dial: connected to server\n" );
+
+		mqtt->_network._last_status = TsStatusOk;
+		code = MQTTConnectAsync( &( mqtt->_client ), &( mqtt->_connection ));
+		if( code < 0 ) {
+			ts_status_debug( "ts_transport_dial: failed due to mqtt error, %d\n", code );
+			ts_connection_disconnect( mqtt->_transport._connection );
+			mqtt->_dial = TsTransportMqttDialIdle;
+			return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+		}
+		mqtt->_dial = TsTransportMqttDialConnack;
+		mqtt->_dial_timestamp = ts_platform_time();
+		// fallthrough
+
+	case TsTransportMqttDialConnack: {
+
+		// wait for the connack with whatever budget remains
+		uint64_t elapsed = ts_platform_time() - timestamp;
+		uint32_t remaining = ( elapsed < budget ) ? (uint32_t) ( budget - elapsed ) : 0;
+		MQTTConnackData connack = { 0, 0 };
+		mqtt->_network._last_status = TsStatusOk;
+		code = MQTTConnectPoll( &( mqtt->_client ), (int) ( remaining / TS_TIME_MSEC_TO_USEC ), &connack );
+		if( code < 0 ) {
+			ts_status_debug( "ts_transport_dial: failed due to mqtt error, %d, connack %d\n", code, connack.rc );
+			ts_connection_disconnect( mqtt->_transport._connection );
+			mqtt->_dial = TsTransportMqttDialIdle;
+			return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+		}
+		if( !( mqtt->_client.isconnected )) {
+			if( ts_platform_time() - mqtt->_dial_timestamp > (uint64_t) mqtt->_client.command_timeout_ms * TS_TIME_MSEC_TO_USEC ) {
+				ts_status_debug( "ts_transport_dial: failed, connack not received\n" );
+				ts_connection_disconnect( mqtt->_transport._connection );
+				mqtt->_dial = TsTransportMqttDialIdle;
+				return TsStatusErrorExceedTimeBudget;
+			}
+			return TsStatusOkTrying;
+		}
+		mqtt->_dial = TsTransportMqttDialIdle;
+		break;
+	}
+	}
+
+	// the connect negotiated the maximum (adaptive) interval, ping at the one being probed
+	mqtt->_ping_sent = 0;
+	if( mqtt->_keepalive_max > 0 ) {
+		mqtt->_client.keepAliveInterval = mqtt->_keepalive_stats.interval;
+		TimerCountdown( &( mqtt->_client.last_sent ), mqtt->_client.keepAliveInterval );
+	}
+
+	// subscribe to the paths listened to while dialing (or before a previous hangup), the subacks
+	// arrive with later ticks, and a subscribe that cannot be sent loses the new connection
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_HANDLERS; index++ ) {
+		TsTransportMqttSubscription_t * subscription = &( mqtt->_subscriptions[ index ] );
+		if( subscription->_handler == NULL ) {
+			continue;
+		}
+		subscription->_retries = 0;
+		status = ts_subscribe( mqtt, subscription );
+		if( status != TsStatusOk ) {
+			ts_status_alarm( "ts_transport_dial: failed to subscribe to, '%s', %s\n", subscription->_filter, ts_status_string( status ));
+			ts_connection_disconnect( mqtt->_transport._connection );
+			return status;
+		}
+	}
+
+	// the session is persistent, so messages unacknowledged by the last connection are sent again
+	ts_inflight_retransmit( mqtt, true );
+
+	return TsStatusOk;
+}
+
+/**
+ * Schedule the next reconnect attempt, i.e., the backoff doubles with each consecutive failure
+ * (up to the maximum), and is randomized over its upper half so that devices losing the broker
+ * at the same time don't return at the same time.
+ */
+static void ts_reconnect_schedule( TsTransportMqttRef_t mqtt ) {
+
+	uint64_t timestamp = ts_platform_time();
+	if( mqtt->_outage_start == 0 ) {
+		mqtt->_outage_start = timestamp;
+		mqtt->_reconnect_failures = 0;
+		mqtt->_reconnect_stats.outages = mqtt->_reconnect_stats.outages + 1;
+	} else {
+		mqtt->_reconnect_failures = mqtt->_reconnect_failures + 1;
+	}
+
+	uint64_t backoff = mqtt->_reconnect_min;
+	for( uint32_t index = 0; index < mqtt->_reconnect_failures && backoff < mqtt->_reconnect_max; index++ ) {
+		backoff = backoff * 2;
+	}
+	if( backoff > mqtt->_reconnect_max ) {
+		backoff = mqtt->_reconnect_max;
+	}
+	uint32_t random;
+	ts_platform_random( &random );
+	backoff = backoff / 2 + random % ( backoff / 2 + 1 );
+
+	ts_status_info( "ts_transport_tick: reconnecting in %u msec\n", (uint32_t) ( backoff / TS_TIME_MSEC_TO_USEC ));
+	mqtt->_reconnect_stats.backoff = (uint32_t) backoff;
+	mqtt->_reconnect_at = timestamp + backoff;
+}
+
+/**
+ * Record the end of an outage once the reconnect dial completes.
+ */
+static void ts_reconnect_complete( TsTransportMqttRef_t mqtt ) {
+
+	if( mqtt->_outage_start == 0 ) {
+		return;
+	}
+	uint64_t outage = ts_platform_time() - mqtt->_outage_start;
+	ts_status_info( "ts_transport_tick: reconnected after %u msec\n", (uint32_t) ( outage / TS_TIME_MSEC_TO_USEC ));
+	mqtt->_reconnect_stats.reconnects = mqtt->_reconnect_stats.reconnects + 1;
+	mqtt->_reconnect_stats.outage = outage;
+	mqtt->_reconnect_stats.outage_total = mqtt->_reconnect_stats.outage_total + outage;
+	if( outage > mqtt->_reconnect_stats.outage_max ) {
+		mqtt->_reconnect_stats.outage_max = outage;
+	}
+	mqtt->_outage_start = 0;
+	mqtt->_reconnect_failures = 0;
+}
+
+static bool ts_reconnect_enabled( TsTransportMqttRef_t mqtt ) {
+	return mqtt->_reconnect_min > 0 && mqtt->_address[ 0 ] != '\0';
+}
+
+/**
+ * Save (or restore) the learned keep-alive interval, when built with TS_TRANSPORT_MQTT_KEEPALIVE_FILE.
+ */
+static void ts_keepalive_persist( TsTransportMqttRef_t mqtt, bool save ) {
+
+#if defined( TS_TRANSPORT_MQTT_KEEPALIVE_FILE )
+	uint32_t record[ 2 ] = { mqtt->_keepalive_stats.learned, mqtt->_keepalive_stats.converged ? 1 : 0 };
+	ts_file_handle handle;
+	if( ts_file_open( &handle, TS_TRANSPORT_MQTT_KEEPALIVE_FILE, save ? TS_FILE_OPEN_FOR_WRITE : TS_FILE_OPEN_FOR_READ ) != TsStatusOk ) {
+		ts_status_debug( "ts_keepalive_persist: cannot open, '%s'\n", TS_TRANSPORT_MQTT_KEEPALIVE_FILE );
+		return;
+	}
+	if( save ) {
+		ts_file_write( &handle, record, sizeof( record ));
+	} else {
+		uint32_t size = 0;
+		if( ts_file_read( &handle, record, sizeof( record ), &size ) == TsStatusOk && size == sizeof( record )) {
+			// only an interval within the current bounds is used
+			if( record[ 0 ] >= mqtt->_keepalive_stats.interval && record[ 0 ] <= mqtt->_keepalive_max ) {
+				mqtt->_keepalive_stats.learned = record[ 0 ];
+				mqtt->_keepalive_stats.interval = record[ 0 ];
+				mqtt->_keepalive_stats.converged = ( record[ 1 ] != 0 );
+			}
+		}
+	}
+	ts_file_close( &handle );
+#endif
+}
+
+/**
+ * Record an unanswered ping, i.e., the connection was lost while waiting for the response. In the
+ * adaptive mode, the probing stops at the longest interval answered so far.
+ */
+static void ts_keepalive_lost( TsTransportMqttRef_t mqtt ) {
+
+	mqtt->_ping_sent = 0;
+	mqtt->_keepalive_stats.timeouts = mqtt->_keepalive_stats.timeouts + 1;
+	if( mqtt->_keepalive_max == 0 || mqtt->_keepalive_stats.converged ) {
+		return;
+	}
+	if( mqtt->_keepalive_stats.learned > 0 ) {
+		mqtt->_keepalive_stats.interval = mqtt->_keepalive_stats.learned;
+	}
+	mqtt->_keepalive_stats.converged = true;
+	ts_status_info( "ts_transport_tick: keep-alive settled at %u seconds\n", mqtt->_keepalive_stats.interval );
+	ts_keepalive_persist( mqtt, true );
+}
+
 static TsStatus_t ts_create( TsTransportRef_t * transport ) {
 
 	ts_status_trace( "ts_transport_create: mqtt\n" );
@@ -95,9 +478,36 @@ static TsStatus_t ts_create( TsTransportRef_t * transport ) {
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) ( ts_platform_malloc( sizeof( TsTransportMqtt_t )));
 	*transport = (TsTransportRef_t) mqtt;
 
-	// NOTE - the transport attribute, "handler" isn't used due to
-	// (poort) paho design, we have to use a local static variable,
-	// i.e., '_default_handler'.
+	mqtt->_dial = TsTransportMqttDialIdle;
+	mqtt->_dial_timestamp = 0;
+
+	// reconnect automatically by default
+	memset( mqtt->_address, 0x00, sizeof( mqtt->_address ));
+	mqtt->_reconnect_min = TS_TRANSPORT_MQTT_RECONNECT_MIN_BACKOFF;
+	mqtt->_reconnect_max = TS_TRANSPORT_MQTT_RECONNECT_MAX_BACKOFF;
+	mqtt->_reconnect_failures = 0;
+	mqtt->_reconnect_at = 0;
+	mqtt->_outage_start = 0;
+	memset( &( mqtt->_reconnect_stats ), 0x00, sizeof( TsTransportReconnectStats_t ));
+
+	// a fixed keep-alive by default (see ts_set_keepalive)
+	mqtt->_keepalive_max = 0;
+	mqtt->_ping_sent = 0;
+	mqtt->_rtt_total = 0;
+	memset( &( mqtt->_keepalive_stats ), 0x00, sizeof( TsTransportKeepAliveStats_t ));
+	mqtt->_keepalive_stats.interval = TS_TRANSPORT_MQTT_KEEPALIVE;
+
+	// NOTE - the transport attribute, "handler" isn't used, incoming
+	// messages are routed via the subscription table instead.
+	memset( mqtt->_subscriptions, 0x00, sizeof( mqtt->_subscriptions ));
+
+	// publishes are pipelined up to the window size
+	memset( mqtt->_inflight, 0x00, sizeof( mqtt->_inflight ));
+	mqtt->_inflight_count = 0;
+	mqtt->_window = TS_TRANSPORT_MQTT_DEFAULT_WINDOW;
+	mqtt->_retransmit_timeout = TS_TRANSPORT_MQTT_RETRANSMIT_TIMEOUT;
+	mqtt->_ack_handler = NULL;
+	mqtt->_ack_data = NULL;
 
 	mqtt->_transport._connection = connection;
 	mqtt->_network._connection = connection;
@@ -119,7 +529,7 @@ static TsStatus_t ts_create( TsTransportRef_t * transport ) {
 	mqtt->_connection.clientID.cstring = mqtt->_id; // client-id is the device-id
 	mqtt->_connection.username.cstring = NULL;      // not used
 	mqtt->_connection.password.cstring = NULL;      // not used
-	mqtt->_connection.keepAliveInterval = 60;       // keep-alive is 60 seconds
+	mqtt->_connection.keepAliveInterval = TS_TRANSPORT_MQTT_KEEPALIVE;
 	mqtt->_connection.cleansession = 0;             // no clean-session
 
 	// initialize mqtt intermediate buffers
@@ -134,6 +544,17 @@ static TsStatus_t ts_create( TsTransportRef_t * transport ) {
 		return TsStatusErrorOutOfMemory;
 	}
 	mqtt->_read_write_buffer_size = mtu;
+	mqtt->_network._rx_buffer = ts_platform_malloc( mtu );
+	if (mqtt->_network._rx_buffer == NULL) {
+		ts_status_alarm("ts_transport_create: could not allocate receive buffer\n");
+		return TsStatusErrorOutOfMemory;
+	}
+	mqtt->_network._rx_buffer_size = mtu;
+	mqtt->_network._rx_index = 0;
+	mqtt->_network._rx_count = 0;
+	mqtt->_network._tx_buffer = NULL;
+	mqtt->_network._tx_buffer_size = 0;
+	mqtt->_network._tx_count = 0;
 
 	// initialize mqtt spec parameters
 	mqtt->_spec_qos = QOS1;
@@ -149,6 +570,13 @@ static TsStatus_t ts_create( TsTransportRef_t * transport ) {
 		mqtt->_read_write_buffer_size
 	);
 
+	// all messages are delivered via the default handler, and
+	// routed by the subscription table (see ts_listen)
+	mqtt->_client.defaultMessageHandler = paho_mqtt_callback;
+	mqtt->_client.publishAckHandler = paho_mqtt_ack;
+	mqtt->_client.subscribeAckHandler = paho_mqtt_suback;
+	mqtt->_client.pingHandler = paho_mqtt_ping;
+
 	return TsStatusOk;
 }
 
@@ -159,9 +587,20 @@ static TsStatus_t ts_destroy( TsTransportRef_t transport ) {
 
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
 
+	// unacknowledged messages are discarded
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_INFLIGHT; index++ ) {
+		if( mqtt->_inflight[ index ]._path != NULL ) {
+			ts_inflight_release( mqtt, &( mqtt->_inflight[ index ] ));
+		}
+	}
+
 	ts_connection_destroy( mqtt->_transport._connection );
 	ts_platform_free( mqtt->_read_buffer, mqtt->_read_write_buffer_size );
 	ts_platform_free( mqtt->_write_buffer, mqtt->_read_write_buffer_size );
+	ts_platform_free( mqtt->_network._rx_buffer, mqtt->_network._rx_buffer_size );
+	if( mqtt->_network._tx_buffer != NULL ) {
+		ts_platform_free( mqtt->_network._tx_buffer, mqtt->_network._tx_buffer_size );
+	}
 	ts_platform_free( mqtt, sizeof( TsTransportMqtt_t ));
 
 	return TsStatusOk;
@@ -171,23 +610,89 @@ static TsStatus_t ts_tick( TsTransportRef_t transport, uint32_t budget ) {
 
 	ts_status_debug( "ts_transport_tick\n" );
 	ts_platform_assert( transport != NULL );
-	ts_platform_assert( budget > 0 );
 
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
 	uint64_t timestamp = ts_platform_time();
 
+	// nothing can be done without a budget, i.e., report the state as is
+	if( budget == 0 ) {
+		if( mqtt->_dial != TsTransportMqttDialIdle || ( !( mqtt->_client.isconnected ) && ts_reconnect_enabled( mqtt ))) {
+			return TsStatusOkTrying;
+		}
+		return mqtt->_client.isconnected ? TsStatusOk : TsStatusErrorConnectionReset;
+	}
+
 	// provide connection tick
 	ts_connection_tick( mqtt->_transport._connection, budget );
 
+	// a connection lost while a ping was outstanding, i.e., the keep-alive was too long
+	if( !( mqtt->_client.isconnected ) && mqtt->_ping_sent != 0 ) {
+		ts_keepalive_lost( mqtt );
+	}
+
+	// advance a dial in progress, the remaining budget (if any) goes to the connection
+	if( mqtt->_dial != TsTransportMqttDialIdle ) {
+		TsStatus_t status = ts_dial_advance( mqtt, budget );
+		if( status == TsStatusOk ) {
+			ts_reconnect_complete( mqtt );
+		} else if( status != TsStatusOkTrying && ts_reconnect_enabled( mqtt )) {
+			ts_status_alarm( "ts_transport_tick: dial failed, %s\n", ts_status_string( status ));
+			ts_reconnect_schedule( mqtt );
+			return TsStatusOkTrying;
+		} else {
+			return status;
+		}
+	}
+
+	// reconnect when the connection was lost, after a backoff
+	if( !( mqtt->_client.isconnected ) && ts_reconnect_enabled( mqtt )) {
+		if( mqtt->_outage_start == 0 ) {
+			ts_status_alarm( "ts_transport_tick: connection lost.\n" );
+			ts_connection_disconnect( mqtt->_transport._connection );
+			ts_reconnect_schedule( mqtt );
+		}
+		if( ts_platform_time() >= mqtt->_reconnect_at ) {
+			mqtt->_reconnect_stats.attempts = mqtt->_reconnect_stats.attempts + 1;
+			if( ts_dial_connect( mqtt ) != TsStatusOkTrying ) {
+				ts_reconnect_schedule( mqtt );
+			}
+		}
+		return TsStatusOkTrying;
+	}
+
 	// provide mqtt tick
-	if(( mqtt->_client.isconnected ) && ( ts_platform_time() - timestamp < budget )) {
-		int code = MQTTYield( &( mqtt->_client ), budget/TS_TIME_MSEC_TO_USEC );
+	if( !( mqtt->_client.isconnected )) {
+		ts_status_alarm( "ts_transport_tick: not connected.\n" );
+		return TsStatusErrorConnectionReset;
+	}
+	uint64_t elapsed = ts_platform_time() - timestamp;
+	if( elapsed < budget ) {
+		int code = MQTTYield( &( mqtt->_client ), (int) (( budget - elapsed )/TS_TIME_MSEC_TO_USEC ));
 		if( code != 0 ) {
 			ts_status_alarm( "ts_transport_tick: mqtt yield failed, %d, ignoring,...\n", code );
 		}
-	} else {
-		ts_status_alarm( "ts_transport_tick: not connected.\n" );
-		return TsStatusErrorConnectionReset;
+	}
+
+	// resend messages (and subscribes) whose acknowledgement is overdue
+	ts_inflight_retransmit( mqtt, false );
+	ts_subscribe_retransmit( mqtt );
+
+	// write the packets merged during this tick (if any), a failed write loses the connection
+	// (as a failed read does in yield), i.e., reconnect when enabled
+	if( paho_mqtt_flush( &( mqtt->_network ), budget ) < 0 ) {
+		ts_status_alarm( "ts_transport_tick: write failed, %s\n", ts_status_string( mqtt->_network._last_status ));
+		mqtt->_client.isconnected = 0;
+		mqtt->_client.ping_outstanding = 0;
+		if( mqtt->_ping_sent != 0 ) {
+			ts_keepalive_lost( mqtt );
+		}
+		if( !ts_reconnect_enabled( mqtt )) {
+			return TsStatusErrorConnectionReset;
+		}
+		ts_status_alarm( "ts_transport_tick: connection lost.\n" );
+		ts_connection_disconnect( mqtt->_transport._connection );
+		ts_reconnect_schedule( mqtt );
+		return TsStatusOkTrying;
 	}
 
 	// report budget status and return
@@ -224,31 +729,61 @@ static TsStatus_t ts_dial( TsTransportRef_t transport, TsAddress_t address ) {
 
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
 
-	if( mqtt->_client.isconnected ) {
+	// advance the dial until connected, each step gives up on its own timeout
+	TsStatus_t status = ts_dial_start( transport, address );
+	while( status == TsStatusOkTrying ) {
+		status = ts_dial_advance( mqtt, TS_TIME_SEC_TO_USEC );
+	}
+	return status;
+}
+
+/**
+ * Dial without blocking for the connection, see ts_dial_advance.
+ * @param transport
+ * @param address
+ * @return
+ */
+static TsStatus_t ts_dial_start( TsTransportRef_t transport, TsAddress_t address ) {
+
+	ts_status_trace( "ts_transport_dial_start\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	if( mqtt->_client.isconnected || mqtt->_dial != TsTransportMqttDialIdle ) {
 		ts_status_debug( "ts_transport_dial: failed, mqtt already connected\n" );
 		return TsStatusErrorPreconditionFailed;
 	}
+	if( strlen( address ) >= TS_TRANSPORT_MQTT_MAX_ADDRESS_SIZE ) {
+		ts_status_debug( "ts_transport_dial: failed, address too long\n" );
+		return TsStatusErrorPreconditionFailed;
+	}
 
-	// NOTE - the transport attribute, "handler" isn't used due to
-	// (poor) paho design, we have to use a local static variable,
-	// i.e., '_default_handler'.
+	// remember the address for reconnecting, a new dial isn't an outage
+	snprintf( mqtt->_address, TS_TRANSPORT_MQTT_MAX_ADDRESS_SIZE, "%s", address );
+	mqtt->_outage_start = 0;
+	return ts_dial_connect( mqtt );
+}
+
+static TsStatus_t ts_dial_connect( TsTransportMqttRef_t mqtt ) {
+
+	const char * address = mqtt->_address;
+
+	// bytes buffered from a previous connection are stale
+	mqtt->_network._rx_index = 0;
+	mqtt->_network._rx_count = 0;
+	mqtt->_network._tx_count = 0;
+
+	// note that the controller tcp/ip connect is made here, only the handshake is divided
 	ts_status_debug( "ts_transport_dial: connecting to, '%s'\n", address );
-	TsStatus_t status = ts_connection_connect( mqtt->_transport._connection, address );
-	if( status != TsStatusOk ) {
-		ts_status_debug("ts_transport_dial: TLS handshake failed\n");
+	TsStatus_t status = ts_connection_connect_start( mqtt->_transport._connection, address );
+	if( status != TsStatusOk && status != TsStatusOkTrying ) {
+		ts_status_debug( "ts_transport_dial: connect failed\n" );
 		return status;
 	}
-	ts_status_debug( "ts_transport_dial: connected to server\n" );
-
-	mqtt->_network._last_status = TsStatusOk;
-	int code = MQTTConnect( &( mqtt->_client ), &( mqtt->_connection ));
-	if( code < 0 ) {
-		ts_status_debug( "ts_transport_dial: failed due to mqtt error, %d\n", code );
-		ts_connection_disconnect( mqtt->_transport._connection );
-		return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
-	}
+	mqtt->_dial = TsTransportMqttDialHandshake;
 
-	return TsStatusOk;
+	return TsStatusOkTrying;
 }
 
 static TsStatus_t ts_hangup( TsTransportRef_t transport ) {
@@ -258,16 +793,29 @@ static TsStatus_t ts_hangup( TsTransportRef_t transport ) {
 
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
 
-	MQTTDisconnect( &( mqtt->_client ));
+	// an abandoned dial has no mqtt session to disconnect
+	if( mqtt->_dial == TsTransportMqttDialIdle ) {
+		MQTTDisconnect( &( mqtt->_client ));
+		paho_mqtt_flush( &( mqtt->_network ), TS_TIME_SEC_TO_USEC );
+	}
+	mqtt->_network._tx_count = 0;
+	mqtt->_dial = TsTransportMqttDialIdle;
 	ts_connection_disconnect( mqtt->_transport._connection );
 
+	// stop reconnecting until the next dial
+	memset( mqtt->_address, 0x00, sizeof( mqtt->_address ));
+	mqtt->_outage_start = 0;
+	mqtt->_ping_sent = 0;
+
 	return TsStatusOk;
 }
 
 /**
  * Listen will subscribe to a particular path and deliver messages to the caller via the given handler. Note
  * that this transport doesnt have a sense of "listen" without dialing first (i.e., server), so the address
- * parameters is ignored.
+ * parameters is ignored. Listen may be called for up to TS_TRANSPORT_MQTT_MAX_HANDLERS paths, each with its
+ * own handler; the path is an MQTT topic filter and may contain '+' and '#' wildcards. Listening to a path
+ * already listened to replaces its handler. Listening while dialing (or reconnecting) subscribes once connected.
  * @param transport
  * @param address
  * Ignored for MQTT, NULL is a valid value.
@@ -279,30 +827,51 @@ static TsStatus_t ts_listen( TsTransportRef_t transport, TsAddress_t address, Ts
 
 	ts_status_debug( "ts_transport_listen\n" );
 	ts_platform_assert( transport != NULL );
+	ts_platform_assert( path != NULL );
+	ts_platform_assert( handler != NULL );
 
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
 
-	if( !( mqtt->_client.isconnected )) {
+	bool reconnecting = ts_reconnect_enabled( mqtt ) && mqtt->_outage_start != 0;
+	if( !( mqtt->_client.isconnected ) && mqtt->_dial == TsTransportMqttDialIdle && !reconnecting ) {
 		ts_status_debug( "ts_transport_listen: failed, mqtt not connected\n" );
 		return TsStatusErrorPreconditionFailed;
 	}
+	if( strlen( path ) >= TS_TRANSPORT_MQTT_MAX_FILTER_SIZE ) {
+		ts_status_debug( "ts_transport_listen: failed, path too long, '%s'\n", path );
+		return TsStatusErrorPayloadTooLarge;
+	}
 
-	// TODO - change so that we can target a handler by address and path
-	// NOTE - the transport attribute, "handler" isn't used due to
-	// (poor) paho design, we have to use a local static variable,
-	// i.e., '_default_handler'.
-	_default_handler.transport = transport;
-	_default_handler.handler = handler;
-	_default_handler.data = handler_data;
+	// find the existing subscription, or else an unused one
+	TsTransportMqttSubscription_t * subscription = NULL;
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_HANDLERS; index++ ) {
+		TsTransportMqttSubscription_t * candidate = &( mqtt->_subscriptions[ index ] );
+		if( candidate->_handler != NULL && strcmp( candidate->_filter, path ) == 0 ) {
+			subscription = candidate;
+			break;
+		}
+		if( candidate->_handler == NULL && subscription == NULL ) {
+			subscription = candidate;
+		}
+	}
+	if( subscription == NULL ) {
+		ts_status_debug( "ts_transport_listen: failed, no more subscriptions available\n" );
+		return TsStatusErrorNoResourceAvailable;
+	}
 
-	// subscribe
-	ts_status_debug( "ts_transport_listen: listening to, '%s'\n", path );
-	mqtt->_network._last_status = TsStatusOk;
-	int code = MQTTSubscribe( &( mqtt->_client ), (char *) path, mqtt->_spec_qos, paho_mqtt_callback );
-	if( code < 0 ) {
-		ts_status_debug( "ts_transport_listen: failed due to mqtt error, %d\n", code );
-		return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+	// subscribe now, or once the dial completes
+	snprintf( subscription->_filter, TS_TRANSPORT_MQTT_MAX_FILTER_SIZE, "%s", path );
+	subscription->_retries = 0;
+	if( mqtt->_client.isconnected ) {
+		TsStatus_t status = ts_subscribe( mqtt, subscription );
+		if( status != TsStatusOk ) {
+			memset( subscription, 0x00, sizeof( TsTransportMqttSubscription_t ));
+			return status;
+		}
 	}
+	subscription->_handler = handler;
+	subscription->_data = handler_data;
+
 	return TsStatusOk;
 }
 
@@ -312,24 +881,245 @@ static TsStatus_t ts_speak( TsTransportRef_t transport, TsPath_t path, const uin
 	ts_platform_assert( transport != NULL );
 
 	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+	return ts_speak_qos( transport, path, buffer, buffer_size, mqtt->_spec_qos == QOS0 ? TsTransportQos0 : TsTransportQos1 );
+}
 
-	if( !( mqtt->_client.isconnected )) {
+static TsStatus_t ts_speak_qos( TsTransportRef_t transport, TsPath_t path, const uint8_t * buffer, size_t buffer_size, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_transport_speak_qos\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportSegment_t segment;
+	segment.buffer = buffer;
+	segment.buffer_size = buffer_size;
+	return ts_speak_vector( transport, path, &segment, 1, qos );
+}
+
+static TsStatus_t ts_speak_vector( TsTransportRef_t transport, TsPath_t path, const TsTransportSegment_t * segments, size_t count, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_transport_speak_vector\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( segments != NULL || count == 0 );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	if( count > TS_TRANSPORT_MQTT_MAX_SEGMENTS ) {
+		ts_status_debug( "ts_transport_speak_vector: failed, more than %d segments\n", TS_TRANSPORT_MQTT_MAX_SEGMENTS );
+		return TsStatusErrorIndexOutOfRange;
+	}
+	size_t buffer_size = 0;
+	for( size_t index = 0; index < count; index++ ) {
+		buffer_size = buffer_size + segments[ index ].buffer_size;
+	}
+
+	// qos1 messages are held while reconnecting, and sent once connected
+	bool reconnecting = ts_reconnect_enabled( mqtt ) && ( mqtt->_outage_start != 0 || mqtt->_dial != TsTransportMqttDialIdle );
+	if( !( mqtt->_client.isconnected ) && !( reconnecting && qos == TsTransportQos1 )) {
 		ts_status_debug( "ts_transport_speak: failed, mqtt not connected\n" );
 		return TsStatusErrorPreconditionFailed;
 	}
 
-	MQTTMessage message;
-	message.dup = 0;
-	message.id = 0;
-	message.payload = (void *) buffer;
-	message.payloadlen = buffer_size;
-	message.qos = mqtt->_spec_qos;
-	message.retained = 0;
-	mqtt->_network._last_status = TsStatusOk;
-	int code = MQTTPublish( &( mqtt->_client ), (const char *) path, &message );
-	if( code != 0 ) {
-		ts_status_debug( "ts_speak: failed due to mqtt error, %d\n", code );
-		return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+	// qos0 is fire-and-forget, there is no acknowledgement to wait for
+	if( qos == TsTransportQos0 ) {
+		MQTTVector vector[ TS_TRANSPORT_MQTT_MAX_SEGMENTS ];
+		for( size_t index = 0; index < count; index++ ) {
+			vector[ index ].data = segments[ index ].buffer;
+			vector[ index ].len = segments[ index ].buffer_size;
+		}
+		MQTTMessage message;
+		message.dup = 0;
+		message.id = 0;
+		message.payload = NULL;
+		message.payloadlen = 0;
+		message.qos = QOS0;
+		message.retained = 0;
+		mqtt->_network._last_status = TsStatusOk;
+		int code = MQTTPublishVectorAsync( &( mqtt->_client ), (const char *) path, &message, vector, (int) count );
+		if( code != 0 ) {
+			ts_status_debug( "ts_speak: failed due to mqtt error, %d\n", code );
+			return mqtt->_network._last_status == TsStatusOk ? TsStatusErrorInternalServerError : mqtt->_network._last_status;
+		}
+		return TsStatusOk;
+	}
+
+	// refuse the message while the window is full, i.e., the acknowledgements that open it
+	// (and the retransmissions) are driven by tick, never waited for here
+	if( mqtt->_inflight_count >= mqtt->_window ) {
+		ts_status_debug( "ts_speak: failed, %d messages awaiting acknowledgement\n", mqtt->_inflight_count );
+		return mqtt->_client.isconnected ? TsStatusErrorNoResourceAvailable : TsStatusErrorConnectionReset;
+	}
+
+	// gather the message, it's held until acknowledged
+	TsTransportMqttInflight_t * entry = NULL;
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_INFLIGHT && entry == NULL; index++ ) {
+		if( mqtt->_inflight[ index ]._path == NULL ) {
+			entry = &( mqtt->_inflight[ index ] );
+		}
+	}
+	ts_platform_assert( entry != NULL );
+	size_t path_size = strlen( path ) + 1;
+	entry->_path = (char *) ts_platform_malloc( path_size );
+	entry->_payload = (uint8_t *) ts_platform_malloc( buffer_size > 0 ? buffer_size : 1 );
+	if( entry->_path == NULL || entry->_payload == NULL ) {
+		if( entry->_path != NULL ) {
+			ts_platform_free( entry->_path, path_size );
+		}
+		if( entry->_payload != NULL ) {
+			ts_platform_free( entry->_payload, buffer_size > 0 ? buffer_size : 1 );
+		}
+		memset( entry, 0x00, sizeof( TsTransportMqttInflight_t ));
+		return TsStatusErrorOutOfMemory;
+	}
+	memcpy( entry->_path, path, path_size );
+	size_t offset = 0;
+	for( size_t index = 0; index < count; index++ ) {
+		memcpy( entry->_payload + offset, segments[ index ].buffer, segments[ index ].buffer_size );
+		offset = offset + segments[ index ].buffer_size;
+	}
+	entry->_payload_size = buffer_size;
+	entry->_retries = 0;
+	mqtt->_inflight_count = mqtt->_inflight_count + 1;
+
+	// send without waiting for the acknowledgement
+	if( !( mqtt->_client.isconnected )) {
+		entry->_id = 0;
+		return TsStatusOk;
+	}
+	TsStatus_t status = ts_inflight_send( mqtt, entry, false );
+	if( status != TsStatusOk ) {
+		ts_inflight_release( mqtt, entry );
+		return status;
+	}
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_set_window( TsTransportRef_t transport, size_t window, uint32_t timeout ) {
+
+	ts_status_trace( "ts_transport_set_window\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	if( window < 1 || window > TS_TRANSPORT_MQTT_MAX_INFLIGHT ) {
+		ts_status_debug( "ts_transport_set_window: failed, window must be from 1 to %d\n", TS_TRANSPORT_MQTT_MAX_INFLIGHT );
+		return TsStatusErrorIndexOutOfRange;
+	}
+	mqtt->_window = window;
+	mqtt->_retransmit_timeout = ( timeout == 0 ) ? TS_TRANSPORT_MQTT_RETRANSMIT_TIMEOUT : timeout;
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_set_ack_handler( TsTransportRef_t transport, TsTransportAckHandler_t handler, void * handler_data ) {
+
+	ts_status_trace( "ts_transport_set_ack_handler\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+	mqtt->_ack_handler = handler;
+	mqtt->_ack_data = handler_data;
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_set_reconnect( TsTransportRef_t transport, uint32_t min_backoff, uint32_t max_backoff ) {
+
+	ts_status_trace( "ts_transport_set_reconnect\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	if( min_backoff > 0 && max_backoff < min_backoff ) {
+		ts_status_debug( "ts_transport_set_reconnect: failed, maximum backoff is less than the minimum\n" );
+		return TsStatusErrorPreconditionFailed;
+	}
+	mqtt->_reconnect_min = min_backoff;
+	mqtt->_reconnect_max = max_backoff;
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_get_reconnect_stats( TsTransportRef_t transport, TsTransportReconnectStats_t * stats ) {
+
+	ts_status_trace( "ts_transport_get_reconnect_stats\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	memcpy( stats, &( mqtt->_reconnect_stats ), sizeof( TsTransportReconnectStats_t ));
+	if( mqtt->_outage_start != 0 ) {
+		stats->outage = ts_platform_time() - mqtt->_outage_start;
+	}
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_set_keepalive( TsTransportRef_t transport, uint32_t interval, uint32_t max_interval ) {
+
+	ts_status_trace( "ts_transport_set_keepalive\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	if( interval == 0 || interval > TS_TRANSPORT_MQTT_MAX_KEEPALIVE || max_interval > TS_TRANSPORT_MQTT_MAX_KEEPALIVE ) {
+		ts_status_debug( "ts_transport_set_keepalive: failed, interval must be from 1 to %d seconds\n", TS_TRANSPORT_MQTT_MAX_KEEPALIVE );
+		return TsStatusErrorIndexOutOfRange;
+	}
+
+	// the connect negotiates the maximum, the client pings at the (probed) interval
+	mqtt->_keepalive_max = ( max_interval > interval ) ? max_interval : 0;
+	mqtt->_keepalive_stats.interval = interval;
+	mqtt->_keepalive_stats.learned = 0;
+	mqtt->_keepalive_stats.converged = ( mqtt->_keepalive_max == 0 );
+	if( mqtt->_keepalive_max > 0 ) {
+		ts_keepalive_persist( mqtt, false );
+	}
+	mqtt->_connection.keepAliveInterval = (unsigned short) (( mqtt->_keepalive_max > 0 ) ? mqtt->_keepalive_max : interval );
+	mqtt->_client.keepAliveSendOnly = ( mqtt->_keepalive_max > 0 ) ? 1 : 0;
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_get_keepalive_stats( TsTransportRef_t transport, TsTransportKeepAliveStats_t * stats ) {
+
+	ts_status_trace( "ts_transport_get_keepalive_stats\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( stats != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+
+	memcpy( stats, &( mqtt->_keepalive_stats ), sizeof( TsTransportKeepAliveStats_t ));
+	if( stats->pings > 0 ) {
+		stats->rtt_avg = (uint32_t) ( mqtt->_rtt_total / stats->pings );
+	}
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_set_coalescing( TsTransportRef_t transport, bool enable ) {
+
+	ts_status_trace( "ts_transport_set_coalescing\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) transport;
+	Network * network = &( mqtt->_network );
+
+	if( enable && network->_tx_buffer == NULL ) {
+		network->_tx_buffer = ts_platform_malloc( mqtt->_read_write_buffer_size );
+		if( network->_tx_buffer == NULL ) {
+			ts_status_alarm( "ts_transport_set_coalescing: could not allocate transmit buffer\n" );
+			return TsStatusErrorOutOfMemory;
+		}
+		network->_tx_buffer_size = mqtt->_read_write_buffer_size;
+		network->_tx_count = 0;
+	} else if( !enable && network->_tx_buffer != NULL ) {
+		paho_mqtt_flush( network, TS_TIME_SEC_TO_USEC );
+		ts_platform_free( network->_tx_buffer, network->_tx_buffer_size );
+		network->_tx_buffer = NULL;
+		network->_tx_buffer_size = 0;
+		network->_tx_count = 0;
 	}
 
 	return TsStatusOk;
@@ -359,22 +1149,53 @@ int TimerLeftMS( Timer * timer ) {
 	return timer->end_time <= now ? 0 : (int) ( timer->end_time - now )/1000;
 }
 
+/**
+ * Paho reads each packet a few bytes at a time (the header, each length byte, then the rest), so reads
+ * are served from the receive buffer, which is refilled by a single connection read of whatever is
+ * available (i.e., one pass through the security and controller layers for many paho reads).
+ */
 static int paho_mqtt_read( Network * network, unsigned char * buffer, int buffer_size, int budget_ms ) {
 
 	ts_status_trace( "paho_mqtt_read\n" );
 	ts_platform_assert( network != NULL );
 	ts_platform_assert( network->_connection != NULL );
+	ts_platform_assert( network->_rx_buffer != NULL );
 
 	int index = 0;
-	bool reading = true;
+	bool refilled = false;
 
 	// Paho gives us time budgets in milliseconds
 	uint32_t budget = (uint32_t)budget_ms * TS_TIME_MSEC_TO_USEC;
 	uint64_t timestamp = ts_platform_time();
-	do {
-		size_t xbuffer_size = (size_t) ( buffer_size - index );
+	while( true ) {
+		// serve from the receive buffer first
+		if( network->_rx_count > 0 ) {
+			size_t size = (size_t) ( buffer_size - index );
+			if( size > network->_rx_count ) {
+				size = network->_rx_count;
+			}
+			memcpy( buffer + index, network->_rx_buffer + network->_rx_index, size );
+			network->_rx_index = network->_rx_index + size;
+			network->_rx_count = network->_rx_count - size;
+			index = index + (int) size;
+			if( index >= buffer_size ) {
+				break;
+			}
+		}
+		if( refilled && ts_platform_time() - timestamp > budget ) {
+			// ts_status_debug( "paho_mqtt_read: budget exhausted, returning control to caller,...\n" );
+			break;
+		}
+
+		// a response can't arrive before its (merged) request is written
+		if( paho_mqtt_flush( network, budget ) < 0 ) {
+			return -1;
+		}
+
+		// then refill it with whatever the connection has available
+		size_t xbuffer_size = network->_rx_buffer_size;
 		ts_connection_tick(network->_connection, 100 * TS_TIME_MSEC_TO_USEC);
-		TsStatus_t status = ts_connection_read( network->_connection, (uint8_t *) ( buffer + index ), &xbuffer_size, budget );
+		TsStatus_t status = ts_connection_read( network->_connection, network->_rx_buffer, &xbuffer_size, budget );
 		switch( status ) {
 		default:
 			ts_status_debug( "paho_mqtt_read: %s\n", ts_status_string( status ));
@@ -395,29 +1216,69 @@ static int paho_mqtt_read( Network * network, unsigned char * buffer, int buffer
 			break;
 		}
 
-		index = index + (int) xbuffer_size;
-		if( index >= buffer_size ) {
-			reading = false;
-		} else if( ts_platform_time() - timestamp > budget ) {
-			// ts_status_debug( "paho_mqtt_read: budget exhausted, returning control to caller,...\n" );
-			reading = false;
-		}
-
-	} while( reading );
+		network->_rx_index = 0;
+		network->_rx_count = xbuffer_size;
+		refilled = true;
+	}
 	return index;
 }
 
+/**
+ * Write a packet, or merge it into the transmit buffer when write coalescing is enabled. Returning
+ * zero (nothing written) causes paho to retry until its own timeout.
+ */
 static int paho_mqtt_write( Network * network, unsigned char * buffer, int buffer_size, int budget_ms ) {
 
 	ts_status_trace( "paho_mqtt_write\n" );
 	ts_platform_assert( network != NULL );
 	ts_platform_assert( network->_connection != NULL );
 
+	// Paho gives us time budgets in milliseconds
+	uint32_t budget = (uint32_t)budget_ms * TS_TIME_MSEC_TO_USEC;
+	if( network->_tx_buffer == NULL ) {
+		return paho_mqtt_send( network, buffer, buffer_size, budget );
+	}
+
+	// make room, or send packets larger than the buffer as they are
+	if( (size_t) buffer_size > network->_tx_buffer_size - network->_tx_count ) {
+		if( paho_mqtt_flush( network, budget ) < 0 ) {
+			return -1;
+		}
+		if( network->_tx_count > 0 ) {
+			return 0;
+		}
+		if( (size_t) buffer_size > network->_tx_buffer_size ) {
+			return paho_mqtt_send( network, buffer, buffer_size, budget );
+		}
+	}
+	memcpy( network->_tx_buffer + network->_tx_count, buffer, (size_t) buffer_size );
+	network->_tx_count = network->_tx_count + (size_t) buffer_size;
+	return buffer_size;
+}
+
+/**
+ * Write the transmit buffer (if any), keeping whatever the budget didn't allow to be written.
+ */
+static int paho_mqtt_flush( Network * network, uint32_t budget ) {
+
+	if( network->_tx_buffer == NULL || network->_tx_count == 0 ) {
+		return 0;
+	}
+	int sent = paho_mqtt_send( network, network->_tx_buffer, (int) network->_tx_count, budget );
+	if( sent < 0 ) {
+		network->_tx_count = 0;
+		return -1;
+	}
+	memmove( network->_tx_buffer, network->_tx_buffer + sent, network->_tx_count - (size_t) sent );
+	network->_tx_count = network->_tx_count - (size_t) sent;
+	return sent;
+}
+
+static int paho_mqtt_send( Network * network, unsigned char * buffer, int buffer_size, uint32_t budget ) {
+
 	int index = 0;
 	bool writing = true;
 
-	// Paho gives us time budgets in milliseconds
-	uint32_t budget = (uint32_t)budget_ms * TS_TIME_MSEC_TO_USEC;
 	uint64_t timestamp = ts_platform_time();
 	do {
 		size_t xbuffer_size = (size_t) ( buffer_size - index );
@@ -464,19 +1325,163 @@ static void paho_mqtt_disconnect( Network * network ) {
 	// network disconnect?
 }
 
+/**
+ * Match a topic name against a topic filter, i.e., '+' matches exactly one level,
+ * and a trailing '#' matches any number of levels (including the parent level).
+ * Wildcards do not match topics beginning with '$' at the first level.
+ */
+static bool paho_mqtt_matches( const char * filter, const char * topic, size_t topic_size ) {
+
+	if( topic_size > 0 && topic[ 0 ] == '$' && ( filter[ 0 ] == '+' || filter[ 0 ] == '#' )) {
+		return false;
+	}
+
+	size_t index = 0;
+	while( *filter != '\0' ) {
+		if( *filter == '#' ) {
+			return true;
+		}
+		if( *filter == '+' ) {
+			while( index < topic_size && topic[ index ] != '/' ) {
+				index++;
+			}
+			filter++;
+			continue;
+		}
+		if( index >= topic_size ) {
+			// "a/#" also matches "a"
+			return strcmp( filter, "/#" ) == 0;
+		}
+		if( *filter != topic[ index ] ) {
+			return false;
+		}
+		filter++;
+		index++;
+	}
+	return index == topic_size;
+}
+
 static void paho_mqtt_callback( MessageData * data ) {
 
 	ts_status_debug( "paho_mqtt_callback\n" );
 	ts_platform_assert( data != NULL );
-	ts_platform_assert( _default_handler.handler != NULL );
+	ts_platform_assert( data->client != NULL );
+
+	// recover the transport from the embedded client
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) ( (uint8_t *) data->client - offsetof( TsTransportMqtt_t, _client ));
 
 	MQTTMessage * message = data->message;
+	const char * topic = data->topicName->lenstring.data;
+	size_t topic_size = (size_t) data->topicName->lenstring.len;
 	ts_status_debug( "paho_mqtt_callback: %.*s, '%.*s'\n",
-		data->topicName->lenstring.len, data->topicName->lenstring.data,
-		(int) message->payloadlen, (char *) message->payload );
+		(int) topic_size, topic, (int) message->payloadlen, (char *) message->payload );
+
+	// the topic name isn't terminated in the read buffer, pass a terminated copy
+	char path[ TS_TRANSPORT_MQTT_MAX_FILTER_SIZE ];
+	snprintf( path, sizeof( path ), "%.*s", (int) topic_size, topic );
+
+	// deliver to every matching subscription, note that handlers may speak
+	bool delivered = false;
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_HANDLERS; index++ ) {
+		TsTransportMqttSubscription_t * subscription = &( mqtt->_subscriptions[ index ] );
+		if( subscription->_handler != NULL && paho_mqtt_matches( subscription->_filter, topic, topic_size )) {
+			subscription->_handler( (TsTransportRef_t) mqtt, subscription->_data, (TsPath_t) path, message->payload, message->payloadlen );
+			delivered = true;
+		}
+	}
+	if( !delivered ) {
+		ts_status_debug( "paho_mqtt_callback: no subscription for, '%s', ignoring,...\n", path );
+	}
+}
+
+static void paho_mqtt_ack( MQTTClient * client, unsigned short id ) {
+
+	ts_status_debug( "paho_mqtt_ack: %d\n", id );
+	ts_platform_assert( client != NULL );
+
+	// recover the transport from the embedded client
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) ( (uint8_t *) client - offsetof( TsTransportMqtt_t, _client ));
+
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_INFLIGHT; index++ ) {
+		TsTransportMqttInflight_t * entry = &( mqtt->_inflight[ index ] );
+		if( entry->_path != NULL && entry->_id == id ) {
+			if( mqtt->_ack_handler != NULL ) {
+				mqtt->_ack_handler( (TsTransportRef_t) mqtt, mqtt->_ack_data, (TsPath_t) entry->_path, TsStatusOk );
+			}
+			ts_inflight_release( mqtt, entry );
+			return;
+		}
+	}
+	ts_status_debug( "paho_mqtt_ack: unknown message %d, ignoring,...\n", id );
+}
+
+static void paho_mqtt_suback( MQTTClient * client, unsigned short id, int qos ) {
+
+	ts_status_debug( "paho_mqtt_suback: %d, qos %d\n", id, qos );
+	ts_platform_assert( client != NULL );
+
+	// recover the transport from the embedded client
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) ( (uint8_t *) client - offsetof( TsTransportMqtt_t, _client ));
+
+	// a refused subscription is dropped, i.e., its handler would never be called
+	for( int index = 0; index < TS_TRANSPORT_MQTT_MAX_HANDLERS; index++ ) {
+		TsTransportMqttSubscription_t * subscription = &( mqtt->_subscriptions[ index ] );
+		if( subscription->_handler != NULL && subscription->_id == id ) {
+			if( qos == 0x80 ) {
+				ts_status_alarm( "paho_mqtt_suback: subscribe to '%s' refused, dropping\n", subscription->_filter );
+				memset( subscription, 0x00, sizeof( TsTransportMqttSubscription_t ));
+				return;
+			}
+			subscription->_id = 0;
+			return;
+		}
+	}
+	ts_status_debug( "paho_mqtt_suback: unknown subscribe %d, ignoring,...\n", id );
+}
 
-	// NOTE - the transport attribute, "handler" isn't used due to
-	// (poort) paho design, we have to use a local static variable,
-	// i.e., '_default_handler'.
-	_default_handler.handler( _default_handler.transport, _default_handler.data, (TsPath_t) ( data->topicName ), message->payload, message->payloadlen );
+static void paho_mqtt_ping( MQTTClient * client, int sent ) {
+
+	ts_status_debug( "paho_mqtt_ping\n" );
+	ts_platform_assert( client != NULL );
+
+	// recover the transport from the embedded client
+	TsTransportMqttRef_t mqtt = (TsTransportMqttRef_t) ( (uint8_t *) client - offsetof( TsTransportMqtt_t, _client ));
+	uint64_t timestamp = ts_platform_time();
+	if( sent ) {
+		mqtt->_ping_sent = timestamp;
+		return;
+	}
+	if( mqtt->_ping_sent == 0 ) {
+		return;
+	}
+
+	// record the round trip
+	TsTransportKeepAliveStats_t * stats = &( mqtt->_keepalive_stats );
+	stats->rtt = (uint32_t) ( timestamp - mqtt->_ping_sent );
+	if( stats->pings == 0 || stats->rtt < stats->rtt_min ) {
+		stats->rtt_min = stats->rtt;
+	}
+	if( stats->rtt > stats->rtt_max ) {
+		stats->rtt_max = stats->rtt;
+	}
+	stats->pings = stats->pings + 1;
+	mqtt->_rtt_total = mqtt->_rtt_total + stats->rtt;
+	mqtt->_ping_sent = 0;
+
+	// the idle connection survived the interval, probe a longer one
+	if( mqtt->_keepalive_max > 0 && !( stats->converged )) {
+		stats->learned = stats->interval;
+		uint32_t interval = stats->interval + stats->interval / 2 + 1;
+		if( interval >= mqtt->_keepalive_max ) {
+			interval = mqtt->_keepalive_max;
+		}
+		if( interval == stats->learned ) {
+			stats->converged = true;
+		}
+		stats->interval = interval;
+		client->keepAliveInterval = interval;
+		TimerCountdown( &( client->last_sent ), interval );
+		ts_status_debug( "paho_mqtt_ping: keep-alive survived %u seconds, trying %u seconds\n", stats->learned, interval );
+		ts_keepalive_persist( mqtt, true );
+	}
 }
@@ -5,6 +5,26 @@
 #include "ts_connection.h"
 
 #define TS_TRANSPORT_MQTT_MAX_HANDLERS 4
+#define TS_TRANSPORT_MQTT_MAX_FILTER_SIZE 128
+
+// qos1 publish window, i.e., unacknowledged messages in flight
+#define TS_TRANSPORT_MQTT_MAX_INFLIGHT 8
+#define TS_TRANSPORT_MQTT_DEFAULT_WINDOW 4
+#define TS_TRANSPORT_MQTT_RETRANSMIT_TIMEOUT (10 * 1000000)	// microseconds
+#define TS_TRANSPORT_MQTT_MAX_RETRIES 3
+
+// scatter-gather speak, the most segments per message
+#define TS_TRANSPORT_MQTT_MAX_SEGMENTS 8
+
+// automatic reconnect, the jittered backoff doubles from min to max between dial attempts
+#define TS_TRANSPORT_MQTT_MAX_ADDRESS_SIZE ( TS_ADDRESS_MAX_SCHEME_SIZE + TS_ADDRESS_MAX_HOST_SIZE + TS_ADDRESS_MAX_PORT_SIZE + 1 )
+#define TS_TRANSPORT_MQTT_RECONNECT_MIN_BACKOFF (1 * 1000000)		// microseconds
+#define TS_TRANSPORT_MQTT_RECONNECT_MAX_BACKOFF (300 * 1000000)		// microseconds
+
+// keep-alive, the adaptive mode grows the interval by half after each answered ping (up to the maximum).
+// define TS_TRANSPORT_MQTT_KEEPALIVE_FILE as a file name to persist the learned interval via ts_file.
+#define TS_TRANSPORT_MQTT_KEEPALIVE 60					// seconds
+#define TS_TRANSPORT_MQTT_MAX_KEEPALIVE 65535			// seconds, the mqtt limit
 
 typedef struct Timer {
 	uint64_t end_time;
@@ -17,6 +37,18 @@ struct Network {
 	TsConnectionRef_t _connection;
 	TsStatus_t _last_status;
 
+	// receive buffer, filled by one bulk connection read and drained by paho's small reads
+	uint8_t * _rx_buffer;
+	size_t _rx_buffer_size;
+	size_t _rx_index;			// the next buffered byte
+	size_t _rx_count;			// the number of buffered bytes
+
+	// optional transmit buffer, merges packets into one connection write (e.g., one tls record),
+	// flushed on tick, before reading, or when full. NULL when write coalescing is disabled.
+	uint8_t * _tx_buffer;
+	size_t _tx_buffer_size;
+	size_t _tx_count;			// the number of buffered bytes
+
 	int (*mqttread) (Network*, unsigned char*, int, int);
 	int (*mqttwrite) (Network*, unsigned char*, int, int);
 	void (*disconnect) (Network*);
@@ -0,0 +1,462 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#include <stddef.h>
+#include <string.h>
+
+#include "ts_platform.h"
+#include "ts_status.h"
+#include "ts_connection.h"
+#include "ts_transport.h"
+#include "ts_transport_udp.h"
+
+static TsStatus_t ts_create( TsTransportRef_t * );
+static TsStatus_t ts_destroy( TsTransportRef_t );
+static TsStatus_t ts_tick( TsTransportRef_t, uint32_t );
+
+static TsStatus_t ts_get_connection( TsTransportRef_t, TsConnectionRef_t * );
+
+static TsStatus_t ts_dial( TsTransportRef_t, TsAddress_t );
+static TsStatus_t ts_dial_start( TsTransportRef_t, TsAddress_t );
+static TsStatus_t ts_hangup( TsTransportRef_t );
+static TsStatus_t ts_listen( TsTransportRef_t, TsAddress_t, TsPath_t, TsTransportHandler_t, void * );
+static TsStatus_t ts_speak( TsTransportRef_t, TsPath_t, const uint8_t *, size_t );
+static TsStatus_t ts_speak_qos( TsTransportRef_t, TsPath_t, const uint8_t *, size_t, TsTransportQos_t );
+static TsStatus_t ts_speak_vector( TsTransportRef_t, TsPath_t, const TsTransportSegment_t *, size_t, TsTransportQos_t );
+
+// NOTE - datagrams are sent once, i.e., there is no publish window, reconnect, keep-alive
+// or coalescing (one message is one datagram), so those are left unimplemented.
+TsTransportVtable_t ts_transport_udp = {
+
+	.create = ts_create,
+	.destroy = ts_destroy,
+	.tick = ts_tick,
+
+	.get_connection = ts_get_connection,
+
+	.dial = ts_dial,
+	.dial_start = ts_dial_start,
+	.hangup = ts_hangup,
+	.listen = ts_listen,
+	.speak = ts_speak,
+	.speak_qos = ts_speak_qos,
+	.speak_vector = ts_speak_vector,
+	.set_window = NULL,
+	.set_ack_handler = NULL,
+	.set_reconnect = NULL,
+	.get_reconnect_stats = NULL,
+	.set_keepalive = NULL,
+	.get_keepalive_stats = NULL,
+	.set_coalescing = NULL,
+
+};
+
+// a listener, i.e., a path and its handler
+typedef struct TsTransportUdpListener {
+	char _path[ TS_TRANSPORT_UDP_MAX_PATH_SIZE ];
+	TsTransportHandler_t _handler;
+	void * _data;
+} TsTransportUdpListener_t;
+
+typedef struct TsTransportUdp * TsTransportUdpRef_t;
+typedef struct TsTransportUdp {
+
+	// inheritance by encapsulation; must be the first
+	// attribute in order to treat this struct as a
+	// TsTransport struct
+	TsTransport_t _transport;
+
+	// datagram buffers, separate so a handler may speak while its message is dispatched
+	uint8_t * _read_buffer;
+	uint8_t * _write_buffer;
+	size_t _datagram_size;
+
+	// dial state, the security handshake (if any) is advanced by tick
+	bool _dialing;
+	bool _connected;
+
+	// listeners, routed by path
+	TsTransportUdpListener_t _listeners[ TS_TRANSPORT_UDP_MAX_HANDLERS ];
+
+} TsTransportUdp_t;
+
+static void ts_dispatch( TsTransportUdpRef_t, const uint8_t *, size_t );
+
+static TsStatus_t ts_create( TsTransportRef_t * transport ) {
+
+	ts_status_trace( "ts_transport_create: udp\n" );
+	ts_platform_assert( transport != NULL );
+
+	// create related connection
+	TsConnectionRef_t connection;
+	TsStatus_t status = ts_connection_create( &connection );
+	if( status != TsStatusOk ) {
+		*transport = NULL;
+		return status;
+	}
+
+	// create and initialize this transport state
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) ( ts_platform_malloc( sizeof( TsTransportUdp_t )));
+	if( udp == NULL ) {
+		ts_connection_destroy( connection );
+		*transport = NULL;
+		return TsStatusErrorOutOfMemory;
+	}
+	*transport = (TsTransportRef_t) udp;
+
+	udp->_transport._connection = connection;
+	udp->_transport._handler = NULL;
+	udp->_transport._handler_data = NULL;
+
+	// a datagram never exceeds the connection mtu
+	uint32_t mtu = 0;
+	udp->_datagram_size = TS_TRANSPORT_UDP_MAX_DATAGRAM_SIZE;
+	if( ts_connection_get_spec_mtu( connection, &mtu ) == TsStatusOk && mtu > 0 && mtu < udp->_datagram_size ) {
+		udp->_datagram_size = mtu;
+	}
+	udp->_read_buffer = ts_platform_malloc( udp->_datagram_size );
+	udp->_write_buffer = ts_platform_malloc( udp->_datagram_size );
+	if( udp->_read_buffer == NULL || udp->_write_buffer == NULL ) {
+		if( udp->_read_buffer != NULL ) {
+			ts_platform_free( udp->_read_buffer, udp->_datagram_size );
+		}
+		if( udp->_write_buffer != NULL ) {
+			ts_platform_free( udp->_write_buffer, udp->_datagram_size );
+		}
+		ts_connection_destroy( connection );
+		ts_platform_free( udp, sizeof( TsTransportUdp_t ));
+		*transport = NULL;
+		return TsStatusErrorOutOfMemory;
+	}
+
+	udp->_dialing = false;
+	udp->_connected = false;
+	memset( udp->_listeners, 0x00, sizeof( udp->_listeners ));
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_destroy( TsTransportRef_t transport ) {
+
+	ts_status_trace( "ts_transport_destroy\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+
+	ts_connection_destroy( udp->_transport._connection );
+	ts_platform_free( udp->_read_buffer, udp->_datagram_size );
+	ts_platform_free( udp->_write_buffer, udp->_datagram_size );
+	ts_platform_free( udp, sizeof( TsTransportUdp_t ));
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_tick( TsTransportRef_t transport, uint32_t budget ) {
+
+	ts_status_debug( "ts_transport_tick\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+	uint64_t timestamp = ts_platform_time();
+
+	// nothing can be done without a budget, i.e., report the state as is
+	if( budget == 0 ) {
+		if( udp->_dialing ) {
+			return TsStatusOkTrying;
+		}
+		return udp->_connected ? TsStatusOk : TsStatusErrorConnectionReset;
+	}
+
+	// provide connection tick
+	ts_connection_tick( udp->_transport._connection, budget );
+
+	// advance a dial in progress
+	if( udp->_dialing ) {
+		TsStatus_t status = ts_connection_handshake( udp->_transport._connection, budget );
+		if( status == TsStatusOkTrying ) {
+			return status;
+		}
+		udp->_dialing = false;
+		if( status != TsStatusOk ) {
+			ts_status_alarm( "ts_transport_tick: dial failed, %s\n", ts_status_string( status ));
+			return status;
+		}
+		udp->_connected = true;
+	}
+	if( !( udp->_connected )) {
+		ts_status_alarm( "ts_transport_tick: not connected.\n" );
+		return TsStatusErrorConnectionReset;
+	}
+
+	// receive and dispatch datagrams until none are pending, or the budget is spent
+	uint64_t elapsed = ts_platform_time() - timestamp;
+	while( elapsed < budget ) {
+
+		size_t size = udp->_datagram_size;
+		TsStatus_t status = ts_connection_read( udp->_transport._connection, udp->_read_buffer, &size, (uint32_t)( budget - elapsed ));
+		if( status == TsStatusOkReadPending ) {
+			break;
+		}
+		if( status != TsStatusOk ) {
+			ts_status_alarm( "ts_transport_tick: read failed, %s\n", ts_status_string( status ));
+			udp->_connected = false;
+			return status;
+		}
+		if( size == 0 ) {
+			break;
+		}
+		ts_dispatch( udp, udp->_read_buffer, size );
+		elapsed = ts_platform_time() - timestamp;
+	}
+
+	// report budget status and return
+	timestamp = ts_platform_time() - timestamp;
+	if( timestamp > budget + TS_TIME_MSEC_TO_USEC ) {
+		ts_status_alarm( "ts_transport_tick: exceeded time budget, %d msec\n", timestamp/TS_TIME_MSEC_TO_USEC );
+	}
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_get_connection( TsTransportRef_t transport, TsConnectionRef_t * connection ) {
+
+	ts_status_trace( "ts_transport_get_connection\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( connection != NULL );
+
+	*connection = transport->_connection;
+
+	return TsStatusOk;
+}
+
+/**
+ * Dial "connects" the datagram socket (i.e., sets the peer address) and makes the security
+ * handshake (if any), e.g., dtls. The address is given the "udp://" scheme when it has none.
+ * @param transport
+ * @param address
+ * @return
+ */
+static TsStatus_t ts_dial( TsTransportRef_t transport, TsAddress_t address ) {
+
+	ts_status_trace( "ts_transport_dial\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+
+	// advance the handshake until connected, the handshake gives up on its own timeout
+	TsStatus_t status = ts_dial_start( transport, address );
+	while( status == TsStatusOkTrying ) {
+		status = ts_connection_handshake( udp->_transport._connection, TS_TIME_SEC_TO_USEC );
+	}
+	udp->_dialing = false;
+	udp->_connected = ( status == TsStatusOk );
+	return status;
+}
+
+/**
+ * Dial without blocking for the security handshake, see ts_tick.
+ * @param transport
+ * @param address
+ * @return
+ */
+static TsStatus_t ts_dial_start( TsTransportRef_t transport, TsAddress_t address ) {
+
+	ts_status_trace( "ts_transport_dial_start\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( address != NULL );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+
+	if( udp->_connected || udp->_dialing ) {
+		ts_status_debug( "ts_transport_dial: failed, udp already connected\n" );
+		return TsStatusErrorPreconditionFailed;
+	}
+	if( strlen( address ) + strlen( TS_ADDRESS_DATAGRAM_SCHEME ) >= TS_TRANSPORT_UDP_MAX_ADDRESS_SIZE ) {
+		ts_status_debug( "ts_transport_dial: failed, address too long\n" );
+		return TsStatusErrorPreconditionFailed;
+	}
+
+	char datagram_address[ TS_TRANSPORT_UDP_MAX_ADDRESS_SIZE ];
+	if( !ts_address_is_datagram( address )) {
+		snprintf( datagram_address, sizeof( datagram_address ), "%s%s", TS_ADDRESS_DATAGRAM_SCHEME, address );
+		address = datagram_address;
+	}
+
+	ts_status_debug( "ts_transport_dial: connecting to, '%s'\n", address );
+	TsStatus_t status = ts_connection_connect_start( udp->_transport._connection, address );
+	if( status == TsStatusOk ) {
+		udp->_connected = true;
+	} else if( status == TsStatusOkTrying ) {
+		udp->_dialing = true;
+	} else {
+		ts_status_debug( "ts_transport_dial: connect failed\n" );
+	}
+	return status;
+}
+
+static TsStatus_t ts_hangup( TsTransportRef_t transport ) {
+
+	ts_status_trace( "ts_transport_hangup\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+
+	if( udp->_connected || udp->_dialing ) {
+		ts_connection_disconnect( udp->_transport._connection );
+	}
+	udp->_dialing = false;
+	udp->_connected = false;
+
+	return TsStatusOk;
+}
+
+/**
+ * Listen delivers the datagrams sent to the given path to the given handler. The address parameter
+ * is ignored (the peer is the dialed address). Listen may be called for up to TS_TRANSPORT_UDP_MAX_HANDLERS
+ * paths, each with its own handler; paths are matched exactly. Listening to a path already listened to
+ * replaces its handler.
+ * @param transport
+ * @param address
+ * Ignored, NULL is a valid value.
+ * @param path
+ * @param handler
+ * @return
+ */
+static TsStatus_t ts_listen( TsTransportRef_t transport, TsAddress_t address, TsPath_t path, TsTransportHandler_t handler, void * handler_data ) {
+
+	ts_status_debug( "ts_transport_listen\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( path != NULL );
+	ts_platform_assert( handler != NULL );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+
+	if( strlen( path ) >= TS_TRANSPORT_UDP_MAX_PATH_SIZE ) {
+		ts_status_debug( "ts_transport_listen: failed, path too long, '%s'\n", path );
+		return TsStatusErrorPayloadTooLarge;
+	}
+
+	// find the existing listener, or else an unused one
+	TsTransportUdpListener_t * listener = NULL;
+	for( int index = 0; index < TS_TRANSPORT_UDP_MAX_HANDLERS; index++ ) {
+		TsTransportUdpListener_t * candidate = &( udp->_listeners[ index ] );
+		if( candidate->_handler != NULL && strcmp( candidate->_path, path ) == 0 ) {
+			listener = candidate;
+			break;
+		}
+		if( candidate->_handler == NULL && listener == NULL ) {
+			listener = candidate;
+		}
+	}
+	if( listener == NULL ) {
+		ts_status_debug( "ts_transport_listen: failed, no more listeners available\n" );
+		return TsStatusErrorNoResourceAvailable;
+	}
+
+	snprintf( listener->_path, TS_TRANSPORT_UDP_MAX_PATH_SIZE, "%s", path );
+	listener->_handler = handler;
+	listener->_data = handler_data;
+
+	return TsStatusOk;
+}
+
+static TsStatus_t ts_speak( TsTransportRef_t transport, TsPath_t path, const uint8_t * buffer, size_t buffer_size ) {
+
+	ts_status_trace( "ts_transport_speak\n" );
+	ts_platform_assert( transport != NULL );
+
+	return ts_speak_qos( transport, path, buffer, buffer_size, TsTransportQos0 );
+}
+
+static TsStatus_t ts_speak_qos( TsTransportRef_t transport, TsPath_t path, const uint8_t * buffer, size_t buffer_size, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_transport_speak_qos\n" );
+	ts_platform_assert( transport != NULL );
+
+	TsTransportSegment_t segment;
+	segment.buffer = buffer;
+	segment.buffer_size = buffer_size;
+	return ts_speak_vector( transport, path, &segment, 1, qos );
+}
+
+/**
+ * Send the segments as one datagram. Datagrams are sent at most once, i.e., qos1 is delivered as qos0.
+ * @param transport
+ * @param path
+ * @param segments
+ * @param count
+ * @param qos
+ * @return
+ */
+static TsStatus_t ts_speak_vector( TsTransportRef_t transport, TsPath_t path, const TsTransportSegment_t * segments, size_t count, TsTransportQos_t qos ) {
+
+	ts_status_trace( "ts_transport_speak_vector\n" );
+	ts_platform_assert( transport != NULL );
+	ts_platform_assert( path != NULL );
+	ts_platform_assert( segments != NULL || count == 0 );
+
+	TsTransportUdpRef_t udp = (TsTransportUdpRef_t) transport;
+
+	if( !( udp->_connected )) {
+		ts_status_debug( "ts_transport_speak: failed, udp not connected\n" );
+		return TsStatusErrorPreconditionFailed;
+	}
+	if( qos != TsTransportQos0 ) {
+		ts_status_debug( "ts_transport_speak: qos%d sent at most once\n", qos );
+	}
+
+	// gather the header, path and segments into one datagram
+	size_t path_size = strlen( path );
+	if( path_size >= TS_TRANSPORT_UDP_MAX_PATH_SIZE ) {
+		ts_status_debug( "ts_transport_speak: failed, path too long, '%s'\n", path );
+		return TsStatusErrorPayloadTooLarge;
+	}
+	size_t size = TS_TRANSPORT_UDP_HEADER_SIZE + path_size;
+	for( size_t index = 0; index < count; index++ ) {
+		size = size + segments[ index ].buffer_size;
+	}
+	if( size > udp->_datagram_size ) {
+		ts_status_debug( "ts_transport_speak: failed, %d bytes exceed the datagram size\n", size );
+		return TsStatusErrorPayloadTooLarge;
+	}
+	uint8_t * datagram = udp->_write_buffer;
+	datagram[ 0 ] = (uint8_t) path_size;
+	memcpy( datagram + TS_TRANSPORT_UDP_HEADER_SIZE, path, path_size );
+	size_t offset = TS_TRANSPORT_UDP_HEADER_SIZE + path_size;
+	for( size_t index = 0; index < count; index++ ) {
+		memcpy( datagram + offset, segments[ index ].buffer, segments[ index ].buffer_size );
+		offset = offset + segments[ index ].buffer_size;
+	}
+
+	// a datagram is written whole, or not at all
+	size_t written = size;
+	TsStatus_t status = ts_connection_write( udp->_transport._connection, datagram, &written, TS_TIME_SEC_TO_USEC );
+	if( status == TsStatusOk && written != size ) {
+		ts_status_alarm( "ts_transport_speak: datagram truncated, %d of %d bytes\n", written, size );
+		return TsStatusErrorInternalServerError;
+	}
+	return status;
+}
+
+/**
+ * Route a received datagram to the listener of its path (if any).
+ */
+static void ts_dispatch( TsTransportUdpRef_t udp, const uint8_t * datagram, size_t size ) {
+
+	size_t path_size = datagram[ 0 ];
+	if( TS_TRANSPORT_UDP_HEADER_SIZE + path_size > size || path_size >= TS_TRANSPORT_UDP_MAX_PATH_SIZE ) {
+		ts_status_debug( "ts_transport_tick: malformed datagram, %d bytes, ignoring\n", size );
+		return;
+	}
+	char path[ TS_TRANSPORT_UDP_MAX_PATH_SIZE ];
+	memcpy( path, datagram + TS_TRANSPORT_UDP_HEADER_SIZE, path_size );
+	path[ path_size ] = 0x00;
+
+	for( int index = 0; index < TS_TRANSPORT_UDP_MAX_HANDLERS; index++ ) {
+		TsTransportUdpListener_t * listener = &( udp->_listeners[ index ] );
+		if( listener->_handler != NULL && strcmp( listener->_path, path ) == 0 ) {
+			size_t offset = TS_TRANSPORT_UDP_HEADER_SIZE + path_size;
+			listener->_handler( (TsTransportRef_t) udp, listener->_data, (TsPath_t) path, datagram + offset, size - offset );
+			return;
+		}
+	}
+	ts_status_debug( "ts_transport_tick: no listener for, '%s', ignoring\n", path );
+}
@@ -0,0 +1,18 @@
+// Copyright (C) 2017, 2018 Verizon, Inc. All rights reserved.
+#ifndef TS_TRANSPORT_UDP_H
+#define TS_TRANSPORT_UDP_H
+
+#include "ts_connection.h"
+
+// each message is one datagram, [path size (one byte)] [path] [payload], i.e., the
+// ts-cbor envelope is carried as the payload without a broker protocol around it
+#define TS_TRANSPORT_UDP_MAX_HANDLERS 4
+#define TS_TRANSPORT_UDP_MAX_PATH_SIZE 128
+#define TS_TRANSPORT_UDP_HEADER_SIZE 1
+
+// the largest datagram, i.e., within the minimum ipv6 mtu once the (d)tls record and udp/ip headers are added
+#define TS_TRANSPORT_UDP_MAX_DATAGRAM_SIZE 1152
+
+#define TS_TRANSPORT_UDP_MAX_ADDRESS_SIZE ( TS_ADDRESS_MAX_SCHEME_SIZE + TS_ADDRESS_MAX_HOST_SIZE + TS_ADDRESS_MAX_PORT_SIZE + 1 )
+
+#endif // TS_TRANSPORT_UDP_H
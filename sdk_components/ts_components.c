@@ -15,15 +15,21 @@ const TsServiceVtable_t *   ts_service = &(ts_service_ts_cbor);
 // application protocol transport binding
 #if defined(TS_TRANSPORT_MQTT)
 const TsTransportVtable_t * ts_transport = &(ts_transport_mqtt);
+#elif defined(TS_TRANSPORT_UDP)
+const TsTransportVtable_t * ts_transport = &(ts_transport_udp);
 #elif defined(TS_TRANSPORT_CUSTOM)
 // do nothing
 #else
-#warning "TS_TRANSPORT_<TYPE> not defined, options include MQTT or CUSTOM"
+#warning "TS_TRANSPORT_<TYPE> not defined, options include MQTT, UDP or CUSTOM"
 #endif
 
 // connection security binding
 #if defined(TS_SECURITY_MBED)
 const TsSecurityVtable_t *  ts_security = &(ts_security_mbedtls);
+#elif defined(TS_SECURITY_MBED_PSK)
+const TsSecurityVtable_t *  ts_security = &(ts_security_mbedtls_psk);
+#elif defined(TS_SECURITY_MBED_DTLS)
+const TsSecurityVtable_t *  ts_security = &(ts_security_mbedtls_dtls);
 #elif defined(TS_SECURITY_MOCANA)
 const TsSecurityVtable_t *  ts_security = &(ts_security_mocana);
 #elif defined(TS_SECURITY_NONE)
@@ -31,7 +37,7 @@ const TsSecurityVtable_t *  ts_security = &(ts_security_none);
 #elif defined(TS_SECURITY_CUSTOM)
 // do nothing
 #else
-#warning "TS_SECURITY_<TYPE> not defined, options include NONE, MBED, MOCANA or CUSTOM"
+#warning "TS_SECURITY_<TYPE> not defined, options include NONE, MBED, MBED_PSK, MBED_DTLS, MOCANA or CUSTOM"
 #endif
 
 // connection controller binding
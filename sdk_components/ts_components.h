@@ -15,11 +15,14 @@ extern TsServiceVtable_t    ts_service_ts_cbor;
 extern TsServiceVtable_t    ts_service_ts_json;
 
 extern TsTransportVtable_t  ts_transport_mqtt;
+extern TsTransportVtable_t  ts_transport_udp;
 
 extern TsControllerVtable_t ts_controller_monarch;
 extern TsControllerVtable_t ts_controller_none;
 
 extern TsSecurityVtable_t   ts_security_mbedtls;
+extern TsSecurityVtable_t   ts_security_mbedtls_psk;
+extern TsSecurityVtable_t   ts_security_mbedtls_dtls;
 extern TsSecurityVtable_t   ts_security_mocana;
 extern TsSecurityVtable_t   ts_security_none;
 
@@ -17,9 +17,12 @@
  *******************************************************************************/
 #include "MQTTClient.h"
 
-static void NewMessageData(MessageData* md, MQTTString* aTopicName, MQTTMessage* aMessage) {
+#include <string.h>
+
+static void NewMessageData(MessageData* md, MQTTClient* aClient, MQTTString* aTopicName, MQTTMessage* aMessage) {
     md->topicName = aTopicName;
     md->message = aMessage;
+    md->client = aClient;
 }
 
 
@@ -51,6 +54,23 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
 }
 
 
+/* ThingSpace Modification: write the given buffer (rather than the client buffer) */
+static int sendBuffer(MQTTClient* c, const unsigned char* buf, int length, Timer* timer)
+{
+    int rc = FAILURE,
+        sent = 0;
+
+    while (sent < length && !TimerIsExpired(timer))
+    {
+        rc = c->ipstack->mqttwrite(c->ipstack, (unsigned char*)&buf[sent], length - sent, TimerLeftMS(timer));
+        if (rc < 0)  // there was an error writing the data
+            break;
+        sent += rc;
+    }
+    return (sent == length) ? SUCCESS : FAILURE;
+}
+
+
 void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeout_ms,
 		unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size)
 {
@@ -68,6 +88,10 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
     c->cleansession = 0;
     c->ping_outstanding = 0;
     c->defaultMessageHandler = NULL;
+    c->publishAckHandler = NULL;
+    c->subscribeAckHandler = NULL;
+    c->pingHandler = NULL;
+    c->keepAliveSendOnly = 0;
 	  c->next_packetid = 1;
     TimerInit(&c->last_sent);
     TimerInit(&c->last_received);
@@ -187,7 +211,7 @@ int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
             if (c->messageHandlers[i].fp != NULL)
             {
                 MessageData md;
-                NewMessageData(&md, topicName, message);
+                NewMessageData(&md, c, topicName, message);
                 c->messageHandlers[i].fp(&md);
                 rc = SUCCESS;
             }
@@ -197,7 +221,7 @@ int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
     if (rc == FAILURE && c->defaultMessageHandler != NULL)
     {
         MessageData md;
-        NewMessageData(&md, topicName, message);
+        NewMessageData(&md, c, topicName, message);
         c->defaultMessageHandler(&md);
         rc = SUCCESS;
     }
@@ -213,7 +237,8 @@ int keepalive(MQTTClient* c)
     if (c->keepAliveInterval == 0)
         goto exit;
 
-    if (TimerIsExpired(&c->last_sent) || TimerIsExpired(&c->last_received))
+    /* ThingSpace Modification: optionally, only outgoing traffic defers the ping */
+    if (TimerIsExpired(&c->last_sent) || (!c->keepAliveSendOnly && TimerIsExpired(&c->last_received)))
     {
         if (c->ping_outstanding)
             rc = FAILURE; /* PINGRESP not received in keepalive interval */
@@ -224,7 +249,11 @@ int keepalive(MQTTClient* c)
             TimerCountdownMS(&timer, 1000);
             int len = MQTTSerialize_pingreq(c->buf, c->buf_size);
             if (len > 0 && (rc = sendPacket(c, len, &timer)) == SUCCESS) // send the ping packet
+            {
                 c->ping_outstanding = 1;
+                if (c->pingHandler != NULL) /* ThingSpace Modification: report the ping */
+                    c->pingHandler(c, 1);
+            }
         }
     }
 
@@ -267,10 +296,28 @@ int cycle(MQTTClient* c, Timer* timer)
         case 0: /* timed out reading packet */
             break;
         case CONNACK:
-        case PUBACK:
-        case SUBACK:
         case UNSUBACK:
             break;
+        case SUBACK:
+        {
+            /* ThingSpace Modification: report the acknowledged packet id and granted qos */
+            unsigned short mypacketid;
+            int count = 0, grantedQoS = 0;
+            if (c->subscribeAckHandler != NULL &&
+                MQTTDeserialize_suback(&mypacketid, 1, &count, &grantedQoS, c->readbuf, c->readbuf_size) == 1)
+                c->subscribeAckHandler(c, mypacketid, grantedQoS);
+            break;
+        }
+        case PUBACK:
+        {
+            /* ThingSpace Modification: report the acknowledged packet id */
+            unsigned short mypacketid;
+            unsigned char dup, type;
+            if (c->publishAckHandler != NULL &&
+                MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) == 1)
+                c->publishAckHandler(c, mypacketid);
+            break;
+        }
         case PUBLISH:
         {
             MQTTString topicName;
@@ -318,6 +365,8 @@ int cycle(MQTTClient* c, Timer* timer)
             break;
         case PINGRESP:
             c->ping_outstanding = 0;
+            if (c->pingHandler != NULL) /* ThingSpace Modification: report the ping response */
+                c->pingHandler(c, 0);
             break;
     }
 
@@ -465,6 +514,89 @@ int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
 }
 
 
+/* ThingSpace Modification: connect without waiting for the connack, see MQTTConnectPoll */
+int MQTTConnectAsync(MQTTClient* c, MQTTPacket_connectData* options)
+{
+    Timer connect_timer;
+    int rc = FAILURE;
+    MQTTPacket_connectData default_options = MQTTPacket_connectData_initializer;
+    int len = 0;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+	  if (c->isconnected) /* don't send connect packet again if we are already connected */
+		  goto exit;
+
+    TimerInit(&connect_timer);
+    TimerCountdownMS(&connect_timer, c->command_timeout_ms);
+
+    if (options == 0)
+        options = &default_options; /* set default options if none were supplied */
+
+    c->keepAliveInterval = options->keepAliveInterval;
+    c->cleansession = options->cleansession;
+    TimerCountdown(&c->last_received, c->keepAliveInterval);
+    if ((len = MQTTSerialize_connect(c->buf, c->buf_size, options)) <= 0)
+        goto exit;
+    rc = sendPacket(c, len, &connect_timer);  // send the connect packet
+
+exit:
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+
+    return rc;
+}
+
+
+/* ThingSpace Modification: wait (at most timeout_ms) for the connack of MQTTConnectAsync */
+int MQTTConnectPoll(MQTTClient* c, int timeout_ms, MQTTConnackData* data)
+{
+    Timer timer;
+    int rc = SUCCESS;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+    if (c->isconnected)
+        goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, timeout_ms);
+    do
+    {
+        int packet_type = readPacket(c, &timer);
+        if (packet_type == CONNACK)
+        {
+            data->rc = 0;
+            data->sessionPresent = 0;
+            if (MQTTDeserialize_connack(&data->sessionPresent, &data->rc, c->readbuf, c->readbuf_size) == 1 && data->rc == 0)
+            {
+                c->isconnected = 1;
+                c->ping_outstanding = 0;
+            }
+            else
+                rc = FAILURE;
+            break;
+        }
+        else if (packet_type < 0)
+        {
+            rc = FAILURE;
+            break;
+        }
+        /* nothing else is expected before the connack, i.e., ignore it */
+    } while (!TimerIsExpired(&timer));
+
+exit:
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+
+    return rc;
+}
+
+
 int MQTTSetMessageHandler(MQTTClient* c, const char* topicFilter, messageHandler messageHandler)
 {
     int rc = FAILURE;
@@ -555,6 +687,40 @@ exit:
 }
 
 
+/* ThingSpace Modification: send the subscribe, the suback is reported by cycle */
+int MQTTSubscribeAsync(MQTTClient* c, const char* topicFilter, enum QoS qos, unsigned short* id)
+{
+    int rc = FAILURE;
+    Timer timer;
+    int len = 0;
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = (char *)topicFilter;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+	  if (!c->isconnected)
+		    goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    *id = getNextPacketId(c);
+    len = MQTTSerialize_subscribe(c->buf, c->buf_size, 0, *id, 1, &topic, (int*)&qos);
+    if (len <= 0)
+        goto exit;
+    rc = sendPacket(c, len, &timer);
+
+exit:
+    if (rc == FAILURE && len > 0)
+        MQTTCloseSession(c);
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
 int MQTTSubscribe(MQTTClient* c, const char* topicFilter, enum QoS qos,
        messageHandler messageHandler)
 {
@@ -669,6 +835,101 @@ exit:
 }
 
 
+/* ThingSpace Modification: publish without waiting for the acknowledgement */
+int MQTTPublishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message)
+{
+    int rc = FAILURE;
+    Timer timer;
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = (char *)topicName;
+    int len = 0;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+	  if (!c->isconnected)
+		    goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    if ((message->qos == QOS1 || message->qos == QOS2) && !message->dup)
+        message->id = getNextPacketId(c);
+
+    len = MQTTSerialize_publish(c->buf, c->buf_size, message->dup, message->qos, message->retained, message->id,
+              topic, (unsigned char*)message->payload, message->payloadlen);
+    if (len <= 0)
+        goto exit;
+    rc = sendPacket(c, len, &timer);
+
+exit:
+    if (rc == FAILURE && len > 0)
+        MQTTCloseSession(c);
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
+/* ThingSpace Modification: publish the payload segments without copying them to the client buffer */
+int MQTTPublishVectorAsync(MQTTClient* c, const char* topicName, MQTTMessage* message, const MQTTVector* segments, int count)
+{
+    int rc = FAILURE;
+    Timer timer;
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = (char *)topicName;
+    int len = 0;
+    int i;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+	  if (!c->isconnected)
+		    goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    if ((message->qos == QOS1 || message->qos == QOS2) && !message->dup)
+        message->id = getNextPacketId(c);
+
+    message->payloadlen = 0;
+    for (i = 0; i < count; ++i)
+        message->payloadlen += segments[i].len;
+
+    len = MQTTSerialize_publishHeader(c->buf, c->buf_size, message->dup, message->qos, message->retained, message->id,
+              topic, (int)message->payloadlen);
+    if (len <= 0)
+        goto exit;
+
+    /* gather the segments behind the header so that the packet is one network write (e.g., one tls
+       record, or one modem socket send), only a packet larger than the client buffer is written by segment */
+    if ((size_t)len + message->payloadlen <= c->buf_size)
+    {
+        for (i = 0; i < count; ++i)
+        {
+            memcpy(&c->buf[len], segments[i].data, segments[i].len);
+            len += (int)segments[i].len;
+        }
+        count = 0;
+    }
+    rc = sendBuffer(c, c->buf, len, &timer);
+    for (i = 0; i < count && rc == SUCCESS; ++i)
+        rc = sendBuffer(c, (const unsigned char*)segments[i].data, (int)segments[i].len, &timer);
+    if (rc == SUCCESS)
+        TimerCountdown(&c->last_sent, c->keepAliveInterval); // record the fact that we have successfully sent the packet
+
+exit:
+    if (rc == FAILURE && len > 0)
+        MQTTCloseSession(c);
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
 int MQTTDisconnect(MQTTClient* c)
 {
     int rc = FAILURE;
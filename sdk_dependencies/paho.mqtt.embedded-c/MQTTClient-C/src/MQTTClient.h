@@ -84,12 +84,26 @@ typedef struct MQTTMessage
     size_t payloadlen;
 } MQTTMessage;
 
+/* ThingSpace Modification:
+ * The receiving client was added to the message data so that a message handler
+ * can recover its own state (e.g., the owning transport) without a global.
+ */
 typedef struct MessageData
 {
     MQTTMessage* message;
     MQTTString* topicName;
+    struct MQTTClient* client;
 } MessageData;
 
+/* ThingSpace Modification:
+ * A payload segment, see MQTTPublishVectorAsync.
+ */
+typedef struct MQTTVector
+{
+    const void* data;
+    size_t len;
+} MQTTVector;
+
 typedef struct MQTTConnackData
 {
     unsigned char rc;
@@ -124,6 +138,28 @@ typedef struct MQTTClient
 
     void (*defaultMessageHandler) (MessageData*);
 
+    /* ThingSpace Modification:
+     * An acknowledgement handler was added so that the caller can track QoS1 publishes
+     * sent with MQTTPublishAsync, i.e., it is called with the packet id of each PUBACK.
+     */
+    void (*publishAckHandler) (struct MQTTClient*, unsigned short);
+
+    /* ThingSpace Modification:
+     * A subscribe acknowledgement handler was added so that the caller can track subscriptions sent
+     * with MQTTSubscribeAsync, i.e., it is called with the packet id and granted QoS of each SUBACK
+     * (0x80 when the subscription was refused).
+     */
+    void (*subscribeAckHandler) (struct MQTTClient*, unsigned short, int);
+
+    /* ThingSpace Modification:
+     * A ping handler was added so that the caller can measure the ping round trip, i.e., it is called
+     * with sent=1 when a PINGREQ is sent, and sent=0 when the PINGRESP is received. And, when
+     * keepAliveSendOnly is set, a PINGREQ is sent only when nothing else was sent within the keep-alive
+     * interval (i.e., received traffic alone doesn't cause a ping).
+     */
+    void (*pingHandler) (struct MQTTClient*, int sent);
+    int keepAliveSendOnly;
+
     Network* ipstack;
     Timer last_sent, last_received;
 #if defined(MQTT_TASK)
@@ -160,6 +196,25 @@ DLLExport int MQTTConnectWithResults(MQTTClient* client, MQTTPacket_connectData*
  */
 DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
 
+/* ThingSpace Modification:
+ * MQTT Connect Async - send an MQTT connect packet without waiting for the Connack, which is
+ * then received by MQTTConnectPoll. The nework object must be connected to the network endpoint
+ * before calling this.
+ *  @param options - connect options
+ *  @return success code
+ */
+DLLExport int MQTTConnectAsync(MQTTClient* client, MQTTPacket_connectData* options);
+
+/* ThingSpace Modification:
+ * MQTT Connect Poll - wait at most timeout_ms for the Connack of MQTTConnectAsync. The client is
+ * connected (see isconnected) once the Connack has been accepted.
+ *  @param client - the client object to use
+ *  @param timeout_ms - the time, in milliseconds, to wait for
+ *  @param data - connack return code, set when the Connack was received
+ *  @return success code, failure if the connection was refused or the network failed
+ */
+DLLExport int MQTTConnectPoll(MQTTClient* client, int timeout_ms, MQTTConnackData* data);
+
 /** MQTT Publish - send an MQTT publish packet and wait for all acks to complete for all QoSs
  *  @param client - the client object to use
  *  @param topic - the topic to publish to
@@ -168,6 +223,33 @@ DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
  */
 DLLExport int MQTTPublish(MQTTClient* client, const char*, MQTTMessage*);
 
+/* ThingSpace Modification:
+ * MQTT Publish Async - send an MQTT publish packet without waiting for the acknowledgement,
+ * which is delivered to the client publishAckHandler (if any) from MQTTYield. A new packet id
+ * is assigned to QoS1/2 messages, unless the message is a retransmission (dup is set), in which
+ * case the id is kept.
+ *  @param client - the client object to use
+ *  @param topic - the topic to publish to
+ *  @param message - the message to send, the assigned packet id is returned in message->id
+ *  @return success code
+ */
+DLLExport int MQTTPublishAsync(MQTTClient* client, const char*, MQTTMessage*);
+
+/* ThingSpace Modification:
+ * MQTT Publish Vector Async - send an MQTT publish packet as MQTTPublishAsync does, with the payload
+ * gathered from the given segments rather than message->payload. The segments are gathered behind the
+ * packet header in the client buffer, so that the packet is a single network write. A packet larger
+ * than the client buffer is written header first, then by segment (i.e., without a copy), so the
+ * payload isn't limited by the buffer size.
+ *  @param client - the client object to use
+ *  @param topic - the topic to publish to
+ *  @param message - the message to send, payloadlen is set to the total segment length
+ *  @param segments - the payload segments, in order
+ *  @param count - the number of segments
+ *  @return success code
+ */
+DLLExport int MQTTPublishVectorAsync(MQTTClient* client, const char*, MQTTMessage*, const MQTTVector*, int);
+
 /** MQTT SetMessageHandler - set or remove a per topic message handler
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter set the message handler for
@@ -193,6 +275,18 @@ DLLExport int MQTTSubscribe(MQTTClient* client, const char* topicFilter, enum Qo
  */
 DLLExport int MQTTSubscribeWithResults(MQTTClient* client, const char* topicFilter, enum QoS, messageHandler, MQTTSubackData* data);
 
+/* ThingSpace Modification:
+ * MQTT Subscribe Async - send an MQTT subscribe packet without waiting for the suback, which is
+ * delivered to the client subscribeAckHandler (if any) from MQTTYield. No message handler is set,
+ * i.e., messages are delivered to the default message handler.
+ *  @param client - the client object to use
+ *  @param topicFilter - the topic filter to subscribe to
+ *  @param qos - the requested QoS
+ *  @param id - the assigned packet id is returned here
+ *  @return success code
+ */
+DLLExport int MQTTSubscribeAsync(MQTTClient* client, const char* topicFilter, enum QoS, unsigned short* id);
+
 /** MQTT Subscribe - send an MQTT unsubscribe packet and wait for unsuback before returning.
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter to unsubscribe from